@@ -0,0 +1,293 @@
+// Cost per stream of BatchEngine against a ChannelBank per stream, the lightest way to
+// run one processor for each. Streams cycle through every Type and Brightness with
+// different Process amounts, so each Type's group holds a fifth of them.
+//
+//   TonixBatchBenchmark [--streams N] [--block N] [--seconds S] [--precision double|float]
+//                       [--check]
+//
+// --check compares the output of both over a few blocks, with streams changing Type
+// and being replaced in between. It has to match bit for bit.
+
+#include "DSP/BatchEngine.h"
+#include "DSP/ChannelBank.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace tonix;
+
+namespace
+{
+    struct Options
+    {
+        int maxStreams { 1024 };
+        int blockSize { 256 };
+        double seconds { 0.25 };
+        double sampleRate { 48000.0 };
+        Precision precision { Precision::Double };
+        bool check { false };
+    };
+
+    constexpr auto kUsage = "usage: TonixBatchBenchmark [--streams N] [--block N] [--seconds S] [--precision double|float] [--check]\n";
+
+    // the whole argument within [min, max] or nothing, a typo mustn't turn into a value
+    bool parseNumber (const char* text, double min, double max, double& value)
+    {
+        char* end = nullptr;
+        value = std::strtod (text, &end);
+        return end != text && *end == '\0' && value >= min && value <= max;
+    }
+
+    bool parseInteger (const char* text, int min, int max, int& value)
+    {
+        double number;
+        if (! parseNumber (text, min, max, number) || number != std::floor (number))
+            return false;
+        value = static_cast<int> (number);
+        return true;
+    }
+
+    // false after saying what is wrong; --check must not pass on settings it wasn't given
+    bool parseOptions (int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const auto* name = argv[i];
+            const auto isOption = [name] (const char* option)
+            {
+                return std::strcmp (name, option) == 0;
+            };
+            if (isOption ("--check"))
+            {
+                options.check = true;
+                continue;
+            }
+            if (! (isOption ("--streams") || isOption ("--block") || isOption ("--seconds") || isOption ("--precision")))
+            {
+                std::fprintf (stderr, "unknown option %s\n%s", name, kUsage);
+                return false;
+            }
+            if (i + 1 >= argc)
+            {
+                std::fprintf (stderr, "missing value for %s\n%s", name, kUsage);
+                return false;
+            }
+            const auto* text = argv[++i];
+            bool valid = true;
+            if (isOption ("--streams"))
+                valid = parseInteger (text, 1, 1 << 20, options.maxStreams);
+            else if (isOption ("--block"))
+                valid = parseInteger (text, 1, 1 << 16, options.blockSize);
+            else if (isOption ("--seconds"))
+                valid = parseNumber (text, 0.01, 3600.0, options.seconds);
+            else
+            {
+                valid = std::strcmp (text, "double") == 0 || std::strcmp (text, "float") == 0;
+                options.precision = std::strcmp (text, "float") == 0 ? Precision::Float : Precision::Double;
+            }
+            if (! valid)
+            {
+                std::fprintf (stderr, "bad value %s for %s\n%s", text, name, kUsage);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    struct StreamSettings
+    {
+        Type type;
+        Brightness brightness;
+        double processing;
+    };
+
+    StreamSettings getSettings (int stream)
+    {
+        return { static_cast<Type> (stream % static_cast<int> (kNumTypes)),
+                 static_cast<Brightness> ((stream / static_cast<int> (kNumTypes)) % static_cast<int> (kNumBrightness)),
+                 0.1 + 0.8 * static_cast<double> (stream % 7) / 6.0 };
+    }
+
+    // -12 dBFS, different for each stream
+    std::vector<std::vector<float>> makeInput (int numStreams, int numSamples)
+    {
+        std::vector<std::vector<float>> buffers (static_cast<size_t> (numStreams), std::vector<float> (static_cast<size_t> (numSamples)));
+        for (size_t s = 0; s < buffers.size(); ++s)
+            for (size_t i = 0; i < buffers[s].size(); ++i)
+                buffers[s][i] = static_cast<float> (0.25 * (std::sin (0.031 * (double) i + (double) s) + std::sin ((0.05 + 0.002 * (double) s) * (double) i)));
+        return buffers;
+    }
+
+    BatchEngine makeBatch (int numStreams, const Options& options)
+    {
+        BatchEngine batch;
+        batch.setPrecision (options.precision);
+        batch.prepare (numStreams, options.sampleRate);
+        for (int s = 0; s < numStreams; ++s)
+        {
+            const auto settings = getSettings (s);
+            const auto id = batch.addStream (settings.type, settings.brightness);
+            batch.setProcessing (id, settings.processing);
+        }
+        return batch;
+    }
+
+    std::vector<std::unique_ptr<ChannelBank>> makeBanks (int numStreams, const Options& options)
+    {
+        std::vector<std::unique_ptr<ChannelBank>> banks;
+        for (int s = 0; s < numStreams; ++s)
+        {
+            const auto settings = getSettings (s);
+            auto bank = std::make_unique<ChannelBank>();
+            bank->prepare (1, options.sampleRate);
+            bank->setPrecision (options.precision);
+            bank->setMode (settings.type, settings.brightness);
+            bank->setProcessing (settings.processing);
+            banks.push_back (std::move (bank));
+        }
+        return banks;
+    }
+
+    // ns per stream and sample
+    template <typename F>
+    double measure (F&& process, int numStreams, const Options& options)
+    {
+        for (int i = 0; i < 16; ++i)
+            process();
+
+        using Clock = std::chrono::steady_clock;
+        long long blocks = 0;
+        const auto start = Clock::now();
+        const auto end = start + std::chrono::duration<double> (options.seconds);
+        auto now = start;
+        while (now < end)
+        {
+            process();
+            ++blocks;
+            now = Clock::now();
+        }
+        const auto elapsed = std::chrono::duration<double, std::nano> (now - start).count();
+        return elapsed / (static_cast<double> (blocks) * options.blockSize * numStreams);
+    }
+
+    void setShaping (BatchEngine& batch, ChannelBank& bank, int shaping)
+    {
+        const auto antialiasing = shaping == 1 ? Antialiasing::Adaa : Antialiasing::Off;
+        const auto tier = shaping == 2 ? SaturatorTier::Table : SaturatorTier::Polynomial;
+        batch.setAntialiasing (antialiasing);
+        batch.setSaturatorTier (tier);
+        bank.setAntialiasing (antialiasing);
+        bank.setSaturatorTier (tier);
+    }
+
+    int check (int numStreams, int shaping, const Options& options)
+    {
+        auto batch = makeBatch (numStreams, options);
+        auto banks = makeBanks (numStreams, options);
+        for (auto& bank : banks)
+            setShaping (batch, *bank, shaping);
+        std::vector<int> ids (static_cast<size_t> (numStreams));
+        for (int s = 0; s < numStreams; ++s)
+            ids[static_cast<size_t> (s)] = s;
+
+        int mismatches = 0;
+        for (int block = 0; block < 4; ++block)
+        {
+            for (int s = 0; s < numStreams && block > 0; ++s)
+            {
+                const auto i = static_cast<size_t> (s);
+                const auto settings = getSettings (s + block);
+                if (s % 3 == block % 3)
+                {
+                    batch.setMode (ids[i], settings.type, settings.brightness);
+                    banks[i]->setMode (settings.type, settings.brightness);
+                }
+                else if (s % 5 == block)
+                {
+                    batch.removeStream (ids[i]);
+                    ids[i] = batch.addStream (settings.type, settings.brightness);
+                    batch.setProcessing (ids[i], settings.processing);
+                    banks[i]->reset();
+                    banks[i]->setMode (settings.type, settings.brightness);
+                    banks[i]->setProcessing (settings.processing);
+                }
+            }
+
+            auto batchBuffers = makeInput (numStreams, options.blockSize);
+            auto bankBuffers = batchBuffers;
+            std::vector<float*> streams (static_cast<size_t> (numStreams));
+            for (size_t s = 0; s < streams.size(); ++s)
+                streams[static_cast<size_t> (ids[s])] = batchBuffers[s].data();
+
+            batch.process (streams.data(), options.blockSize);
+            for (size_t s = 0; s < streams.size(); ++s)
+            {
+                float* channel = bankBuffers[s].data();
+                banks[s]->process (&channel, 1, options.blockSize, 1.0f, 1.0f);
+                if (! std::equal (batchBuffers[s].begin(), batchBuffers[s].end(), bankBuffers[s].begin()))
+                    ++mismatches;
+            }
+        }
+        return mismatches;
+    }
+} // namespace
+
+int main (int argc, char** argv)
+{
+    Options options;
+    if (! parseOptions (argc, argv, options))
+        return 2;
+
+    BatchEngine probe;
+    probe.prepare (1, options.sampleRate);
+    std::printf ("%s, %s, %d-sample blocks\n", getIsaName (probe.getIsa()), options.precision == Precision::Float ? "float" : "double", options.blockSize);
+
+    if (options.check)
+    {
+        int failures = 0;
+        for (int numStreams = 1; numStreams <= options.maxStreams; numStreams = numStreams * 2 + 1)
+        {
+            constexpr const char* shapings[] = { "polynomial", "adaa", "table" };
+            for (int shaping = 0; shaping < 3; ++shaping)
+            {
+                const auto mismatches = check (numStreams, shaping, options);
+                std::printf ("%6d streams, %-10s: %d mismatched\n", numStreams, shapings[shaping], mismatches);
+                failures += mismatches;
+            }
+        }
+        return failures == 0 ? 0 : 1;
+    }
+
+    std::printf ("%8s %18s %18s %10s\n", "streams", "batch ns/sample", "banks ns/sample", "speedup");
+    for (int numStreams = 1; numStreams <= options.maxStreams; numStreams *= 4)
+    {
+        auto buffers = makeInput (numStreams, options.blockSize);
+        std::vector<float*> streams (buffers.size());
+        for (size_t s = 0; s < buffers.size(); ++s)
+            streams[s] = buffers[s].data();
+
+        auto batch = makeBatch (numStreams, options);
+        const auto batchNs = measure ([&]
+                                      { batch.process (streams.data(), options.blockSize); },
+                                      numStreams,
+                                      options);
+
+        auto banks = makeBanks (numStreams, options);
+        const auto banksNs = measure ([&]
+                                      {
+                                          for (size_t s = 0; s < banks.size(); ++s)
+                                              banks[s]->process (&streams[s], 1, options.blockSize, 1.0f, 1.0f);
+                                      },
+                                      numStreams,
+                                      options);
+
+        std::printf ("%8d %18.3f %18.3f %9.2fx\n", numStreams, batchNs, banksNs, banksNs / batchNs);
+    }
+    return 0;
+}
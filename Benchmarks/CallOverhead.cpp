@@ -0,0 +1,190 @@
+// Fixed cost of an Engine::process() call at the buffer sizes low-latency hosts use.
+//
+// "idle" calls process() only, like a block in which no parameter moved; "setters"
+// first hands every setting to the engine again unchanged, like the processor does for
+// the part after a parameter event. Tiny buffers should cost little more per call than
+// the samples they carry. --slices splits the channels over the worker pool.
+//
+//   TonixCallOverhead [--channels N] [--seconds S] [--oversampling 1|2|4|8]
+//                     [--precision double|float] [--io float|double] [--slices N]
+
+#include "DSP/ParallelEngine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace tonix;
+
+namespace
+{
+    constexpr int kBlockSizes[] = { 1, 8, 32, 64, 128, 512 };
+
+    struct Options
+    {
+        int channels { 2 };
+        double seconds { 0.25 };
+        double sampleRate { 48000.0 };
+        int oversamplingLog2 { 0 };
+        Precision precision { Precision::Double };
+        // host buffer sample type
+        bool doubleIO { false };
+        int slices { 1 };
+    };
+
+    constexpr auto kUsage = "usage: TonixCallOverhead [--channels N] [--seconds S] [--oversampling 1|2|4|8] [--precision double|float] [--io float|double] [--slices N]\n";
+
+    // the whole argument within [min, max] or nothing, a typo mustn't turn into a value
+    bool parseNumber (const char* text, double min, double max, double& value)
+    {
+        char* end = nullptr;
+        value = std::strtod (text, &end);
+        return end != text && *end == '\0' && value >= min && value <= max;
+    }
+
+    bool parseInteger (const char* text, int min, int max, int& value)
+    {
+        double number;
+        if (! parseNumber (text, min, max, number) || number != std::floor (number))
+            return false;
+        value = static_cast<int> (number);
+        return true;
+    }
+
+    // false after saying what is wrong
+    bool parseOptions (int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const auto* name = argv[i];
+            const auto isOption = [name] (const char* option)
+            {
+                return std::strcmp (name, option) == 0;
+            };
+            if (! (isOption ("--channels") || isOption ("--seconds") || isOption ("--oversampling") || isOption ("--precision") || isOption ("--io") || isOption ("--slices")))
+            {
+                std::fprintf (stderr, "unknown option %s\n%s", name, kUsage);
+                return false;
+            }
+            if (i + 1 >= argc)
+            {
+                std::fprintf (stderr, "missing value for %s\n%s", name, kUsage);
+                return false;
+            }
+            const auto* text = argv[++i];
+            bool valid = true;
+            if (isOption ("--channels"))
+                valid = parseInteger (text, 1, 1024, options.channels);
+            else if (isOption ("--seconds"))
+                valid = parseNumber (text, 0.01, 3600.0, options.seconds);
+            else if (isOption ("--oversampling"))
+            {
+                int factor = 0;
+                valid = parseInteger (text, 1, 1 << Oversampler::kMaxFactorLog2, factor) && (factor & (factor - 1)) == 0;
+                options.oversamplingLog2 = valid ? static_cast<int> (std::lround (std::log2 (factor))) : 0;
+            }
+            else if (isOption ("--precision"))
+            {
+                valid = std::strcmp (text, "double") == 0 || std::strcmp (text, "float") == 0;
+                options.precision = std::strcmp (text, "float") == 0 ? Precision::Float : Precision::Double;
+            }
+            else if (isOption ("--io"))
+            {
+                valid = std::strcmp (text, "double") == 0 || std::strcmp (text, "float") == 0;
+                options.doubleIO = std::strcmp (text, "double") == 0;
+            }
+            else
+                valid = parseInteger (text, 1, 64, options.slices);
+            if (! valid)
+            {
+                std::fprintf (stderr, "bad value %s for %s\n%s", text, name, kUsage);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    struct Result
+    {
+        double nsPerCall, nsPerSample;
+    };
+
+    template <typename SampleType>
+    Result measure (int blockSize, bool setters, const Options& options)
+    {
+        ParallelEngine engine;
+        engine.setMode (Type::Radiant, Brightness::Gold);
+        engine.setProcessing (0.5);
+        engine.setPrecision (options.precision);
+        engine.prepare (options.channels, options.sampleRate, blockSize, options.oversamplingLog2, OversamplingPhase::Linear, InternalRate::Host, false, options.slices, options.slices > 1 ? &getWorkerPool() : nullptr);
+
+        // -12 dBFS, long enough that the input doesn't repeat within a call
+        std::vector<std::vector<SampleType>> buffers (static_cast<size_t> (options.channels), std::vector<SampleType> (4096));
+        for (size_t ch = 0; ch < buffers.size(); ++ch)
+            for (size_t i = 0; i < buffers[ch].size(); ++i)
+                buffers[ch][i] = static_cast<SampleType> (0.25 * (std::sin (0.031 * (double) i + (double) ch) + std::sin (0.17 * (double) i)));
+        std::vector<SampleType*> channels (buffers.size());
+
+        long long calls = 0;
+        int offset = 0;
+        const auto call = [&]
+        {
+            if (setters)
+            {
+                engine.setBypassed (false);
+                engine.setMode (Type::Radiant, Brightness::Gold);
+                engine.setProcessing (0.5);
+                engine.setAutoGain (true);
+                engine.setPrecision (options.precision);
+                engine.setAntialiasing (Antialiasing::Off);
+                engine.setSaturatorTier (SaturatorTier::Polynomial);
+            }
+            if (offset + blockSize > 4096)
+                offset = 0;
+            for (size_t ch = 0; ch < buffers.size(); ++ch)
+                channels[ch] = buffers[ch].data() + offset;
+            engine.process (channels.data(), options.channels, blockSize, 1.0f, 1.0f);
+            offset += blockSize;
+        };
+
+        // warm up caches and branch predictors, and let the first smoothing settle
+        for (int i = 0; i < 4096; ++i)
+            call();
+
+        using Clock = std::chrono::steady_clock;
+        const auto start = Clock::now();
+        const auto end = start + std::chrono::duration<double> (options.seconds);
+        auto now = start;
+        while (now < end)
+        {
+            for (int i = 0; i < 256; ++i)
+                call();
+            calls += 256;
+            now = Clock::now();
+        }
+        const auto elapsed = std::chrono::duration<double, std::nano> (now - start).count();
+        return { elapsed / static_cast<double> (calls), elapsed / (static_cast<double> (calls) * blockSize * options.channels) };
+    }
+} // namespace
+
+int main (int argc, char** argv)
+{
+    Options options;
+    if (! parseOptions (argc, argv, options))
+        return 2;
+
+    std::printf ("%s, %s I/O, channels %d, %dx oversampling, %d slices\n", options.precision == Precision::Float ? "float" : "double", options.doubleIO ? "double" : "float", options.channels, 1 << options.oversamplingLog2, options.slices);
+    std::printf ("%6s %14s %14s %14s %14s\n", "block", "idle ns/call", "ns/sample", "setters ns/call", "ns/sample");
+    for (const auto blockSize : kBlockSizes)
+    {
+        Result results[2];
+        for (const bool setters : { false, true })
+            results[setters ? 1 : 0] = options.doubleIO ? measure<double> (blockSize, setters, options) : measure<float> (blockSize, setters, options);
+        std::printf ("%6d %14.1f %14.3f %14.1f %14.3f\n", blockSize, results[0].nsPerCall, results[0].nsPerSample, results[1].nsPerCall, results[1].nsPerSample);
+    }
+    return 0;
+}
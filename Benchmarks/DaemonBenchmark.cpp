@@ -0,0 +1,353 @@
+// Round trip latency and aggregate throughput of engines running in TonixDaemon. Each
+// round trip is compared against processing the same block in this process.
+//
+//   TonixDaemonBenchmark [--name NAME] [--spawn PATH] [--clients N] [--block N]
+//                        [--channels N] [--depth N] [--seconds S] [--check]
+//
+// --spawn starts the daemon at PATH for the run instead of using one that is running.
+// Throughput runs one thread per client, each keeping --depth blocks in flight.
+// --check compares a few seconds of daemon output with an in-process engine; it has to
+// match bit for bit.
+
+#include "DaemonClient.h"
+#include "tonix.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace tonix::daemon;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Options
+    {
+        const char* name { kDefaultName };
+        const char* spawn { nullptr };
+        int numClients { 4 };
+        int blockSize { 256 };
+        int numChannels { 2 };
+        int depth { 2 };
+        double seconds { 1.0 };
+        double sampleRate { 48000.0 };
+        bool check { false };
+    };
+
+    constexpr auto kUsage = "usage: TonixDaemonBenchmark [--name NAME] [--spawn PATH] [--clients N] [--block N] [--channels N] [--depth N] [--seconds S] [--check]\n";
+
+    // the whole argument within [min, max] or nothing, a typo mustn't turn into a value
+    bool parseNumber (const char* text, double min, double max, double& value)
+    {
+        char* end = nullptr;
+        value = std::strtod (text, &end);
+        return end != text && *end == '\0' && value >= min && value <= max;
+    }
+
+    bool parseInteger (const char* text, int min, int max, int& value)
+    {
+        double number;
+        if (! parseNumber (text, min, max, number) || number != std::floor (number))
+            return false;
+        value = static_cast<int> (number);
+        return true;
+    }
+
+    // false after saying what is wrong; --check must not pass on settings it wasn't given
+    bool parseOptions (int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const auto* name = argv[i];
+            const auto isOption = [name] (const char* option)
+            {
+                return std::strcmp (name, option) == 0;
+            };
+            if (isOption ("--check"))
+            {
+                options.check = true;
+                continue;
+            }
+            if (! (isOption ("--name") || isOption ("--spawn") || isOption ("--clients") || isOption ("--block") || isOption ("--channels") || isOption ("--depth") || isOption ("--seconds")))
+            {
+                std::fprintf (stderr, "unknown option %s\n%s", name, kUsage);
+                return false;
+            }
+            if (i + 1 >= argc)
+            {
+                std::fprintf (stderr, "missing value for %s\n%s", name, kUsage);
+                return false;
+            }
+            const auto* text = argv[++i];
+            bool valid = true;
+            if (isOption ("--name"))
+                options.name = text;
+            else if (isOption ("--spawn"))
+                options.spawn = text;
+            else if (isOption ("--clients"))
+                valid = parseInteger (text, 1, kMaxInstances, options.numClients);
+            else if (isOption ("--block"))
+                valid = parseInteger (text, 1, kMaxBlockSize, options.blockSize);
+            else if (isOption ("--channels"))
+                valid = parseInteger (text, 1, kMaxChannels, options.numChannels);
+            else if (isOption ("--depth"))
+                valid = parseInteger (text, 1, kMaxRingSize, options.depth);
+            else
+                valid = parseNumber (text, 0.01, 3600.0, options.seconds);
+            if (! valid)
+            {
+                std::fprintf (stderr, "bad value %s for %s\n%s", text, name, kUsage);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // a signal with some level changes in it, so the engine doesn't go to sleep
+    struct Signal
+    {
+        std::vector<std::vector<float>> channels;
+        std::vector<float*> pointers;
+        uint32_t seed { 1 };
+        int64_t position { 0 };
+
+        Signal (int numChannels, int blockSize)
+            : channels (static_cast<size_t> (numChannels), std::vector<float> (static_cast<size_t> (blockSize)))
+        {
+            for (auto& channel : channels)
+                pointers.push_back (channel.data());
+        }
+
+        void fill (int numFrames)
+        {
+            for (auto& channel : channels)
+                for (int i = 0; i < numFrames; ++i)
+                {
+                    seed = seed * 1664525u + 1013904223u;
+                    const auto level = 0.5f + 0.4f * std::sin (static_cast<float> (position + i) * 1.0e-4f);
+                    channel[static_cast<size_t> (i)] = level * (static_cast<float> (seed >> 8) / 8388608.0f - 1.0f);
+                }
+            position += numFrames;
+        }
+    };
+
+    void setParameters (RemoteProcessor& remote, tonix::api::Processor* local)
+    {
+        const std::pair<tonix_param, double> values[] = { { TONIX_PARAM_PROCESS, 60.0 }, { TONIX_PARAM_TYPE, 2.0 }, { TONIX_PARAM_BRIGHTNESS, 1.0 }, { TONIX_PARAM_AUTO_GAIN, 1.0 } };
+        for (const auto& [param, value] : values)
+        {
+            remote.setParameter (param, value);
+            if (local != nullptr)
+                local->setParameter (static_cast<tonix::api::Parameter> (param), value);
+        }
+    }
+
+    bool open (RemoteProcessor& remote, const Options& options, int ringSize)
+    {
+        std::string error;
+        if (remote.open (options.numChannels, options.sampleRate, options.blockSize, error, ringSize, options.name))
+            return true;
+        std::fprintf (stderr, "%s\n", error.c_str());
+        return false;
+    }
+
+    double getPercentile (std::vector<double>& values, double fraction)
+    {
+        if (values.empty())
+            return 0.0;
+        const auto index = std::min (values.size() - 1, static_cast<size_t> (fraction * static_cast<double> (values.size())));
+        std::nth_element (values.begin(), values.begin() + static_cast<ptrdiff_t> (index), values.end());
+        return values[index];
+    }
+
+    int check (const Options& options)
+    {
+        RemoteProcessor remote;
+        tonix::api::Processor local;
+        setParameters (remote, &local);
+        if (! open (remote, options, 1))
+            return 1;
+        local.prepare (options.numChannels, options.sampleRate, options.blockSize);
+
+        Signal signal (options.numChannels, options.blockSize);
+        std::vector<std::vector<float>> expected (signal.channels);
+        std::vector<float*> pointers;
+        for (auto& channel : expected)
+            pointers.push_back (channel.data());
+
+        int64_t mismatches = 0;
+        const auto numBlocks = static_cast<int> (3.0 * options.sampleRate / options.blockSize);
+        for (int b = 0; b < numBlocks; ++b)
+        {
+            // and some parameter changes on the way
+            if (b == numBlocks / 2)
+            {
+                remote.setParameter (TONIX_PARAM_TYPE, 4.0);
+                local.setParameter (tonix::api::Parameter::Type, 4.0);
+            }
+            const auto numFrames = b % 7 == 3 ? options.blockSize / 2 + 1 : options.blockSize;
+            signal.fill (numFrames);
+            for (size_t ch = 0; ch < expected.size(); ++ch)
+                std::copy (signal.channels[ch].begin(), signal.channels[ch].end(), expected[ch].begin());
+            local.process (pointers.data(), options.numChannels, numFrames);
+            if (! remote.process (signal.pointers.data(), numFrames))
+            {
+                std::fprintf (stderr, "the daemon went away\n");
+                return 1;
+            }
+            for (size_t ch = 0; ch < expected.size(); ++ch)
+                for (int i = 0; i < numFrames; ++i)
+                    mismatches += signal.channels[ch][static_cast<size_t> (i)] != expected[ch][static_cast<size_t> (i)];
+        }
+        std::printf ("check: %lld mismatched samples over %d blocks\n", static_cast<long long> (mismatches), numBlocks);
+        return mismatches == 0 ? 0 : 1;
+    }
+
+    int measureLatency (const Options& options)
+    {
+        RemoteProcessor remote;
+        tonix::api::Processor local;
+        setParameters (remote, &local);
+        if (! open (remote, options, 1))
+            return 1;
+        local.prepare (options.numChannels, options.sampleRate, options.blockSize);
+
+        Signal signal (options.numChannels, options.blockSize);
+        std::vector<double> remoteTimes, localTimes;
+        const auto end = Clock::now() + std::chrono::duration<double> (options.seconds);
+        while (Clock::now() < end)
+        {
+            signal.fill (options.blockSize);
+            const auto start = Clock::now();
+            local.process (signal.pointers.data(), options.numChannels, options.blockSize);
+            const auto middle = Clock::now();
+            if (! remote.process (signal.pointers.data(), options.blockSize))
+            {
+                std::fprintf (stderr, "the daemon went away\n");
+                return 1;
+            }
+            localTimes.push_back (std::chrono::duration<double, std::micro> (middle - start).count());
+            remoteTimes.push_back (std::chrono::duration<double, std::micro> (Clock::now() - middle).count());
+        }
+
+        std::printf ("round trip, %d channels, %d-sample blocks, %zu blocks\n", options.numChannels, options.blockSize, remoteTimes.size());
+        std::printf ("%12s %10s %10s %10s\n", "us", "p50", "p99", "max");
+        for (auto* times : { &localTimes, &remoteTimes })
+        {
+            const auto max = *std::max_element (times->begin(), times->end());
+            std::printf ("%12s %10.2f %10.2f %10.2f\n", times == &localTimes ? "in process" : "daemon", getPercentile (*times, 0.5), getPercentile (*times, 0.99), max);
+        }
+        return 0;
+    }
+
+    int measureThroughput (const Options& options)
+    {
+        std::atomic<int64_t> frames { 0 };
+        std::atomic<int> failures { 0 };
+        std::atomic<bool> go { false };
+        std::vector<std::thread> clients;
+        for (int c = 0; c < options.numClients; ++c)
+            clients.emplace_back ([&]
+                                  {
+                                      RemoteProcessor remote;
+                                      setParameters (remote, nullptr);
+                                      if (! open (remote, options, options.depth))
+                                      {
+                                          ++failures;
+                                          return;
+                                      }
+                                      Signal signal (options.numChannels, options.blockSize);
+                                      signal.fill (options.blockSize);
+                                      while (! go.load())
+                                          std::this_thread::yield();
+
+                                      int64_t processed = 0;
+                                      const auto end = Clock::now() + std::chrono::duration<double> (options.seconds);
+                                      while (Clock::now() < end)
+                                      {
+                                          while (remote.getNumPending() < options.depth)
+                                              remote.submit (signal.pointers.data(), options.blockSize);
+                                          const auto numFrames = remote.receive (signal.pointers.data());
+                                          if (numFrames < 0)
+                                          {
+                                              ++failures;
+                                              return;
+                                          }
+                                          processed += numFrames;
+                                      }
+                                      while (remote.getNumPending() > 0)
+                                          processed += std::max (0, remote.receive (signal.pointers.data()));
+                                      frames += processed;
+                                  });
+
+        const auto start = Clock::now();
+        go.store (true);
+        for (auto& client : clients)
+            client.join();
+        const auto elapsed = std::chrono::duration<double> (Clock::now() - start).count();
+        if (failures.load() > 0)
+        {
+            std::fprintf (stderr, "%d clients failed\n", failures.load());
+            return 1;
+        }
+        const auto realtime = static_cast<double> (frames.load()) / options.sampleRate / elapsed;
+        std::printf ("throughput, %d clients, %d blocks in flight each: %.1fx realtime in total, %.1fx per client\n",
+                     options.numClients, options.depth, realtime, realtime / options.numClients);
+        return 0;
+    }
+
+    pid_t spawn (const Options& options)
+    {
+        const auto pid = fork();
+        if (pid == 0)
+        {
+            execl (options.spawn, options.spawn, "--name", options.name, static_cast<char*> (nullptr));
+            _exit (127);
+        }
+        // up once it answers
+        for (int i = 0; pid > 0 && i < 100; ++i)
+        {
+            RemoteProcessor probe;
+            std::string error;
+            if (probe.open (1, 48000.0, 16, error, 1, options.name))
+                return pid;
+            std::this_thread::sleep_for (std::chrono::milliseconds (20));
+        }
+        std::fprintf (stderr, "couldn't start %s\n", options.spawn);
+        if (pid > 0)
+            kill (pid, SIGTERM);
+        return -1;
+    }
+} // namespace
+
+int main (int argc, char** argv)
+{
+    Options options;
+    if (! parseOptions (argc, argv, options))
+        return 2;
+    pid_t daemon = 0;
+    if (options.spawn != nullptr && (daemon = spawn (options)) < 0)
+        return 1;
+
+    auto result = options.check ? check (options) : measureLatency (options);
+    if (! options.check && result == 0)
+        result = measureThroughput (options);
+
+    if (daemon > 0)
+    {
+        kill (daemon, SIGTERM);
+        waitpid (daemon, nullptr, 0);
+    }
+    return result;
+}
@@ -0,0 +1,425 @@
+// Cost of Engine::process() across the settings and host configurations Tonix runs in,
+// for catching builds that got slower.
+//
+// By default every Type x Brightness x Process (0, 50, 100%) x auto-gain x precision
+// combination runs at 48 kHz, 256-sample blocks and 2 channels, then each Type at Gold,
+// 50% and double precision runs once per sample rate (44.1 to 192 kHz), block size (1 to
+// 4096) and channel count (1 to 16) with the other two at those defaults. --full runs
+// the whole product instead, which takes hours.
+//
+//   TonixMatrixBenchmark [--full] [--seconds S] [--repeat N] [--json FILE]
+//                        [--compare FILE] [--threshold PERCENT]
+//
+// The engine picks its kernels as in the plugin, so TONIX_ISA selects another ISA.
+// Each case keeps the fastest of --repeat runs. --json writes the results; --compare
+// reads a file written that way and lists the cases that got more than --threshold
+// percent slower, exiting with 1 if there are any. Bad options exit with 2 before
+// anything runs.
+//
+// Cycles come from the core's cycle counter through perf where the kernel allows it,
+// otherwise from the TSC, which ticks at a fixed rate whatever the core's clock.
+
+#include "DSP/Engine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#elif defined(_M_X64)
+#include <intrin.h>
+#endif
+
+using namespace tonix;
+
+namespace
+{
+    constexpr const char* kTypeNames[] = { "Luminiscent", "Iridescent", "Radiant", "Luster", "DarkEssence" };
+    constexpr const char* kBrightnessNames[] = { "Opal", "Gold", "Sapphire" };
+    constexpr int kProcessLevels[] = { 0, 50, 100 };
+    constexpr double kSampleRates[] = { 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 };
+    constexpr int kBlockSizes[] = { 1, 16, 64, 256, 1024, 4096 };
+    constexpr int kChannelCounts[] = { 1, 2, 8, 16 };
+
+    // the settings the per-axis sweeps hold still
+    constexpr double kDefaultSampleRate = 48000.0;
+    constexpr int kDefaultBlockSize = 256;
+    constexpr int kDefaultChannels = 2;
+
+    struct Options
+    {
+        bool full { false };
+        double seconds { 0.02 };
+        int repeat { 3 };
+        const char* jsonPath { nullptr };
+        const char* comparePath { nullptr };
+        double threshold { 5.0 };
+    };
+
+    constexpr auto kUsage = "usage: TonixMatrixBenchmark [--full] [--seconds S] [--repeat N] [--json FILE] [--compare FILE] [--threshold PERCENT]\n";
+
+    // the whole argument or nothing, a typo mustn't turn into 0
+    bool parseNumber (const char* text, double& value)
+    {
+        char* end = nullptr;
+        value = std::strtod (text, &end);
+        return end != text && *end == '\0' && std::isfinite (value);
+    }
+
+    // false after saying what is wrong; a gate must not run with what it wasn't given
+    bool parseOptions (int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const auto isOption = [&] (const char* name)
+            {
+                return std::strcmp (argv[i], name) == 0;
+            };
+            if (isOption ("--full"))
+            {
+                options.full = true;
+                continue;
+            }
+            if (! (isOption ("--seconds") || isOption ("--repeat") || isOption ("--json") || isOption ("--compare") || isOption ("--threshold")))
+            {
+                std::fprintf (stderr, "unknown option %s\n%s", argv[i], kUsage);
+                return false;
+            }
+            if (i + 1 >= argc)
+            {
+                std::fprintf (stderr, "missing value for %s\n%s", argv[i], kUsage);
+                return false;
+            }
+            const auto* name = argv[i];
+            const auto* text = argv[++i];
+            if (std::strcmp (name, "--json") == 0)
+            {
+                options.jsonPath = text;
+                continue;
+            }
+            if (std::strcmp (name, "--compare") == 0)
+            {
+                options.comparePath = text;
+                continue;
+            }
+            double value;
+            if (! parseNumber (text, value))
+            {
+                std::fprintf (stderr, "bad value %s for %s\n%s", text, name, kUsage);
+                return false;
+            }
+            if (std::strcmp (name, "--seconds") == 0)
+                options.seconds = std::max (0.001, value);
+            else if (std::strcmp (name, "--repeat") == 0)
+                options.repeat = std::max (1, static_cast<int> (value));
+            else
+                options.threshold = std::max (0.0, value);
+        }
+        return true;
+    }
+
+    struct Case
+    {
+        Type type;
+        Brightness brightness;
+        int process;
+        bool autoGain;
+        Precision precision;
+        double sampleRate;
+        int blockSize;
+        int channels;
+
+        std::string getName() const
+        {
+            char name[128];
+            std::snprintf (name, sizeof (name), "%s/%s/%d/%s/%s/%g/%d/%d", kTypeNames[static_cast<size_t> (type)], kBrightnessNames[static_cast<size_t> (brightness)], process,
+                           autoGain ? "autogain" : "fixed", precision == Precision::Float ? "float" : "double", sampleRate, blockSize, channels);
+            return name;
+        }
+    };
+
+    struct Result
+    {
+        double nsPerSample, realtime, cyclesPerSample;
+    };
+
+    std::vector<Case> getCases (bool full)
+    {
+        std::vector<Case> cases;
+        const auto addModes = [&] (double sampleRate, int blockSize, int channels)
+        {
+            for (size_t t = 0; t < kNumTypes; ++t)
+                for (size_t b = 0; b < kNumBrightness; ++b)
+                    for (const auto process : kProcessLevels)
+                        for (const bool autoGain : { false, true })
+                            for (const auto precision : { Precision::Double, Precision::Float })
+                                cases.push_back ({ static_cast<Type> (t), static_cast<Brightness> (b), process, autoGain, precision, sampleRate, blockSize, channels });
+        };
+        if (full)
+        {
+            for (const auto sampleRate : kSampleRates)
+                for (const auto blockSize : kBlockSizes)
+                    for (const auto channels : kChannelCounts)
+                        addModes (sampleRate, blockSize, channels);
+            return cases;
+        }
+
+        addModes (kDefaultSampleRate, kDefaultBlockSize, kDefaultChannels);
+        const auto addTypes = [&] (double sampleRate, int blockSize, int channels)
+        {
+            for (size_t t = 0; t < kNumTypes; ++t)
+                cases.push_back ({ static_cast<Type> (t), Brightness::Gold, 50, false, Precision::Double, sampleRate, blockSize, channels });
+        };
+        for (const auto sampleRate : kSampleRates)
+            if (sampleRate != kDefaultSampleRate)
+                addTypes (sampleRate, kDefaultBlockSize, kDefaultChannels);
+        for (const auto blockSize : kBlockSizes)
+            if (blockSize != kDefaultBlockSize)
+                addTypes (kDefaultSampleRate, blockSize, kDefaultChannels);
+        for (const auto channels : kChannelCounts)
+            if (channels != kDefaultChannels)
+                addTypes (kDefaultSampleRate, kDefaultBlockSize, channels);
+        return cases;
+    }
+
+    // core cycles of this thread through perf, else TSC ticks, else nothing
+    class CycleCounter
+    {
+    public:
+        CycleCounter()
+        {
+#if defined(__linux__)
+            perf_event_attr attributes {};
+            attributes.type = PERF_TYPE_HARDWARE;
+            attributes.size = sizeof (attributes);
+            attributes.config = PERF_COUNT_HW_CPU_CYCLES;
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+            m_fd = static_cast<int> (syscall (SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+            if (m_fd >= 0)
+            {
+                ioctl (m_fd, PERF_EVENT_IOC_ENABLE, 0);
+                return;
+            }
+#endif
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+            m_source = "tsc";
+#else
+            m_source = "none";
+#endif
+        }
+
+        ~CycleCounter()
+        {
+#if defined(__linux__)
+            if (m_fd >= 0)
+                close (m_fd);
+#endif
+        }
+
+        CycleCounter (const CycleCounter&) = delete;
+        CycleCounter& operator= (const CycleCounter&) = delete;
+
+        const char* getSource() const { return m_source; }
+        bool isAvailable() const { return std::strcmp (m_source, "none") != 0; }
+
+        uint64_t read() const
+        {
+#if defined(__linux__)
+            if (m_fd >= 0)
+            {
+                uint64_t count = 0;
+                return ::read (m_fd, &count, sizeof (count)) == sizeof (count) ? count : 0;
+            }
+#endif
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+            return __rdtsc();
+#else
+            return 0;
+#endif
+        }
+
+    private:
+        int m_fd { -1 };
+        const char* m_source { "core" };
+    };
+
+    Result measure (const Case& c, const Options& options, const CycleCounter& counter)
+    {
+        // settings first, prepare() jumps the smoothing to them
+        Engine engine;
+        engine.setMode (c.type, c.brightness);
+        engine.setProcessing (c.process / 100.0);
+        engine.setAutoGain (c.autoGain);
+        engine.setPrecision (c.precision);
+        engine.prepare (c.channels, c.sampleRate, c.blockSize);
+
+        // -12 dBFS, long enough that the input doesn't repeat within a call
+        const auto length = std::max (4096, c.blockSize);
+        std::vector<std::vector<float>> buffers (static_cast<size_t> (c.channels), std::vector<float> (static_cast<size_t> (length)));
+        for (size_t ch = 0; ch < buffers.size(); ++ch)
+            for (size_t i = 0; i < buffers[ch].size(); ++i)
+                buffers[ch][i] = static_cast<float> (0.25 * (std::sin (0.031 * (double) i + (double) ch) + std::sin (0.17 * (double) i)));
+        std::vector<float*> channels (buffers.size());
+
+        int offset = 0;
+        const auto call = [&]
+        {
+            if (offset + c.blockSize > length)
+                offset = 0;
+            for (size_t ch = 0; ch < buffers.size(); ++ch)
+                channels[ch] = buffers[ch].data() + offset;
+            engine.process (channels.data(), c.channels, c.blockSize, 1.0f, 1.0f);
+            offset += c.blockSize;
+        };
+
+        // about 4096 frames between clock reads, so tiny blocks aren't timing the clock
+        const auto callsPerCheck = std::max (1, 4096 / c.blockSize);
+        for (int i = 0; i < 4 * callsPerCheck; ++i)
+            call();
+
+        using Clock = std::chrono::steady_clock;
+        Result best { INFINITY, 0.0, INFINITY };
+        for (int r = 0; r < options.repeat; ++r)
+        {
+            long long calls = 0;
+            const auto startCycles = counter.read();
+            const auto start = Clock::now();
+            const auto end = start + std::chrono::duration<double> (options.seconds);
+            auto now = start;
+            while (now < end)
+            {
+                for (int i = 0; i < callsPerCheck; ++i)
+                    call();
+                calls += callsPerCheck;
+                now = Clock::now();
+            }
+            const auto cycles = static_cast<double> (counter.read() - startCycles);
+            const auto samples = static_cast<double> (calls) * c.blockSize * c.channels;
+            const auto ns = std::chrono::duration<double, std::nano> (now - start).count() / samples;
+            if (ns < best.nsPerSample)
+                best = { ns, 1.0e9 / (ns * c.channels * c.sampleRate), counter.isAvailable() ? cycles / samples : 0.0 };
+        }
+        return best;
+    }
+
+    // ns/sample by case name from a file --json wrote, one case per line
+    std::map<std::string, double> readResults (const char* path)
+    {
+        std::map<std::string, double> results;
+        auto* file = std::fopen (path, "r");
+        if (file == nullptr)
+            return results;
+        char line[1024];
+        while (std::fgets (line, sizeof (line), file) != nullptr)
+        {
+            const auto* name = std::strstr (line, "\"name\": \"");
+            const auto* ns = std::strstr (line, "\"nsPerSample\": ");
+            if (name == nullptr || ns == nullptr)
+                continue;
+            name += std::strlen ("\"name\": \"");
+            const auto* nameEnd = std::strchr (name, '"');
+            if (nameEnd != nullptr)
+                results[std::string (name, nameEnd)] = std::strtod (ns + std::strlen ("\"nsPerSample\": "), nullptr);
+        }
+        std::fclose (file);
+        return results;
+    }
+
+    const char* getCompiler()
+    {
+#if defined(__clang__) || defined(__GNUC__)
+        return __VERSION__;
+#elif defined(_MSC_VER)
+        return "MSVC " _CRT_STRINGIZE (_MSC_FULL_VER);
+#else
+        return "unknown";
+#endif
+    }
+} // namespace
+
+int main (int argc, char** argv)
+{
+    Options options;
+    if (! parseOptions (argc, argv, options))
+        return 2;
+    const auto cases = getCases (options.full);
+    const CycleCounter counter;
+
+    Engine probe;
+    probe.prepare (1, kDefaultSampleRate, kDefaultBlockSize);
+    const auto* isa = getIsaName (probe.getChannels().getIsa());
+    std::printf ("isa %s, %s cycles, %zu cases\n", isa, counter.getSource(), cases.size());
+    std::printf ("%-48s %10s %12s %10s\n", "case", "ns/sample", "realtime", "cycles");
+
+    std::vector<Result> results;
+    for (const auto& c : cases)
+    {
+        results.push_back (measure (c, options, counter));
+        const auto& r = results.back();
+        std::printf ("%-48s %10.3f %11.0fx %10.2f\n", c.getName().c_str(), r.nsPerSample, r.realtime, r.cyclesPerSample);
+    }
+
+    if (options.jsonPath != nullptr)
+    {
+        auto* file = std::fopen (options.jsonPath, "w");
+        if (file == nullptr)
+        {
+            std::fprintf (stderr, "can't write %s\n", options.jsonPath);
+            return 1;
+        }
+        std::fprintf (file, "{\n  \"isa\": \"%s\",\n  \"compiler\": \"%s\",\n  \"cycles\": \"%s\",\n  \"cases\": [\n", isa, getCompiler(), counter.getSource());
+        for (size_t i = 0; i < cases.size(); ++i)
+        {
+            const auto& c = cases[i];
+            const auto& r = results[i];
+            std::fprintf (file, "    { \"name\": \"%s\", \"type\": \"%s\", \"brightness\": \"%s\", \"process\": %d, \"autoGain\": %s, \"precision\": \"%s\", \"sampleRate\": %g, \"blockSize\": %d, \"channels\": %d, \"nsPerSample\": %.4f, \"realtime\": %.1f, \"cyclesPerSample\": %.3f }%s\n",
+                          c.getName().c_str(), kTypeNames[static_cast<size_t> (c.type)], kBrightnessNames[static_cast<size_t> (c.brightness)], c.process, c.autoGain ? "true" : "false",
+                          c.precision == Precision::Float ? "float" : "double", c.sampleRate, c.blockSize, c.channels, r.nsPerSample, r.realtime, r.cyclesPerSample, i + 1 < cases.size() ? "," : "");
+        }
+        std::fprintf (file, "  ]\n}\n");
+        std::fclose (file);
+    }
+
+    if (options.comparePath == nullptr)
+        return 0;
+    const auto baseline = readResults (options.comparePath);
+    if (baseline.empty())
+    {
+        std::fprintf (stderr, "no results in %s\n", options.comparePath);
+        return 1;
+    }
+    int compared = 0, regressions = 0;
+    double logRatios = 0.0;
+    for (size_t i = 0; i < cases.size(); ++i)
+    {
+        const auto found = baseline.find (cases[i].getName());
+        if (found == baseline.end() || ! (found->second > 0.0))
+            continue;
+        const auto ratio = results[i].nsPerSample / found->second;
+        logRatios += std::log (ratio);
+        ++compared;
+        if ((ratio - 1.0) * 100.0 > options.threshold)
+        {
+            if (regressions++ == 0)
+                std::printf ("\nslower than %s by more than %g%%:\n", options.comparePath, options.threshold);
+            std::printf ("%-48s %10.3f -> %8.3f ns/sample (%+.1f%%)\n", cases[i].getName().c_str(), found->second, results[i].nsPerSample, (ratio - 1.0) * 100.0);
+        }
+    }
+    std::printf ("\n%d cases compared, %d slower, %+.1f%% overall (geometric mean)\n", compared, regressions, compared > 0 ? (std::exp (logRatios / compared) - 1.0) * 100.0 : 0.0);
+    return regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,125 @@
+// Measures how far the float engine strays from the double one.
+//
+// Renders the same material through two ChannelBanks, one per precision, for every
+// Type x Brightness at a few Process settings and prints the worst sample error and the
+// error level relative to the double output.
+//
+//   TonixPrecisionReport [--seconds S] [--rate HZ]
+
+#include "DSP/ChannelBank.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace tonix;
+
+namespace
+{
+    constexpr const char* kTypeNames[] = { "Luminiscent", "Iridescent", "Radiant", "Luster", "DarkEssence" };
+    constexpr const char* kBrightnessNames[] = { "Opal", "Gold", "Sapphire" };
+    constexpr int kBlockSize = 512;
+    constexpr double kPi = 3.14159265358979323846;
+
+    double toDecibels (double gain)
+    {
+        return gain > 0.0 ? 20.0 * std::log10 (gain) : -400.0;
+    }
+
+    // log sine sweep with some noise on top, stereo with a small offset between channels
+    std::vector<std::vector<float>> makeSignal (int numSamples, double sampleRate, double level)
+    {
+        std::vector<std::vector<float>> signal (2, std::vector<float> (static_cast<size_t> (numSamples)));
+        std::mt19937 rng (1);
+        std::normal_distribution<double> noise (0.0, 0.05);
+        const double f0 = 20.0, f1 = 20000.0;
+        const double duration = numSamples / sampleRate;
+        const double k = std::log (f1 / f0);
+        for (size_t ch = 0; ch < signal.size(); ++ch)
+        {
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const double t = i / sampleRate;
+                const double phase = 2.0 * kPi * f0 * duration / k * (std::exp (t / duration * k) - 1.0) + 0.3 * (double) ch;
+                signal[ch][static_cast<size_t> (i)] = static_cast<float> (level * (std::sin (phase) + noise (rng)));
+            }
+        }
+        return signal;
+    }
+
+    void render (ChannelBank& bank, std::vector<std::vector<float>>& signal)
+    {
+        const auto numSamples = static_cast<int> (signal[0].size());
+        for (int offset = 0; offset < numSamples; offset += kBlockSize)
+        {
+            float* channels[] = { signal[0].data() + offset, signal[1].data() + offset };
+            bank.process (channels, 2, std::min (kBlockSize, numSamples - offset), 1.0f, 1.0f);
+        }
+    }
+} // namespace
+
+int main (int argc, char** argv)
+{
+    double seconds = 2.0, sampleRate = 48000.0;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::strcmp (argv[i], "--seconds") == 0)
+            seconds = std::max (0.1, std::atof (argv[i + 1]));
+        else if (std::strcmp (argv[i], "--rate") == 0)
+            sampleRate = std::max (44100.0, std::atof (argv[i + 1]));
+        else
+            std::fprintf (stderr, "unknown option %s\n", argv[i]);
+    }
+
+    const auto numSamples = static_cast<int> (seconds * sampleRate);
+    std::printf ("%-12s %-9s %8s %7s %14s %14s\n", "type", "bright", "process", "input", "max err dB", "err/sig dB");
+
+    double worstMax = 0.0, worstRelative = -400.0;
+    for (size_t t = 0; t < kNumTypes; ++t)
+    {
+        for (size_t b = 0; b < kNumBrightness; ++b)
+        {
+            for (const double process : { 0.0, 0.5, 1.0 })
+            {
+                for (const double inputDb : { -18.0, 0.0 })
+                {
+                    const auto source = makeSignal (numSamples, sampleRate, std::pow (10.0, inputDb / 20.0));
+                    std::vector<std::vector<float>> outputs[2] = { source, source };
+                    for (const auto precision : { Precision::Double, Precision::Float })
+                    {
+                        ChannelBank bank;
+                        bank.prepare (2, sampleRate);
+                        bank.setMode (static_cast<Type> (t), static_cast<Brightness> (b));
+                        bank.setProcessing (process);
+                        bank.setAutoGain (true);
+                        bank.setPrecision (precision);
+                        render (bank, outputs[static_cast<size_t> (precision)]);
+                    }
+
+                    double maxError = 0.0, errorEnergy = 0.0, signalEnergy = 0.0;
+                    for (size_t ch = 0; ch < 2; ++ch)
+                    {
+                        for (size_t i = 0; i < source[ch].size(); ++i)
+                        {
+                            const double reference = outputs[0][ch][i];
+                            const double error = outputs[1][ch][i] - reference;
+                            maxError = std::max (maxError, std::abs (error));
+                            errorEnergy += error * error;
+                            signalEnergy += reference * reference;
+                        }
+                    }
+                    const auto relative = toDecibels (std::sqrt (errorEnergy / std::max (signalEnergy, 1e-30)));
+                    worstMax = std::max (worstMax, maxError);
+                    worstRelative = std::max (worstRelative, relative);
+                    std::printf ("%-12s %-9s %7.0f%% %7.0f %14.1f %14.1f\n", kTypeNames[t], kBrightnessNames[b], process * 100.0, inputDb, toDecibels (maxError), relative);
+                }
+            }
+        }
+    }
+    std::printf ("worst: max error %.1f dBFS, error %.1f dB below the signal\n", toDecibels (worstMax), -worstRelative);
+    return 0;
+}
@@ -0,0 +1,443 @@
+// Quality against cost for every engine variant, to tell which of the cheaper settings
+// can ship without changing the sound.
+//
+// The reference is the straight port of Phoenix: double precision, polynomial
+// saturators, no ADAA, no oversampling. Every variant renders every Type x Brightness
+// through the whole Engine, with:
+//   - a steady 1 kHz sine, for THD over the harmonics below Nyquist
+//   - a steady 6 kHz sine, for aliasing: whatever lands off its harmonics and DC, which
+//     is mostly harmonics above Nyquist folded back
+//   - a log sweep, a multitone and noise, for the worst sample error and the error level
+//     against the golden reference, and the cost in ns/sample
+// Tones sit exactly on an analysis bin, so nothing needs a window.
+//
+//   TonixQualityReport [--seconds S] [--rate HZ] [--process PERCENT] [--tolerance DB]
+//                      [--golden FILE] [--save-golden FILE] [--summary]
+//
+// Without --golden the golden reference is the reference variant rendered now.
+// --save-golden stores that render; checked in and passed back with --golden, it also
+// catches changes to the reference path itself. The summary calls a variant equivalent
+// when its error stays --tolerance dB below the signal everywhere, and cleaner when it
+// differs but aliases at least 3 dB less without moving THD by more than 1 dB. Bad
+// options exit with 2 before anything runs.
+
+#include "DSP/Engine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace tonix;
+
+namespace
+{
+    constexpr const char* kTypeNames[] = { "Luminiscent", "Iridescent", "Radiant", "Luster", "DarkEssence" };
+    constexpr const char* kBrightnessNames[] = { "Opal", "Gold", "Sapphire" };
+    constexpr const char* kSignalNames[] = { "sweep", "multitone", "noise" };
+    constexpr size_t kNumSignals = 3;
+    constexpr size_t kNumModes = kNumTypes * kNumBrightness;
+    constexpr int kBlockSize = 512;
+    constexpr double kPi = 3.14159265358979323846;
+
+    // analysed tone length, and what runs before it so filters and smoothing settle
+    constexpr int kAnalysisLength = 1 << 15;
+    constexpr int kSettleLength = 1 << 13;
+
+    constexpr uint32_t kGoldenMagic = 0x474e5854;
+    constexpr uint32_t kGoldenVersion = 1;
+
+    struct Options
+    {
+        double seconds { 1.0 };
+        double sampleRate { 48000.0 };
+        double process { 100.0 };
+        double tolerance { -60.0 };
+        const char* goldenPath { nullptr };
+        const char* saveGoldenPath { nullptr };
+        bool summary { false };
+    };
+
+    constexpr auto kUsage = "usage: TonixQualityReport [--seconds S] [--rate HZ] [--process PERCENT] [--tolerance DB] [--golden FILE] [--save-golden FILE] [--summary]\n";
+
+    // the whole argument or nothing, a typo mustn't turn into 0
+    bool parseNumber (const char* text, double& value)
+    {
+        char* end = nullptr;
+        value = std::strtod (text, &end);
+        return end != text && *end == '\0' && std::isfinite (value);
+    }
+
+    // false after saying what is wrong; a check against the golden reference must not
+    // pass on settings it wasn't given
+    bool parseOptions (int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const auto isOption = [&] (const char* name)
+            {
+                return std::strcmp (argv[i], name) == 0;
+            };
+            if (isOption ("--summary"))
+            {
+                options.summary = true;
+                continue;
+            }
+            if (! (isOption ("--seconds") || isOption ("--rate") || isOption ("--process") || isOption ("--tolerance") || isOption ("--golden") || isOption ("--save-golden")))
+            {
+                std::fprintf (stderr, "unknown option %s\n%s", argv[i], kUsage);
+                return false;
+            }
+            if (i + 1 >= argc)
+            {
+                std::fprintf (stderr, "missing value for %s\n%s", argv[i], kUsage);
+                return false;
+            }
+            const auto* name = argv[i];
+            const auto* text = argv[++i];
+            if (std::strcmp (name, "--golden") == 0)
+            {
+                options.goldenPath = text;
+                continue;
+            }
+            if (std::strcmp (name, "--save-golden") == 0)
+            {
+                options.saveGoldenPath = text;
+                continue;
+            }
+            double value;
+            if (! parseNumber (text, value))
+            {
+                std::fprintf (stderr, "bad value %s for %s\n%s", text, name, kUsage);
+                return false;
+            }
+            if (std::strcmp (name, "--seconds") == 0)
+                options.seconds = std::max (0.1, value);
+            else if (std::strcmp (name, "--rate") == 0)
+                options.sampleRate = std::max (44100.0, value);
+            else if (std::strcmp (name, "--process") == 0)
+                options.process = std::clamp (value, 0.0, 100.0);
+            else
+                options.tolerance = value;
+        }
+        return true;
+    }
+
+    struct Variant
+    {
+        const char* name;
+        Precision precision;
+        SaturatorTier saturatorTier;
+        Antialiasing antialiasing;
+        int oversamplingLog2;
+        OversamplingPhase phase;
+        InternalRate internalRate;
+    };
+
+    // the reference first
+    constexpr Variant kVariants[] = {
+        { "reference", Precision::Double, SaturatorTier::Polynomial, Antialiasing::Off, 0, OversamplingPhase::Linear, InternalRate::Host },
+        { "float", Precision::Float, SaturatorTier::Polynomial, Antialiasing::Off, 0, OversamplingPhase::Linear, InternalRate::Host },
+        { "table", Precision::Double, SaturatorTier::Table, Antialiasing::Off, 0, OversamplingPhase::Linear, InternalRate::Host },
+        { "float table", Precision::Float, SaturatorTier::Table, Antialiasing::Off, 0, OversamplingPhase::Linear, InternalRate::Host },
+        { "adaa", Precision::Double, SaturatorTier::Polynomial, Antialiasing::Adaa, 0, OversamplingPhase::Linear, InternalRate::Host },
+        { "2x linear", Precision::Double, SaturatorTier::Polynomial, Antialiasing::Off, 1, OversamplingPhase::Linear, InternalRate::Host },
+        { "2x minimum", Precision::Double, SaturatorTier::Polynomial, Antialiasing::Off, 1, OversamplingPhase::Minimum, InternalRate::Host },
+        { "4x linear", Precision::Double, SaturatorTier::Polynomial, Antialiasing::Off, 2, OversamplingPhase::Linear, InternalRate::Host },
+        { "8x linear", Precision::Double, SaturatorTier::Polynomial, Antialiasing::Off, 3, OversamplingPhase::Linear, InternalRate::Host },
+        { "internal 2x rate", Precision::Double, SaturatorTier::Polynomial, Antialiasing::Off, 0, OversamplingPhase::Linear, InternalRate::Double },
+        { "float table 2x", Precision::Float, SaturatorTier::Table, Antialiasing::Off, 1, OversamplingPhase::Minimum, InternalRate::Host },
+    };
+
+    double toDecibels (double gain)
+    {
+        return gain > 0.0 ? 20.0 * std::log10 (gain) : -400.0;
+    }
+
+    // an odd bin, so no harmonic folds back onto another one
+    int getToneBin (double frequency, double sampleRate)
+    {
+        return static_cast<int> (std::lround (frequency * kAnalysisLength / sampleRate)) | 1;
+    }
+
+    std::vector<float> makeTone (int bin, double level)
+    {
+        std::vector<float> tone (kSettleLength + kAnalysisLength);
+        for (size_t i = 0; i < tone.size(); ++i)
+            tone[i] = static_cast<float> (level * std::sin (2.0 * kPi * bin * static_cast<double> (i) / kAnalysisLength));
+        return tone;
+    }
+
+    std::vector<std::vector<float>> makeSignals (int numSamples, double sampleRate)
+    {
+        std::vector<std::vector<float>> signals (kNumSignals, std::vector<float> (static_cast<size_t> (numSamples)));
+        // -6 dBFS log sweep over the audio band
+        const double f0 = 20.0, f1 = std::min (20000.0, 0.45 * sampleRate);
+        const double duration = numSamples / sampleRate, k = std::log (f1 / f0);
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const double t = i / sampleRate;
+            signals[0][static_cast<size_t> (i)] = static_cast<float> (0.5 * std::sin (2.0 * kPi * f0 * duration / k * (std::exp (t / duration * k) - 1.0)));
+        }
+        // inharmonic tones, -6 dBFS at most
+        const double frequencies[] = { 61.0, 247.0, 1129.0, 2473.0, 5119.0, 9871.0, 15101.0 };
+        for (int i = 0; i < numSamples; ++i)
+        {
+            double sum = 0.0;
+            for (const auto f : frequencies)
+                sum += std::sin (2.0 * kPi * f * i / sampleRate + f);
+            signals[1][static_cast<size_t> (i)] = static_cast<float> (0.5 * sum / std::size (frequencies));
+        }
+        // white, -15 dBFS RMS
+        std::mt19937 rng (1);
+        std::normal_distribution<double> noise (0.0, 0.18);
+        for (auto& sample : signals[2])
+            sample = static_cast<float> (std::clamp (noise (rng), -1.0, 1.0));
+        return signals;
+    }
+
+    class Renderer
+    {
+    public:
+        Renderer (const Variant& variant, size_t mode, const Options& options)
+        {
+            // settings first, prepare() jumps the smoothing to them
+            m_engine.setMode (static_cast<Type> (mode / kNumBrightness), static_cast<Brightness> (mode % kNumBrightness));
+            m_engine.setProcessing (options.process / 100.0);
+            m_engine.setAutoGain (true);
+            m_engine.setPrecision (variant.precision);
+            m_engine.setSaturatorTier (variant.saturatorTier);
+            m_engine.setAntialiasing (variant.antialiasing);
+            m_engine.prepare (1, options.sampleRate, kBlockSize, variant.oversamplingLog2, variant.phase, variant.internalRate);
+            m_latency = static_cast<size_t> (std::lround (m_engine.getLatency()));
+        }
+
+        // from a reset engine, time aligned with the input
+        std::vector<float> render (const std::vector<float>& input)
+        {
+            m_engine.reset();
+            std::vector<float> buffer (input.size() + m_latency);
+            std::copy (input.begin(), input.end(), buffer.begin());
+            const auto numSamples = static_cast<int> (buffer.size());
+            for (int offset = 0; offset < numSamples; offset += kBlockSize)
+            {
+                float* channels[] = { buffer.data() + offset };
+                m_engine.process (channels, 1, std::min (kBlockSize, numSamples - offset), 1.0f, 1.0f);
+            }
+            buffer.erase (buffer.begin(), buffer.begin() + static_cast<ptrdiff_t> (m_latency));
+            return buffer;
+        }
+
+    private:
+        Engine m_engine;
+        size_t m_latency { 0 };
+    };
+
+    // mean square of a bin-centred sinusoid in the analysed part
+    double getBinPower (const float* samples, int bin)
+    {
+        const double w = 2.0 * kPi * bin / kAnalysisLength, coefficient = 2.0 * std::cos (w);
+        double s1 = 0.0, s2 = 0.0;
+        for (int i = 0; i < kAnalysisLength; ++i)
+        {
+            const double s = samples[i] + coefficient * s1 - s2;
+            s2 = s1;
+            s1 = s;
+        }
+        const double magnitudeSquared = s1 * s1 + s2 * s2 - coefficient * s1 * s2;
+        return 2.0 * magnitudeSquared / (static_cast<double> (kAnalysisLength) * kAnalysisLength);
+    }
+
+    struct ToneAnalysis
+    {
+        // relative to the fundamental, dB
+        double thd, aliasing;
+    };
+
+    ToneAnalysis analyseTone (const std::vector<float>& output, int bin)
+    {
+        const auto* samples = output.data() + kSettleLength;
+        double mean = 0.0, total = 0.0;
+        for (int i = 0; i < kAnalysisLength; ++i)
+            mean += samples[i];
+        mean /= kAnalysisLength;
+        for (int i = 0; i < kAnalysisLength; ++i)
+            total += (samples[i] - mean) * (samples[i] - mean);
+        total /= kAnalysisLength;
+
+        const auto fundamental = getBinPower (samples, bin);
+        double harmonics = 0.0;
+        for (int h = 2; h * bin < kAnalysisLength / 2; ++h)
+            harmonics += getBinPower (samples, h * bin);
+        const auto aliasing = std::max (0.0, total - fundamental - harmonics);
+        const auto reference = std::max (fundamental, 1e-30);
+        return { 10.0 * std::log10 (std::max (harmonics, 1e-30) / reference), 10.0 * std::log10 (std::max (aliasing, 1e-30) / reference) };
+    }
+
+    struct Deviation
+    {
+        // dBFS, and dB relative to the golden signal
+        double max, rms;
+    };
+
+    Deviation compare (const std::vector<float>& output, const float* golden)
+    {
+        double maxError = 0.0, errorEnergy = 0.0, signalEnergy = 0.0;
+        for (size_t i = 0; i < output.size(); ++i)
+        {
+            const double error = static_cast<double> (output[i]) - golden[i];
+            maxError = std::max (maxError, std::abs (error));
+            errorEnergy += error * error;
+            signalEnergy += static_cast<double> (golden[i]) * golden[i];
+        }
+        return { toDecibels (maxError), toDecibels (std::sqrt (errorEnergy / std::max (signalEnergy, 1e-30))) };
+    }
+
+    struct GoldenHeader
+    {
+        uint32_t magic, version;
+        double sampleRate, process;
+        uint32_t numSamples, numRenders;
+    };
+
+    bool readGolden (const char* path, const Options& options, uint32_t numSamples, std::vector<float>& golden)
+    {
+        auto* file = std::fopen (path, "rb");
+        if (file == nullptr)
+        {
+            std::fprintf (stderr, "can't read %s\n", path);
+            return false;
+        }
+        GoldenHeader header {};
+        const auto ok = std::fread (&header, sizeof (header), 1, file) == 1 && header.magic == kGoldenMagic && header.version == kGoldenVersion
+                        && header.sampleRate == options.sampleRate && header.process == options.process && header.numSamples == numSamples
+                        && header.numRenders == kNumModes * kNumSignals && std::fread (golden.data(), sizeof (float), golden.size(), file) == golden.size();
+        std::fclose (file);
+        if (! ok)
+            std::fprintf (stderr, "%s isn't a golden reference for --rate %g --process %g --seconds %g\n", path, options.sampleRate, options.process, options.seconds);
+        return ok;
+    }
+
+    bool writeGolden (const char* path, const Options& options, uint32_t numSamples, const std::vector<float>& golden)
+    {
+        auto* file = std::fopen (path, "wb");
+        if (file == nullptr)
+            return false;
+        const GoldenHeader header { kGoldenMagic, kGoldenVersion, options.sampleRate, options.process, numSamples, static_cast<uint32_t> (kNumModes * kNumSignals) };
+        const auto ok = std::fwrite (&header, sizeof (header), 1, file) == 1 && std::fwrite (golden.data(), sizeof (float), golden.size(), file) == golden.size();
+        return std::fclose (file) == 0 && ok;
+    }
+
+    struct Result
+    {
+        ToneAnalysis tone, highTone;
+        // worst over the signals
+        Deviation deviation;
+        double nsPerSample;
+    };
+} // namespace
+
+int main (int argc, char** argv)
+{
+    Options options;
+    if (! parseOptions (argc, argv, options))
+        return 2;
+    const auto numSamples = static_cast<uint32_t> (options.seconds * options.sampleRate);
+    const auto signals = makeSignals (static_cast<int> (numSamples), options.sampleRate);
+    const auto lowBin = getToneBin (1000.0, options.sampleRate), highBin = getToneBin (6000.0, options.sampleRate);
+    const auto lowTone = makeTone (lowBin, 0.5), highTone = makeTone (highBin, 0.5);
+
+    // the golden renders, by mode and then signal
+    std::vector<float> golden (kNumModes * kNumSignals * numSamples);
+    const auto getGolden = [&] (size_t mode, size_t signal)
+    {
+        return golden.data() + (mode * kNumSignals + signal) * numSamples;
+    };
+    const auto storedGolden = options.goldenPath != nullptr;
+    if (storedGolden && ! readGolden (options.goldenPath, options, numSamples, golden))
+        return 1;
+    if (! storedGolden)
+    {
+        for (size_t mode = 0; mode < kNumModes; ++mode)
+        {
+            Renderer renderer (kVariants[0], mode, options);
+            for (size_t s = 0; s < kNumSignals; ++s)
+            {
+                const auto output = renderer.render (signals[s]);
+                std::copy (output.begin(), output.end(), getGolden (mode, s));
+            }
+        }
+    }
+    if (options.saveGoldenPath != nullptr && ! writeGolden (options.saveGoldenPath, options, numSamples, golden))
+    {
+        std::fprintf (stderr, "can't write %s\n", options.saveGoldenPath);
+        return 1;
+    }
+
+    std::printf ("%g Hz, Process %g%%, tones at %.0f and %.0f Hz, golden reference %s\n", options.sampleRate, options.process, lowBin * options.sampleRate / kAnalysisLength,
+                 highBin * options.sampleRate / kAnalysisLength, storedGolden ? options.goldenPath : "rendered now");
+    if (! options.summary)
+        std::printf ("\n%-17s %-12s %-9s %9s %9s %11s %11s %10s\n", "variant", "type", "bright", "THD dB", "alias dB", "max err dB", "rms err dB", "ns/sample");
+
+    using Clock = std::chrono::steady_clock;
+    std::vector<std::vector<Result>> results (std::size (kVariants));
+    for (size_t v = 0; v < std::size (kVariants); ++v)
+    {
+        for (size_t mode = 0; mode < kNumModes; ++mode)
+        {
+            Renderer renderer (kVariants[v], mode, options);
+            Result result {};
+            result.tone = analyseTone (renderer.render (lowTone), lowBin);
+            result.highTone = analyseTone (renderer.render (highTone), highBin);
+            result.deviation = { -400.0, -400.0 };
+            double elapsed = 0.0;
+            for (size_t s = 0; s < kNumSignals; ++s)
+            {
+                const auto start = Clock::now();
+                const auto output = renderer.render (signals[s]);
+                elapsed += std::chrono::duration<double, std::nano> (Clock::now() - start).count();
+                const auto deviation = compare (output, getGolden (mode, s));
+                result.deviation.max = std::max (result.deviation.max, deviation.max);
+                result.deviation.rms = std::max (result.deviation.rms, deviation.rms);
+            }
+            result.nsPerSample = elapsed / (static_cast<double> (numSamples) * kNumSignals);
+            results[v].push_back (result);
+
+            if (! options.summary)
+                std::printf ("%-17s %-12s %-9s %9.1f %9.1f %11.1f %11.1f %10.2f\n", kVariants[v].name, kTypeNames[mode / kNumBrightness], kBrightnessNames[mode % kNumBrightness], result.tone.thd,
+                             result.highTone.aliasing, result.deviation.max, result.deviation.rms, result.nsPerSample);
+        }
+    }
+
+    // worst case over the modes, changes against the reference variant
+    std::printf ("\n%-17s %10s %10s %11s %11s %10s %8s  %s\n", "variant", "THD +dB", "alias +dB", "max err dB", "rms err dB", "ns/sample", "cost", "verdict");
+    for (size_t v = 0; v < std::size (kVariants); ++v)
+    {
+        double thdChange = 0.0, aliasChange = -400.0, maxError = -400.0, rmsError = -400.0, ns = 0.0, referenceNs = 0.0;
+        for (size_t mode = 0; mode < kNumModes; ++mode)
+        {
+            const auto& r = results[v][mode];
+            const auto& reference = results[0][mode];
+            const auto thd = r.tone.thd - reference.tone.thd;
+            thdChange = std::abs (thd) > std::abs (thdChange) ? thd : thdChange;
+            aliasChange = std::max (aliasChange, r.highTone.aliasing - reference.highTone.aliasing);
+            maxError = std::max (maxError, r.deviation.max);
+            rmsError = std::max (rmsError, r.deviation.rms);
+            ns += r.nsPerSample;
+            referenceNs += reference.nsPerSample;
+        }
+        const char* verdict = "differs";
+        if (rmsError <= options.tolerance)
+            verdict = "equivalent";
+        else if (aliasChange <= -3.0 && std::abs (thdChange) <= 1.0)
+            verdict = "cleaner";
+        std::printf ("%-17s %+10.1f %+10.1f %11.1f %11.1f %10.2f %7.2fx  %s\n", kVariants[v].name, thdChange, aliasChange, maxError, rmsError, ns / kNumModes, ns / referenceNs, verdict);
+    }
+    return 0;
+}
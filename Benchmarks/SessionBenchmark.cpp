@@ -0,0 +1,359 @@
+// The plugin's processor at session scale: N TonixProcessors in a headless host, set up
+// like a mix template, so the costs a single engine hides show up. Construction (the
+// value tree, the undo manager, the parameters), prepareToPlay(), the cache pressure of
+// hundreds of instances sharing the audio thread, and saving and loading state.
+//
+//   TonixSessionBenchmark [--instances N] [--chain N] [--block N] [--rate HZ] [--seconds S]
+//                         [--automation FRACTION] [--state FILE]
+//
+// Instances sit in tracks of --chain in series; each callback runs every track and sums
+// them into a master bus, one thread like most hosts. --automation is the fraction of
+// instances whose Process and Input Trim move every block, delivered the way the plugin
+// wrappers do it; each of those also steps through the Types every second. --state loads
+// a saved plugin state into every instance first.
+//
+// Memory is resident memory, so allocations that nothing has touched yet don't count.
+// Cache misses come from perf on Linux where the kernel allows it: L1 data read misses
+// and last-level misses, as perf has no generic event for L2.
+
+#include "PluginProcessor.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#if JUCE_LINUX
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif JUCE_MAC
+#include <mach/mach.h>
+#endif
+
+using namespace juce;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Options
+    {
+        int instances { 200 };
+        int chain { 4 };
+        int blockSize { 256 };
+        double sampleRate { 48000.0 };
+        double seconds { 10.0 };
+        double automation { 0.1 };
+        File state;
+    };
+
+    Options parseOptions (int argc, char** argv)
+    {
+        Options options;
+        for (int i = 1; i + 1 < argc; i += 2)
+        {
+            if (std::strcmp (argv[i], "--instances") == 0)
+                options.instances = jlimit (1, 1000, std::atoi (argv[i + 1]));
+            else if (std::strcmp (argv[i], "--chain") == 0)
+                options.chain = std::max (1, std::atoi (argv[i + 1]));
+            else if (std::strcmp (argv[i], "--block") == 0)
+                options.blockSize = jlimit (1, 8192, std::atoi (argv[i + 1]));
+            else if (std::strcmp (argv[i], "--rate") == 0)
+                options.sampleRate = jlimit (8000.0, 768000.0, std::atof (argv[i + 1]));
+            else if (std::strcmp (argv[i], "--seconds") == 0)
+                options.seconds = std::max (0.1, std::atof (argv[i + 1]));
+            else if (std::strcmp (argv[i], "--automation") == 0)
+                options.automation = jlimit (0.0, 1.0, std::atof (argv[i + 1]));
+            else if (std::strcmp (argv[i], "--state") == 0)
+                options.state = File::getCurrentWorkingDirectory().getChildFile (argv[i + 1]);
+            else
+                std::fprintf (stderr, "unknown option %s\n", argv[i]);
+        }
+        return options;
+    }
+
+    // 0 where it can't be read
+    size_t getResidentBytes()
+    {
+#if JUCE_LINUX
+        long pages[2] {};
+        if (auto* file = std::fopen ("/proc/self/statm", "r"))
+        {
+            if (std::fscanf (file, "%ld %ld", &pages[0], &pages[1]) != 2)
+                pages[1] = 0;
+            std::fclose (file);
+        }
+        return static_cast<size_t> (pages[1]) * static_cast<size_t> (sysconf (_SC_PAGESIZE));
+#elif JUCE_MAC
+        mach_task_basic_info info {};
+        mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+        return task_info (mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t> (&info), &count) == KERN_SUCCESS ? static_cast<size_t> (info.resident_size) : 0;
+#else
+        return 0;
+#endif
+    }
+
+    // L1 data read misses and last-level misses of this thread
+    class CacheCounters
+    {
+    public:
+        CacheCounters()
+        {
+#if JUCE_LINUX
+            const uint64_t l1ReadMisses = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            m_fds[0] = open (PERF_TYPE_HW_CACHE, l1ReadMisses);
+            m_fds[1] = open (PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+#endif
+        }
+
+        ~CacheCounters()
+        {
+#if JUCE_LINUX
+            for (const auto fd : m_fds)
+                if (fd >= 0)
+                    close (fd);
+#endif
+        }
+
+        CacheCounters (const CacheCounters&) = delete;
+        CacheCounters& operator= (const CacheCounters&) = delete;
+
+        // -1 for a counter that isn't available
+        std::array<int64_t, 2> read() const
+        {
+            std::array<int64_t, 2> counts { -1, -1 };
+#if JUCE_LINUX
+            for (size_t i = 0; i < counts.size(); ++i)
+            {
+                uint64_t count = 0;
+                if (m_fds[i] >= 0 && ::read (m_fds[i], &count, sizeof (count)) == sizeof (count))
+                    counts[i] = static_cast<int64_t> (count);
+            }
+#endif
+            return counts;
+        }
+
+    private:
+#if JUCE_LINUX
+        static int open (uint32_t type, uint64_t config)
+        {
+            perf_event_attr attributes {};
+            attributes.type = type;
+            attributes.size = sizeof (attributes);
+            attributes.config = config;
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+            return static_cast<int> (syscall (SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+        }
+#endif
+        std::array<int, 2> m_fds { -1, -1 };
+    };
+
+    struct Stats
+    {
+        double mean, p50, p99, max;
+    };
+
+    Stats getStats (std::vector<double> values)
+    {
+        if (values.empty())
+            return {};
+        std::sort (values.begin(), values.end());
+        const auto at = [&] (double fraction)
+        {
+            return values[std::min (values.size() - 1, static_cast<size_t> (fraction * static_cast<double> (values.size())))];
+        };
+        double sum = 0.0;
+        for (const auto v : values)
+            sum += v;
+        return { sum / static_cast<double> (values.size()), at (0.5), at (0.99), values.back() };
+    }
+
+    void printStats (const char* name, const Stats& stats, const char* unit)
+    {
+        std::printf ("%-28s mean %9.2f  p50 %9.2f  p99 %9.2f  max %9.2f %s\n", name, stats.mean, stats.p50, stats.p99, stats.max, unit);
+    }
+
+    double getMicroseconds (Clock::time_point start, Clock::time_point end)
+    {
+        return std::chrono::duration<double, std::micro> (end - start).count();
+    }
+
+    // a parameter change as the plugin wrappers deliver host automation
+    void automate (RangedAudioParameter& parameter, float value)
+    {
+        parameter.setValue (value);
+        parameter.sendValueChangedMessageToListeners (value);
+    }
+} // namespace
+
+int main (int argc, char** argv)
+{
+    const ScopedJuceInitialiser_GUI juceInitialiser;
+    const auto options = parseOptions (argc, argv);
+    const auto numTracks = (options.instances + options.chain - 1) / options.chain;
+    std::printf ("%d instances in %d tracks, %d-sample blocks at %g Hz, %.0f%% automated\n", options.instances, numTracks, options.blockSize, options.sampleRate, options.automation * 100.0);
+
+    MemoryBlock savedState;
+    if (options.state != File() && ! options.state.loadFileAsData (savedState))
+    {
+        std::fprintf (stderr, "can't read %s\n", options.state.getFullPathName().toRawUTF8());
+        return 1;
+    }
+
+    // construction
+    std::vector<std::unique_ptr<TonixProcessor>> processors;
+    std::vector<double> times;
+    const auto residentBefore = getResidentBytes();
+    for (int i = 0; i < options.instances; ++i)
+    {
+        const auto start = Clock::now();
+        processors.push_back (std::make_unique<TonixProcessor>());
+        times.push_back (getMicroseconds (start, Clock::now()));
+    }
+    const auto residentConstructed = getResidentBytes();
+    printStats ("construct", getStats (times), "us");
+
+    // a spread of settings, like a real session, then the saved state if there is one
+    times.clear();
+    for (size_t i = 0; i < processors.size(); ++i)
+    {
+        auto& apvts = processors[i]->apvts;
+        automate (*apvts.getParameter ("type"), apvts.getParameter ("type")->convertTo0to1 (static_cast<float> (i % 5)));
+        automate (*apvts.getParameter ("brightness"), apvts.getParameter ("brightness")->convertTo0to1 (static_cast<float> (i / 5 % 3)));
+        automate (*apvts.getParameter ("process"), static_cast<float> (i % 11) / 10.0f);
+        if (savedState.getSize() > 0)
+        {
+            const auto start = Clock::now();
+            processors[i]->setStateInformation (savedState.getData(), static_cast<int> (savedState.getSize()));
+            times.push_back (getMicroseconds (start, Clock::now()));
+        }
+    }
+    if (! times.empty())
+        printStats ("load --state", getStats (times), "us");
+
+    times.clear();
+    for (auto& processor : processors)
+    {
+        const auto start = Clock::now();
+        processor->setPlayConfigDetails (2, 2, options.sampleRate, options.blockSize);
+        processor->setNonRealtime (false);
+        processor->prepareToPlay (options.sampleRate, options.blockSize);
+        times.push_back (getMicroseconds (start, Clock::now()));
+    }
+    const auto residentPrepared = getResidentBytes();
+    printStats ("prepareToPlay", getStats (times), "us");
+    if (residentPrepared > 0)
+        std::printf ("%-28s %9.1f KiB constructed, %9.1f KiB prepared\n", "resident per instance", (static_cast<double> (residentConstructed) - static_cast<double> (residentBefore)) / 1024.0 / options.instances,
+                     (static_cast<double> (residentPrepared) - static_cast<double> (residentBefore)) / 1024.0 / options.instances);
+
+    // playback
+    const auto numAutomated = static_cast<int> (std::lround (options.automation * options.instances));
+    const auto numCallbacks = static_cast<int> (std::ceil (options.seconds * options.sampleRate / options.blockSize));
+    const auto callbacksPerSecond = std::max (1, static_cast<int> (options.sampleRate / options.blockSize));
+    const auto deadline = options.blockSize / options.sampleRate * 1.0e6;
+    std::vector<AudioBuffer<float>> tracks (static_cast<size_t> (numTracks), AudioBuffer<float> (2, options.blockSize));
+    AudioBuffer<float> master (2, options.blockSize);
+    MidiBuffer midi;
+    std::vector<double> callbackTimes, instanceTimes;
+    callbackTimes.reserve (static_cast<size_t> (numCallbacks));
+    instanceTimes.reserve (static_cast<size_t> (numCallbacks) * processors.size());
+
+    const CacheCounters counters;
+    const auto countsBefore = counters.read();
+    int64_t sampleIndex = 0;
+    for (int callback = 0; callback < numCallbacks; ++callback)
+    {
+        // what the tracks' sources would have written
+        for (size_t t = 0; t < tracks.size(); ++t)
+            for (int ch = 0; ch < 2; ++ch)
+            {
+                auto* samples = tracks[t].getWritePointer (ch);
+                const auto frequency = 55.0 * (1.0 + static_cast<double> (t % 24)) * (ch == 0 ? 1.0 : 1.01);
+                for (int i = 0; i < options.blockSize; ++i)
+                    samples[i] = 0.3f * static_cast<float> (std::sin (MathConstants<double>::twoPi * frequency * static_cast<double> (sampleIndex + i) / options.sampleRate));
+            }
+        sampleIndex += options.blockSize;
+
+        const auto phase = static_cast<float> (callback) / static_cast<float> (callbacksPerSecond);
+        const auto callbackStart = Clock::now();
+        master.clear();
+        for (size_t t = 0; t < tracks.size(); ++t)
+        {
+            for (auto p = t * static_cast<size_t> (options.chain); p < std::min (processors.size(), (t + 1) * static_cast<size_t> (options.chain)); ++p)
+            {
+                auto& processor = *processors[p];
+                const auto start = Clock::now();
+                if (static_cast<int> (p) < numAutomated)
+                {
+                    auto& apvts = processor.apvts;
+                    automate (*apvts.getParameter ("process"), 0.5f + 0.4f * std::sin (MathConstants<float>::twoPi * (phase + static_cast<float> (p) * 0.01f)));
+                    automate (*apvts.getParameter ("inputTrim"), 0.5f + 0.2f * std::sin (MathConstants<float>::twoPi * 0.25f * phase));
+                    if (callback % callbacksPerSecond == 0)
+                        automate (*apvts.getParameter ("type"), apvts.getParameter ("type")->convertTo0to1 (static_cast<float> ((callback / callbacksPerSecond + static_cast<int> (p)) % 5)));
+                }
+                processor.processBlock (tracks[t], midi);
+                instanceTimes.push_back (getMicroseconds (start, Clock::now()));
+            }
+            for (int ch = 0; ch < 2; ++ch)
+                master.addFrom (ch, 0, tracks[t], ch, 0, options.blockSize);
+        }
+        callbackTimes.push_back (getMicroseconds (callbackStart, Clock::now()));
+    }
+    const auto countsAfter = counters.read();
+
+    const auto callbackStats = getStats (callbackTimes);
+    printStats ("callback", callbackStats, "us");
+    std::printf ("%-28s mean %8.1f%%  p99 %8.1f%%  max %8.1f%% of %.0f us, %d over\n", "deadline use", callbackStats.mean / deadline * 100.0, callbackStats.p99 / deadline * 100.0, callbackStats.max / deadline * 100.0, deadline,
+                 static_cast<int> (std::count_if (callbackTimes.begin(), callbackTimes.end(), [&] (double t)
+                                                  { return t > deadline; })));
+    printStats ("processBlock", getStats (instanceTimes), "us");
+
+    const char* counterNames[] = { "L1d read misses", "last-level misses" };
+    for (size_t i = 0; i < countsBefore.size(); ++i)
+    {
+        if (countsBefore[i] < 0 || countsAfter[i] < 0)
+            std::printf ("%-28s n/a\n", counterNames[i]);
+        else
+        {
+            const auto misses = static_cast<double> (countsAfter[i] - countsBefore[i]);
+            std::printf ("%-28s %12.0f per callback %10.1f per processBlock\n", counterNames[i], misses / numCallbacks, misses / static_cast<double> (instanceTimes.size()));
+        }
+    }
+
+    // state, as a host saves and reopens the session
+    std::vector<double> loadTimes;
+    times.clear();
+    size_t stateBytes = 0;
+    for (auto& processor : processors)
+    {
+        MemoryBlock state;
+        const auto start = Clock::now();
+        processor->getStateInformation (state);
+        const auto saved = Clock::now();
+        processor->setStateInformation (state.getData(), static_cast<int> (state.getSize()));
+        times.push_back (getMicroseconds (start, saved));
+        loadTimes.push_back (getMicroseconds (saved, Clock::now()));
+        stateBytes += state.getSize();
+    }
+    printStats ("getStateInformation", getStats (times), "us");
+    printStats ("setStateInformation", getStats (loadTimes), "us");
+    std::printf ("%-28s %9zu bytes per instance\n", "state", stateBytes / processors.size());
+
+    times.clear();
+    for (auto& processor : processors)
+    {
+        const auto start = Clock::now();
+        processor->releaseResources();
+        processor.reset();
+        times.push_back (getMicroseconds (start, Clock::now()));
+    }
+    printStats ("release and destroy", getStats (times), "us");
+    return 0;
+}
@@ -0,0 +1,162 @@
+// Drives the Tonix DSP directly, without the plugin wrapper.
+//
+// Compares the specialized per-Type kernels with the generic kernel that reads every
+// coefficient at runtime, for each Type x Brightness x auto-gain combination.
+//
+//   TonixBenchmark [--channels N] [--block N] [--seconds S] [--isa scalar|sse2|neon|avx2|avx512]
+//                  [--precision double|float] [--io float|double] [--antialiasing off|adaa]
+//                  [--saturator polynomial|table]
+//
+// Without --isa the kernels prepare() selects are used, so TONIX_ISA is honoured too.
+
+#include "DSP/ChannelBank.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace tonix;
+
+namespace
+{
+    constexpr const char* kTypeNames[] = { "Luminiscent", "Iridescent", "Radiant", "Luster", "DarkEssence" };
+    constexpr const char* kBrightnessNames[] = { "Opal", "Gold", "Sapphire" };
+
+    struct Options
+    {
+        int channels { 2 };
+        int blockSize { 512 };
+        double seconds { 0.25 };
+        double sampleRate { 48000.0 };
+        std::optional<Isa> isa;
+        Precision precision { Precision::Double };
+        // host buffer sample type
+        bool doubleIO { false };
+        Antialiasing antialiasing { Antialiasing::Off };
+        SaturatorTier saturatorTier { SaturatorTier::Polynomial };
+    };
+
+    Options parseOptions (int argc, char** argv)
+    {
+        Options options;
+        for (int i = 1; i + 1 < argc; i += 2)
+        {
+            if (std::strcmp (argv[i], "--channels") == 0)
+                options.channels = std::max (1, std::atoi (argv[i + 1]));
+            else if (std::strcmp (argv[i], "--block") == 0)
+                options.blockSize = std::max (1, std::atoi (argv[i + 1]));
+            else if (std::strcmp (argv[i], "--seconds") == 0)
+                options.seconds = std::max (0.01, std::atof (argv[i + 1]));
+            else if (std::strcmp (argv[i], "--precision") == 0)
+                options.precision = std::strcmp (argv[i + 1], "float") == 0 ? Precision::Float : Precision::Double;
+            else if (std::strcmp (argv[i], "--io") == 0)
+                options.doubleIO = std::strcmp (argv[i + 1], "double") == 0;
+            else if (std::strcmp (argv[i], "--antialiasing") == 0)
+                options.antialiasing = std::strcmp (argv[i + 1], "adaa") == 0 ? Antialiasing::Adaa : Antialiasing::Off;
+            else if (std::strcmp (argv[i], "--saturator") == 0)
+                options.saturatorTier = std::strcmp (argv[i + 1], "table") == 0 ? SaturatorTier::Table : SaturatorTier::Polynomial;
+            else if (std::strcmp (argv[i], "--isa") == 0)
+            {
+                options.isa = getIsaFromName (argv[i + 1]);
+                if (! options.isa || ! isIsaSupported (*options.isa))
+                {
+                    std::fprintf (stderr, "unsupported isa %s\n", argv[i + 1]);
+                    std::exit (1);
+                }
+            }
+            else
+                std::fprintf (stderr, "unknown option %s\n", argv[i]);
+        }
+        return options;
+    }
+
+    // ns per sample per channel
+    template <typename SampleType>
+    double measure (ChannelBank& bank, std::vector<std::vector<SampleType>>& buffers, const Options& options)
+    {
+        std::vector<SampleType*> channels;
+        for (auto& b : buffers)
+            channels.push_back (b.data());
+
+        // warm up caches and branch predictors
+        for (int i = 0; i < 16; ++i)
+            bank.process (channels.data(), options.channels, options.blockSize, 1.0f, 1.0f);
+
+        using Clock = std::chrono::steady_clock;
+        long long blocks = 0;
+        const auto start = Clock::now();
+        const auto end = start + std::chrono::duration<double> (options.seconds);
+        auto now = start;
+        while (now < end)
+        {
+            for (int i = 0; i < 64; ++i)
+                bank.process (channels.data(), options.channels, options.blockSize, 1.0f, 1.0f);
+            blocks += 64;
+            now = Clock::now();
+        }
+        const auto elapsed = std::chrono::duration<double, std::nano> (now - start).count();
+        return elapsed / (static_cast<double> (blocks) * options.blockSize * options.channels);
+    }
+} // namespace
+
+int main (int argc, char** argv)
+{
+    const auto options = parseOptions (argc, argv);
+
+    // -12 dBFS sine mix so every saturator region is exercised
+    std::vector<std::vector<float>> source (static_cast<size_t> (options.channels), std::vector<float> (static_cast<size_t> (options.blockSize)));
+    for (size_t ch = 0; ch < source.size(); ++ch)
+        for (size_t i = 0; i < source[ch].size(); ++i)
+            source[ch][i] = 0.25f * static_cast<float> (std::sin (0.031 * (double) i + (double) ch) + std::sin (0.17 * (double) i));
+
+    {
+        ChannelBank bank;
+        bank.forceIsa (options.isa);
+        bank.prepare (options.channels, options.sampleRate);
+        std::printf ("isa %s, %s, %s I/O, %s, %s saturators, channels %d, block %d\n", getIsaName (bank.getIsa()), options.precision == Precision::Float ? "float" : "double", options.doubleIO ? "double" : "float", options.antialiasing == Antialiasing::Adaa ? "ADAA" : "no ADAA", options.saturatorTier == SaturatorTier::Table ? "table" : "polynomial", options.channels, options.blockSize);
+    }
+    std::printf ("%-12s %-9s %-9s %12s %12s %8s\n", "type", "bright", "autogain", "generic ns", "special ns", "speedup");
+
+    for (size_t t = 0; t < kNumTypes; ++t)
+    {
+        for (size_t b = 0; b < kNumBrightness; ++b)
+        {
+            for (const bool autoGain : { false, true })
+            {
+                double results[2] {};
+                for (const bool specialized : { false, true })
+                {
+                    ChannelBank bank;
+                    bank.forceIsa (options.isa);
+                    bank.prepare (options.channels, options.sampleRate);
+                    bank.setMode (static_cast<Type> (t), static_cast<Brightness> (b));
+                    bank.setProcessing (0.5);
+                    bank.setAutoGain (autoGain);
+                    bank.setUseSpecializedKernels (specialized);
+                    bank.setPrecision (options.precision);
+                    bank.setAntialiasing (options.antialiasing);
+                    bank.setSaturatorTier (options.saturatorTier);
+                    if (options.doubleIO)
+                    {
+                        std::vector<std::vector<double>> buffers;
+                        for (const auto& ch : source)
+                            buffers.emplace_back (ch.begin(), ch.end());
+                        results[specialized ? 1 : 0] = measure (bank, buffers, options);
+                    }
+                    else
+                    {
+                        auto buffers = source;
+                        results[specialized ? 1 : 0] = measure (bank, buffers, options);
+                    }
+                }
+                std::printf ("%-12s %-9s %-9s %12.3f %12.3f %7.2fx\n", kTypeNames[t], kBrightnessNames[b], autoGain ? "on" : "off", results[0], results[1], results[0] / results[1]);
+            }
+        }
+    }
+    return 0;
+}
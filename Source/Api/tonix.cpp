@@ -0,0 +1,244 @@
+#include "tonix.h"
+
+#include "DSP/FloatMode.h"
+#include "DSP/ParallelEngine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <new>
+#include <vector>
+
+using namespace tonix;
+
+namespace
+{
+    struct Range
+    {
+        double min, max, defaultValue;
+        // choices and switches round to whole numbers
+        bool discrete;
+    };
+
+    // in the order of tonix_param, the plugin's ranges and defaults
+    constexpr Range kRanges[] = {
+        { -10.0, 10.0, 0.0, false },
+        { 0.0, 100.0, 0.0, false },
+        { -6.0, 6.0, 0.0, false },
+        { 0.0, static_cast<double> (kNumBrightness - 1), 1.0, true },
+        { 0.0, static_cast<double> (kNumTypes - 1), 1.0, true },
+        { 0.0, 1.0, 0.0, true },
+        { 0.0, 1.0, 1.0, true },
+        { 0.0, 1.0, 0.0, true },
+        { 0.0, 1.0, 0.0, true },
+        { 0.0, 1.0, 0.0, true },
+        { 1.0, static_cast<double> (1 << Oversampler::kMaxFactorLog2), 1.0, true },
+        { 0.0, 1.0, 0.0, true },
+        { 0.0, 2.0, 0.0, true },
+        { 0.0, 1.0, 0.0, true },
+    };
+    static_assert (std::size (kRanges) == TONIX_NUM_PARAMS);
+
+    // as juce::Decibels::decibelsToGain() computes the plugin's trims, so renders match
+    float decibelsToGain (float decibels)
+    {
+        return decibels > -100.0f ? std::pow (10.0f, decibels * 0.05f) : 0.0f;
+    }
+
+    bool isValid (tonix_param param)
+    {
+        return param >= 0 && param < TONIX_NUM_PARAMS;
+    }
+
+    // nothing may unwind into a C caller; the engine allocates and the worker pool
+    // starts threads, which throw std::system_error when the system says no
+    template <typename Function>
+    tonix_result guard (Function&& function)
+    {
+        try
+        {
+            function();
+            return TONIX_OK;
+        }
+        catch (const std::bad_alloc&)
+        {
+            return TONIX_ERROR_OUT_OF_MEMORY;
+        }
+        catch (...)
+        {
+            return TONIX_ERROR_SYSTEM;
+        }
+    }
+} // namespace
+
+struct tonix_engine
+{
+    tonix_engine()
+    {
+        for (size_t i = 0; i < std::size (kRanges); ++i)
+            values[i] = kRanges[i].defaultValue;
+        apply();
+    }
+
+    double get (tonix_param param) const { return values[static_cast<size_t> (param)]; }
+    int getChoice (tonix_param param) const { return static_cast<int> (get (param)); }
+
+    // hands the values over like the plugin's parameter snapshot; the engine's setters
+    // skip what didn't change
+    void apply()
+    {
+        // the plugin holds its parameters as floats
+        inputGain = decibelsToGain (static_cast<float> (get (TONIX_PARAM_INPUT_TRIM)));
+        outputGain = decibelsToGain (static_cast<float> (get (TONIX_PARAM_OUTPUT_TRIM)));
+        engine.setBypassed (getChoice (TONIX_PARAM_BYPASS) != 0);
+        engine.setMode (static_cast<Type> (getChoice (TONIX_PARAM_TYPE)), static_cast<Brightness> (getChoice (TONIX_PARAM_BRIGHTNESS)));
+        engine.setProcessing (static_cast<float> (get (TONIX_PARAM_PROCESS)) / 100.0);
+        engine.setAutoGain (getChoice (TONIX_PARAM_AUTO_GAIN) != 0);
+        engine.setPrecision (getChoice (TONIX_PARAM_PRECISION) != 0 ? Precision::Float : Precision::Double);
+        engine.setAntialiasing (getChoice (TONIX_PARAM_ANTIALIASING) != 0 ? Antialiasing::Adaa : Antialiasing::Off);
+        engine.setSaturatorTier (getChoice (TONIX_PARAM_SATURATOR_TIER) != 0 ? SaturatorTier::Table : SaturatorTier::Polynomial);
+    }
+
+    void prepare (int numChannels, double sampleRate, int maxBlockSize)
+    {
+        const auto oversamplingLog2 = static_cast<int> (std::lround (std::log2 (get (TONIX_PARAM_OVERSAMPLING))));
+        const auto phase = getChoice (TONIX_PARAM_OVERSAMPLING_PHASE) != 0 ? OversamplingPhase::Minimum : OversamplingPhase::Linear;
+        const auto rate = static_cast<InternalRate> (getChoice (TONIX_PARAM_INTERNAL_RATE));
+        auto* pool = getChoice (TONIX_PARAM_MULTICORE) != 0 ? &getWorkerPool() : nullptr;
+        engine.prepare (numChannels, sampleRate, maxBlockSize, oversamplingLog2, phase, rate, false, ParallelEngine::getNumSlices (numChannels, pool), pool);
+        engine.reset();
+        interleaved.assign (static_cast<size_t> (numChannels), std::vector<float> (static_cast<size_t> (maxBlockSize)));
+        channels.resize (interleaved.size());
+        for (size_t ch = 0; ch < channels.size(); ++ch)
+            channels[ch] = interleaved[ch].data();
+        this->numChannels = numChannels;
+        this->maxBlockSize = maxBlockSize;
+    }
+
+    ParallelEngine engine;
+    double values[TONIX_NUM_PARAMS] {};
+    float inputGain { 1.0f }, outputGain { 1.0f };
+
+    // 0 until prepared
+    int numChannels { 0 }, maxBlockSize { 0 };
+    // planar copies of an interleaved block
+    std::vector<std::vector<float>> interleaved;
+    std::vector<float*> channels;
+};
+
+extern "C"
+{
+    int tonix_get_api_version (void)
+    {
+        return TONIX_API_VERSION;
+    }
+
+    tonix_engine* tonix_create (void)
+    {
+        tonix_engine* engine = nullptr;
+        guard ([&engine]
+               { engine = new tonix_engine(); });
+        return engine;
+    }
+
+    void tonix_destroy (tonix_engine* engine)
+    {
+        delete engine;
+    }
+
+    tonix_result tonix_prepare (tonix_engine* engine, int num_channels, double sample_rate, int max_block_size)
+    {
+        if (engine == nullptr || num_channels <= 0 || ! std::isfinite (sample_rate) || sample_rate <= 0.0 || max_block_size <= 0)
+            return TONIX_ERROR_INVALID_ARGUMENT;
+        const auto result = guard ([&]
+                                   { engine->prepare (num_channels, sample_rate, max_block_size); });
+        // half prepared, it must not process
+        if (result != TONIX_OK)
+            engine->numChannels = 0;
+        return result;
+    }
+
+    void tonix_reset (tonix_engine* engine)
+    {
+        if (engine != nullptr)
+            engine->engine.reset();
+    }
+
+    tonix_result tonix_set_param (tonix_engine* engine, tonix_param param, double value)
+    {
+        if (engine == nullptr || ! isValid (param) || std::isnan (value))
+            return TONIX_ERROR_INVALID_ARGUMENT;
+        const auto& range = kRanges[param];
+        value = std::clamp (value, range.min, range.max);
+        if (range.discrete)
+            value = std::round (value);
+        // the oversampling factor is a power of two
+        if (param == TONIX_PARAM_OVERSAMPLING)
+            value = std::exp2 (std::floor (std::log2 (value)));
+        engine->values[param] = value;
+        return guard ([engine]
+                      { engine->apply(); });
+    }
+
+    double tonix_get_param (const tonix_engine* engine, tonix_param param)
+    {
+        return engine != nullptr && isValid (param) ? engine->get (param) : 0.0;
+    }
+
+    double tonix_get_latency (const tonix_engine* engine)
+    {
+        return engine != nullptr && engine->numChannels > 0 ? engine->engine.getLatency() : 0.0;
+    }
+
+    double tonix_get_tail_length (const tonix_engine* engine)
+    {
+        return engine != nullptr && engine->numChannels > 0 ? engine->engine.getTailLength() : 0.0;
+    }
+
+    tonix_result tonix_process_planar (tonix_engine* engine, float* const* channels, int num_channels, int num_frames)
+    {
+        if (engine == nullptr || channels == nullptr || num_channels < 0 || num_frames < 0)
+            return TONIX_ERROR_INVALID_ARGUMENT;
+        if (engine->numChannels == 0)
+            return TONIX_ERROR_NOT_PREPARED;
+        const ScopedFlushToZero flushToZero;
+        engine->engine.process (channels, std::min (num_channels, engine->numChannels), num_frames, engine->inputGain, engine->outputGain);
+        return TONIX_OK;
+    }
+
+    tonix_result tonix_process_planar_double (tonix_engine* engine, double* const* channels, int num_channels, int num_frames)
+    {
+        if (engine == nullptr || channels == nullptr || num_channels < 0 || num_frames < 0)
+            return TONIX_ERROR_INVALID_ARGUMENT;
+        if (engine->numChannels == 0)
+            return TONIX_ERROR_NOT_PREPARED;
+        const ScopedFlushToZero flushToZero;
+        engine->engine.process (channels, std::min (num_channels, engine->numChannels), num_frames, engine->inputGain, engine->outputGain);
+        return TONIX_OK;
+    }
+
+    tonix_result tonix_process_interleaved (tonix_engine* engine, float* samples, int num_channels, int num_frames)
+    {
+        if (engine == nullptr || samples == nullptr || num_channels < 0 || num_frames < 0)
+            return TONIX_ERROR_INVALID_ARGUMENT;
+        if (engine->numChannels == 0)
+            return TONIX_ERROR_NOT_PREPARED;
+        if (num_channels > engine->numChannels)
+            return TONIX_ERROR_INVALID_ARGUMENT;
+
+        const ScopedFlushToZero flushToZero;
+        const auto stride = static_cast<size_t> (num_channels);
+        for (int offset = 0; offset < num_frames; offset += engine->maxBlockSize)
+        {
+            const auto n = std::min (engine->maxBlockSize, num_frames - offset);
+            float* frames = samples + static_cast<size_t> (offset) * stride;
+            for (size_t ch = 0; ch < stride; ++ch)
+                for (int i = 0; i < n; ++i)
+                    engine->channels[ch][i] = frames[static_cast<size_t> (i) * stride + ch];
+            engine->engine.process (engine->channels.data(), num_channels, n, engine->inputGain, engine->outputGain);
+            for (size_t ch = 0; ch < stride; ++ch)
+                for (int i = 0; i < n; ++i)
+                    frames[static_cast<size_t> (i) * stride + ch] = engine->channels[ch][i];
+        }
+        return TONIX_OK;
+    }
+}
@@ -0,0 +1,103 @@
+/* Plain C interface to the Tonix engine, stable across compilers and releases: an
+ * opaque handle, parameters by number and in-place processing. Parameters take the
+ * plugin's units and ranges, so the same values render the same output.
+ *
+ * An engine is used from one thread at a time. tonix_create(), tonix_prepare() and
+ * tonix_destroy() allocate; the other calls are real-time safe once prepared. */
+
+#ifndef TONIX_H
+#define TONIX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(TONIX_SHARED)
+#if defined(_WIN32)
+#if defined(TONIX_BUILDING)
+#define TONIX_API __declspec(dllexport)
+#else
+#define TONIX_API __declspec(dllimport)
+#endif
+#else
+#define TONIX_API __attribute__((visibility ("default")))
+#endif
+#else
+#define TONIX_API
+#endif
+
+/* bumped when a call or parameter changes meaning; additions keep it */
+#define TONIX_API_VERSION 1
+
+typedef struct tonix_engine tonix_engine;
+
+typedef enum tonix_result
+{
+    TONIX_OK = 0,
+    TONIX_ERROR_INVALID_ARGUMENT = -1,
+    TONIX_ERROR_NOT_PREPARED = -2,
+    TONIX_ERROR_OUT_OF_MEMORY = -3,
+    /* the system turned down something else, such as the worker threads */
+    TONIX_ERROR_SYSTEM = -4
+} tonix_result;
+
+typedef enum tonix_param
+{
+    /* automatable, like the plugin's parameters */
+    TONIX_PARAM_INPUT_TRIM = 0, /* dB, -10 to 10, default 0 */
+    TONIX_PARAM_PROCESS, /* percent, 0 to 100, default 0; glides over 20 ms */
+    TONIX_PARAM_OUTPUT_TRIM, /* dB, -6 to 6, default 0 */
+    TONIX_PARAM_BRIGHTNESS, /* 0 Opal, 1 Gold, 2 Sapphire; default 1 */
+    TONIX_PARAM_TYPE, /* 0 Luminiscent, 1 Iridescent, 2 Radiant, 3 Luster, 4 Dark Essence; default 1 */
+    TONIX_PARAM_BYPASS, /* 0 or 1, crossfades; default 0 */
+    TONIX_PARAM_AUTO_GAIN, /* 0 or 1, default 1 */
+
+    /* engine settings, like the plugin's menu */
+    TONIX_PARAM_PRECISION, /* 0 double, 1 float; default 0 */
+    TONIX_PARAM_ANTIALIASING, /* 0 off, 1 ADAA; default 0 */
+    TONIX_PARAM_SATURATOR_TIER, /* 0 polynomial, 1 table; default 0 */
+    /* these three take effect at the next tonix_prepare() */
+    TONIX_PARAM_OVERSAMPLING, /* factor 1, 2, 4 or 8; default 1 */
+    TONIX_PARAM_OVERSAMPLING_PHASE, /* 0 linear, 1 minimum; default 0 */
+    TONIX_PARAM_INTERNAL_RATE, /* 0 host, 1 44.1/48 kHz, 2 88.2/96 kHz; default 0 */
+    TONIX_PARAM_MULTICORE, /* 0 or 1, spreads wide layouts over the CPU cores; default 0 */
+
+    TONIX_NUM_PARAMS
+} tonix_param;
+
+/* TONIX_API_VERSION of the library, which may be newer than the header */
+TONIX_API int tonix_get_api_version (void);
+
+/* NULL if out of memory or the system turned it down */
+TONIX_API tonix_engine* tonix_create (void);
+/* accepts NULL */
+TONIX_API void tonix_destroy (tonix_engine* engine);
+
+/* Allocates for up to num_channels and max_block_size frames per call to the interleaved
+ * process; the planar ones take any length. Parameters survive, the audio state clears. */
+TONIX_API tonix_result tonix_prepare (tonix_engine* engine, int num_channels, double sample_rate, int max_block_size);
+/* clears the audio state, Process and the trims jump to their values */
+TONIX_API void tonix_reset (tonix_engine* engine);
+
+/* values outside a parameter's range are clamped; choices round to the nearest */
+TONIX_API tonix_result tonix_set_param (tonix_engine* engine, tonix_param param, double value);
+/* 0 for unknown parameters */
+TONIX_API double tonix_get_param (const tonix_engine* engine, tonix_param param);
+
+/* in samples at the prepared rate */
+TONIX_API double tonix_get_latency (const tonix_engine* engine);
+/* samples until the output is silent once the input stops, latency included */
+TONIX_API double tonix_get_tail_length (const tonix_engine* engine);
+
+/* In place. num_channels may be below the prepared count. Processing runs with
+ * flush-to-zero, as the plugin's does; the caller's mode is restored on return. */
+TONIX_API tonix_result tonix_process_planar (tonix_engine* engine, float* const* channels, int num_channels, int num_frames);
+TONIX_API tonix_result tonix_process_planar_double (tonix_engine* engine, double* const* channels, int num_channels, int num_frames);
+/* frames of num_channels samples each, in chunks of the prepared block size */
+TONIX_API tonix_result tonix_process_interleaved (tonix_engine* engine, float* samples, int num_channels, int num_frames);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,120 @@
+#pragma once
+
+// Header-only C++ wrapper of the C interface in tonix.h: the handle's lifetime as an
+// object and failures as exceptions, with nothing of the library's own C++ in the way,
+// so it works across compilers and standard libraries.
+
+#include "tonix.h"
+
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+namespace tonix::api
+{
+    enum class Parameter
+    {
+        InputTrim = TONIX_PARAM_INPUT_TRIM,
+        Process = TONIX_PARAM_PROCESS,
+        OutputTrim = TONIX_PARAM_OUTPUT_TRIM,
+        Brightness = TONIX_PARAM_BRIGHTNESS,
+        Type = TONIX_PARAM_TYPE,
+        Bypass = TONIX_PARAM_BYPASS,
+        AutoGain = TONIX_PARAM_AUTO_GAIN,
+        Precision = TONIX_PARAM_PRECISION,
+        Antialiasing = TONIX_PARAM_ANTIALIASING,
+        SaturatorTier = TONIX_PARAM_SATURATOR_TIER,
+        Oversampling = TONIX_PARAM_OVERSAMPLING,
+        OversamplingPhase = TONIX_PARAM_OVERSAMPLING_PHASE,
+        InternalRate = TONIX_PARAM_INTERNAL_RATE,
+        Multicore = TONIX_PARAM_MULTICORE
+    };
+
+    // one engine, see tonix.h for the calls behind each method
+    class Processor
+    {
+    public:
+        Processor()
+            : m_engine (tonix_create())
+        {
+            if (m_engine == nullptr)
+                throw std::bad_alloc();
+        }
+
+        ~Processor() { tonix_destroy (m_engine); }
+
+        Processor (Processor&& other) noexcept
+            : m_engine (std::exchange (other.m_engine, nullptr))
+        {
+        }
+
+        Processor& operator= (Processor&& other) noexcept
+        {
+            std::swap (m_engine, other.m_engine);
+            return *this;
+        }
+
+        Processor (const Processor&) = delete;
+        Processor& operator= (const Processor&) = delete;
+
+        void prepare (int numChannels, double sampleRate, int maxBlockSize)
+        {
+            check (tonix_prepare (m_engine, numChannels, sampleRate, maxBlockSize));
+        }
+
+        void reset() noexcept { tonix_reset (m_engine); }
+
+        void setParameter (Parameter param, double value)
+        {
+            check (tonix_set_param (m_engine, static_cast<tonix_param> (param), value));
+        }
+
+        double getParameter (Parameter param) const noexcept
+        {
+            return tonix_get_param (m_engine, static_cast<tonix_param> (param));
+        }
+
+        double getLatency() const noexcept { return tonix_get_latency (m_engine); }
+        double getTailLength() const noexcept { return tonix_get_tail_length (m_engine); }
+
+        // in place
+        void process (float* const* channels, int numChannels, int numFrames)
+        {
+            check (tonix_process_planar (m_engine, channels, numChannels, numFrames));
+        }
+
+        void process (double* const* channels, int numChannels, int numFrames)
+        {
+            check (tonix_process_planar_double (m_engine, channels, numChannels, numFrames));
+        }
+
+        void processInterleaved (float* samples, int numChannels, int numFrames)
+        {
+            check (tonix_process_interleaved (m_engine, samples, numChannels, numFrames));
+        }
+
+        // for calling the C interface directly
+        tonix_engine* getHandle() const noexcept { return m_engine; }
+
+    private:
+        static void check (tonix_result result)
+        {
+            switch (result)
+            {
+                case TONIX_OK:
+                    return;
+                case TONIX_ERROR_OUT_OF_MEMORY:
+                    throw std::bad_alloc();
+                case TONIX_ERROR_NOT_PREPARED:
+                    throw std::logic_error ("tonix: process before prepare");
+                case TONIX_ERROR_SYSTEM:
+                    throw std::runtime_error ("tonix: system error");
+                case TONIX_ERROR_INVALID_ARGUMENT:
+                default:
+                    throw std::invalid_argument ("tonix: invalid argument");
+            }
+        }
+
+        tonix_engine* m_engine { nullptr };
+    };
+} // namespace tonix::api
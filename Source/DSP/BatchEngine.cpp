@@ -0,0 +1,261 @@
+#include "BatchEngine.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace tonix
+{
+    void BatchEngine::Group::resize (size_t paddedStreams)
+    {
+        size = 0;
+        ids.assign (paddedStreams, 0);
+        for (auto* array : { &hpf_k, &lpf_k, &processing, &autoGain, &lpfState, &prevInput, &prevDrive, &prevBlend })
+            array->assign (paddedStreams, 0.0);
+        inputGain.assign (paddedStreams, 1.0f);
+        outputGain.assign (paddedStreams, 1.0f);
+    }
+
+    void BatchEngine::Group::clear (int position)
+    {
+        const auto i = static_cast<size_t> (position);
+        for (auto* array : { &hpf_k, &lpf_k, &processing, &autoGain, &lpfState, &prevInput, &prevDrive, &prevBlend })
+            (*array)[i] = 0.0;
+    }
+
+    void BatchEngine::Group::copy (int from, Group& to, int toPosition) const
+    {
+        const auto i = static_cast<size_t> (from);
+        const auto j = static_cast<size_t> (toPosition);
+        to.ids[j] = ids[i];
+        to.hpf_k[j] = hpf_k[i];
+        to.lpf_k[j] = lpf_k[i];
+        to.processing[j] = processing[i];
+        to.autoGain[j] = autoGain[i];
+        to.inputGain[j] = inputGain[i];
+        to.outputGain[j] = outputGain[i];
+        to.lpfState[j] = lpfState[i];
+        to.prevInput[j] = prevInput[i];
+        to.prevDrive[j] = prevDrive[i];
+        to.prevBlend[j] = prevBlend[i];
+    }
+
+    void BatchEngine::prepare (int maxStreams, double sampleRate)
+    {
+        maxStreams = std::max (0, maxStreams);
+        // like ChannelBank
+        m_srScale = 1.0 / std::max (1.0, std::floor (sampleRate / 44100.0));
+
+        // any stream can take any Type, and a group's last lanes are read past its size
+        const auto padded = (static_cast<size_t> (maxStreams) + kMaxLanes - 1) / kMaxLanes * kMaxLanes;
+        for (auto& group : m_groups)
+            group.resize (padded);
+        m_streams.assign (static_cast<size_t> (maxStreams), Stream());
+        m_freeIds.resize (static_cast<size_t> (maxStreams));
+        // the lowest id first
+        for (int id = 0; id < maxStreams; ++id)
+            m_freeIds[static_cast<size_t> (id)] = maxStreams - 1 - id;
+
+        m_input.assign ((kChunkSize + 1) * kMaxLanes, 0.0);
+        m_work.assign (kChunkSize * kMaxLanes, 0.0);
+        m_inputFloat.assign ((kChunkSize + 1) * kMaxLanes, 0.0f);
+        m_workFloat.assign (kChunkSize * kMaxLanes, 0.0f);
+
+        m_saturatorTables = &getSaturatorTables();
+        m_isa = m_forcedIsa && isIsaSupported (*m_forcedIsa) ? *m_forcedIsa : getPreferredIsa();
+        m_kernels = &getKernelTable (m_isa);
+        updateKernels();
+    }
+
+    void BatchEngine::reset()
+    {
+        for (auto& group : m_groups)
+            for (auto* array : { &group.lpfState, &group.prevInput, &group.prevDrive, &group.prevBlend })
+                std::fill (array->begin(), array->end(), 0.0);
+    }
+
+    int BatchEngine::addStream (Type type, Brightness brightness)
+    {
+        if (m_freeIds.empty())
+            return kNoStream;
+        const auto id = m_freeIds.back();
+        m_freeIds.pop_back();
+
+        auto& stream = m_streams[static_cast<size_t> (id)];
+        stream = Stream();
+        stream.type = type;
+        stream.brightness = brightness;
+        auto& group = getGroup (stream);
+        stream.position = group.size++;
+        const auto position = static_cast<size_t> (stream.position);
+        group.ids[position] = id;
+        group.inputGain[position] = 1.0f;
+        group.outputGain[position] = 1.0f;
+        updateCoefficients (stream);
+        resetStream (id);
+        return id;
+    }
+
+    void BatchEngine::removeStream (int id)
+    {
+        if (! isStream (id))
+            return;
+        auto& stream = m_streams[static_cast<size_t> (id)];
+        unpack (stream);
+        stream.position = -1;
+        m_freeIds.push_back (id);
+    }
+
+    void BatchEngine::unpack (const Stream& stream)
+    {
+        // the group's last stream fills the gap
+        auto& group = getGroup (stream);
+        const auto last = --group.size;
+        if (stream.position != last)
+        {
+            group.copy (last, group, stream.position);
+            m_streams[static_cast<size_t> (group.ids[static_cast<size_t> (stream.position)])].position = stream.position;
+        }
+        group.clear (last);
+    }
+
+    bool BatchEngine::isStream (int id) const
+    {
+        return id >= 0 && id < getMaxStreams() && m_streams[static_cast<size_t> (id)].position >= 0;
+    }
+
+    void BatchEngine::setMode (int id, Type type, Brightness brightness)
+    {
+        if (! isStream (id))
+            return;
+        auto& stream = m_streams[static_cast<size_t> (id)];
+        if (type != stream.type)
+        {
+            // moves over to the new Type's group with its memory and trims
+            auto& from = getGroup (stream);
+            auto& to = m_groups[static_cast<size_t> (type)];
+            const auto position = to.size++;
+            from.copy (stream.position, to, position);
+            unpack (stream);
+            stream.position = position;
+            stream.type = type;
+        }
+        stream.brightness = brightness;
+        updateCoefficients (stream);
+    }
+
+    void BatchEngine::setProcessing (int id, double amount)
+    {
+        if (! isStream (id))
+            return;
+        auto& stream = m_streams[static_cast<size_t> (id)];
+        stream.processing = amount;
+        updateCoefficients (stream);
+    }
+
+    void BatchEngine::setAutoGain (int id, bool shouldUseAutoGain)
+    {
+        if (! isStream (id))
+            return;
+        auto& stream = m_streams[static_cast<size_t> (id)];
+        stream.useAutoGain = shouldUseAutoGain;
+        updateCoefficients (stream);
+    }
+
+    void BatchEngine::setGains (int id, float inputGain, float outputGain)
+    {
+        if (! isStream (id))
+            return;
+        const auto& stream = m_streams[static_cast<size_t> (id)];
+        auto& group = getGroup (stream);
+        group.inputGain[static_cast<size_t> (stream.position)] = inputGain;
+        group.outputGain[static_cast<size_t> (stream.position)] = outputGain;
+    }
+
+    void BatchEngine::resetStream (int id)
+    {
+        if (! isStream (id))
+            return;
+        const auto& stream = m_streams[static_cast<size_t> (id)];
+        auto& group = getGroup (stream);
+        const auto position = static_cast<size_t> (stream.position);
+        group.lpfState[position] = group.prevInput[position] = group.prevDrive[position] = group.prevBlend[position] = 0.0;
+    }
+
+    void BatchEngine::updateCoefficients (const Stream& stream)
+    {
+        const auto& mode = getModeCoefficients (stream.type, stream.brightness);
+        auto& group = getGroup (stream);
+        const auto position = static_cast<size_t> (stream.position);
+        const auto p = stream.processing;
+        // sample-rate scale and auto-gain like ChannelBank; a gain of exactly 1 leaves the
+        // output as the kernels without auto-gain compute it
+        group.hpf_k[position] = mode.hpf_k * m_srScale;
+        group.lpf_k[position] = mode.lpf_k * m_srScale;
+        group.processing[position] = p;
+        group.autoGain[position] = stream.useAutoGain ? 1.0 + p * mode.autoGain_a1 + p * p * mode.autoGain_a2 : 1.0;
+    }
+
+    void BatchEngine::setPrecision (Precision precision)
+    {
+        m_precision = precision;
+        updateKernels();
+    }
+
+    void BatchEngine::setAntialiasing (Antialiasing antialiasing)
+    {
+        m_antialiasing = antialiasing;
+        updateKernels();
+    }
+
+    void BatchEngine::setSaturatorTier (SaturatorTier tier)
+    {
+        m_saturatorTier = tier;
+        updateKernels();
+    }
+
+    void BatchEngine::forceIsa (std::optional<Isa> isa)
+    {
+        m_forcedIsa = isa;
+    }
+
+    void BatchEngine::updateKernels()
+    {
+        // same precedence as ChannelBank::updateKernel()
+        auto shaping = Shaping::Polynomial;
+        if (m_antialiasing == Antialiasing::Adaa)
+            shaping = Shaping::Adaa;
+        else if (m_saturatorTier == SaturatorTier::Table && m_saturatorTables != nullptr)
+            shaping = Shaping::Table;
+        m_batchKernels = m_kernels->batch[static_cast<size_t> (m_precision)][static_cast<size_t> (shaping)];
+    }
+
+    void BatchEngine::process (float* const* streams, int numSamples)
+    {
+        for (auto& group : m_groups)
+        {
+            if (group.size == 0)
+                continue;
+            BatchArgs args;
+            args.streams = streams;
+            args.ids = group.ids.data();
+            args.numStreams = group.size;
+            args.numSamples = numSamples;
+            args.hpf_k = group.hpf_k.data();
+            args.lpf_k = group.lpf_k.data();
+            args.processing = group.processing.data();
+            args.autoGain = group.autoGain.data();
+            args.inputGain = group.inputGain.data();
+            args.outputGain = group.outputGain.data();
+            args.lpfState = group.lpfState.data();
+            args.prevInput = group.prevInput.data();
+            args.prevDrive = group.prevDrive.data();
+            args.prevBlend = group.prevBlend.data();
+            args.saturatorTables = m_saturatorTables;
+            args.input = m_input.data();
+            args.work = m_work.data();
+            args.inputFloat = m_inputFloat.data();
+            args.workFloat = m_workFloat.data();
+            m_batchKernels[static_cast<size_t> (&group - m_groups.data())] (args);
+        }
+    }
+} // namespace tonix
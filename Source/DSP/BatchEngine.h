@@ -0,0 +1,129 @@
+#pragma once
+
+#include "Coefficients.h"
+#include "Kernels.h"
+
+#include <array>
+#include <optional>
+#include <vector>
+
+namespace tonix
+{
+    // Many independent mono streams, such as the voices or objects of a game mixer, each
+    // with its own Type, Brightness, Process, auto-gain and trims. Only the channel math
+    // runs: no oversampling, smoothing, bypass or sleep.
+    //
+    // The streams of each Type are packed struct-of-arrays, so a register-wide group of
+    // them runs the whole chain together like ChannelBank's lane groups, every lane with
+    // its own coefficients. A stream's output matches a ChannelBank channel with the
+    // same settings. The cost per stream stays flat with the count, at most one partly
+    // filled group per Type aside; below a few dozen streams a ChannelBank each is
+    // cheaper.
+    //
+    // Like the plugin, expects flush-to-zero on the calling thread: quiet input runs
+    // into subnormals in the saturators' higher powers otherwise.
+    //
+    // prepare() allocates room for every stream in every Type. Adding, removing and
+    // changing streams afterwards is real-time safe.
+    class BatchEngine
+    {
+    public:
+        // from addStream() once every stream is taken
+        static constexpr int kNoStream = -1;
+
+        // allocates and selects the instruction set, call before anything else;
+        // removes all streams
+        void prepare (int maxStreams, double sampleRate);
+        // clears the memory of every stream
+        void reset();
+
+        // returns the stream's id, the index of its buffer in process() until it is
+        // removed; starts cleared, at 0% Process, with auto-gain and unity trims
+        int addStream (Type, Brightness);
+        void removeStream (int id);
+        bool isStream (int id) const;
+
+        // ignored for ids that aren't added; a new mode keeps the stream's memory, like
+        // ChannelBank
+        void setMode (int id, Type, Brightness);
+        void setProcessing (int id, double amount);
+        void setAutoGain (int id, bool shouldUseAutoGain);
+        void setGains (int id, float inputGain, float outputGain);
+        void resetStream (int id);
+
+        // shared by all streams, see ChannelBank
+        void setPrecision (Precision);
+        Precision getPrecision() const { return m_precision; }
+        void setAntialiasing (Antialiasing);
+        Antialiasing getAntialiasing() const { return m_antialiasing; }
+        void setSaturatorTier (SaturatorTier);
+        SaturatorTier getSaturatorTier() const { return m_saturatorTier; }
+
+        // for testing, overrides getPreferredIsa() from the next prepare() on
+        void forceIsa (std::optional<Isa>);
+        Isa getIsa() const { return m_isa; }
+
+        int getMaxStreams() const { return static_cast<int> (m_streams.size()); }
+        int getNumStreams() const { return getMaxStreams() - static_cast<int> (m_freeIds.size()); }
+
+        // in place; streams[id] for every added stream, other entries aren't read
+        void process (float* const* streams, int numSamples);
+
+    private:
+        // one Type's streams, packed in the first size entries of each array
+        struct Group
+        {
+            void resize (size_t paddedStreams);
+            // copies a stream's entries, memory included
+            void copy (int from, Group& to, int toPosition) const;
+            // the entries past size stay cleared: without an LPF the kernels' spare lanes
+            // keep their memory at zero
+            void clear (int position);
+
+            int size { 0 };
+            std::vector<int> ids;
+            std::vector<double> hpf_k, lpf_k, processing, autoGain;
+            std::vector<float> inputGain, outputGain;
+            std::vector<double> lpfState, prevInput, prevDrive, prevBlend;
+        };
+
+        struct Stream
+        {
+            // -1 while the id is free
+            int position { -1 };
+            Type type { Type::Iridescent };
+            Brightness brightness { Brightness::Gold };
+            double processing { 0.0 };
+            bool useAutoGain { true };
+        };
+
+        Group& getGroup (const Stream& stream) { return m_groups[static_cast<size_t> (stream.type)]; }
+        // takes the stream's entries out of its group
+        void unpack (const Stream&);
+        // refreshes the stream's coefficients in its group
+        void updateCoefficients (const Stream&);
+        void updateKernels();
+
+        double m_srScale { 1.0 };
+        Precision m_precision { Precision::Double };
+        Antialiasing m_antialiasing { Antialiasing::Off };
+        SaturatorTier m_saturatorTier { SaturatorTier::Polynomial };
+        const SaturatorTables* m_saturatorTables { nullptr };
+
+        std::optional<Isa> m_forcedIsa;
+        Isa m_isa { Isa::Scalar };
+        const KernelTable* m_kernels { &getKernelTable (Isa::Scalar) };
+        // by Type
+        std::array<BatchKernel, kNumTypes> m_batchKernels {};
+
+        std::array<Group, kNumTypes> m_groups;
+        // by id
+        std::vector<Stream> m_streams;
+        // taken from the back
+        std::vector<int> m_freeIds;
+
+        // scratch, frames interleaved by lane
+        std::vector<double> m_input, m_work;
+        std::vector<float> m_inputFloat, m_workFloat;
+    };
+} // namespace tonix
@@ -0,0 +1,80 @@
+#include "Channel.h"
+
+namespace tonix
+{
+    template <typename T>
+    void Channel<T>::reset()
+    {
+        processing = 0.0;
+        curProcessing = T (0);
+        s = T (0);
+        prev_x = T (0);
+        prevDrive = T (0);
+        prevBlend = T (0);
+    }
+
+    template <typename T>
+    void Channel<T>::setProcessing (const double amount)
+    {
+        processing = amount;
+        curProcessing = static_cast<T> (processing * a3);
+        // simple auto-gain compensation
+        autoGain = static_cast<T> (1.0 + processing * autoGain_a1 + processing * processing * autoGain_a2);
+    }
+
+    template <typename T>
+    void Channel<T>::setMode (Type t, Brightness b)
+    {
+        brightness = b;
+        type = t;
+        const auto& coeffs = getModeCoefficients (type, brightness);
+        // sample-rate scale
+        hpf_k = static_cast<T> (coeffs.hpf_k * srScale);
+        lpf_k = static_cast<T> (coeffs.lpf_k * srScale);
+        a3 = coeffs.a3;
+        f1 = static_cast<T> (coeffs.f1);
+        p20 = static_cast<T> (coeffs.p20);
+        p24 = static_cast<T> (coeffs.p24);
+        g0 = coeffs.g0;
+        saturator.type = coeffs.saturatorType;
+        autoGain_a1 = coeffs.autoGain_a1;
+        autoGain_a2 = coeffs.autoGain_a2;
+    }
+
+    template <typename T>
+    T Channel<T>::process (T x)
+    {
+        curProcessing = static_cast<T> (processing * a3);
+        const T x1 = hpf_k * x + (x - prev_x);
+        const T x2 = x1 * f1 + x1;
+        const T x3 = (! g0) ? x : x2;
+        const T drive = (type == Type::Luster) ? x2 * curProcessing : x2;
+        const auto saturate = [this] (T in, T& previous)
+        {
+            if (antialiasing == Antialiasing::Adaa)
+                return saturator.processAdaa (in, previous);
+            return saturatorTier == SaturatorTier::Table ? saturator.processTable (in) : saturator.process (in);
+        };
+        const T x4 = saturate (drive, prevDrive);
+        const T blend = x4 * curProcessing * p20 + x3;
+        const T x5 = saturate (blend, prevBlend);
+
+        prev_x = x;
+
+        s += (x5 - s) * lpf_k;
+
+        T y = curProcessing * (s - x * p24);
+
+        if (type == Type::Luster)
+            y *= T (0.5);
+
+        y += x;
+        if (useAutoGain)
+            y *= autoGain;
+
+        return y;
+    }
+
+    template struct Channel<double>;
+    template struct Channel<float>;
+} // namespace tonix
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Coefficients.h"
+#include "Saturator.h"
+
+namespace tonix
+{
+    // Per-sample reference of the algorithm. The plugin processes through ChannelBank,
+    // which must produce the same output as the Channel of the same precision.
+    // Coefficient setup stays in double, only the per-sample math is done in T.
+    template <typename T = double>
+    struct Channel
+    {
+        void setProcessing (double amount);
+
+        void setMode (Type, Brightness);
+        void reset();
+
+        T process (T sample);
+
+        double processing;
+        T curProcessing;
+
+        // coeffs
+        T hpf_k, lpf_k;
+        double a3;
+        T f1, p20, p24;
+        bool g0;
+        double autoGain_a1, autoGain_a2;
+        T autoGain;
+        bool useAutoGain;
+
+        Saturator<T> saturator;
+        Type type;
+        Brightness brightness;
+        Antialiasing antialiasing { Antialiasing::Off };
+        // ignored with ADAA, like ChannelBank
+        SaturatorTier saturatorTier { SaturatorTier::Polynomial };
+
+        T s, prev_x;
+        // last input of each saturator, for ADAA
+        T prevDrive, prevBlend;
+        double srScale { 1.0 };
+    };
+
+    extern template struct Channel<double>;
+    extern template struct Channel<float>;
+} // namespace tonix
@@ -0,0 +1,243 @@
+#include "ChannelBank.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+namespace tonix
+{
+    void ChannelBank::prepare (int numChannels, double sampleRate)
+    {
+        m_numChannels = numChannels;
+        // original has fixed scaling depending on sample rate: {1.0, 0.5, 0.25}; rates
+        // below 44.1 kHz keep the 44.1 tuning instead of dividing by zero
+        m_srScale = 1.0 / std::max (1.0, std::floor (sampleRate / 44100.0));
+
+        // the LPF is the only recursion, from full scale down to silence
+        double slowestLpf = 1.0;
+        for (const auto& modes : kModeTable)
+            for (const auto& mode : modes)
+                slowestLpf = std::min (slowestLpf, mode.lpf_k * m_srScale);
+        m_tailSamples = static_cast<int> (std::ceil (std::log (kSilenceThreshold) / std::log1p (-slowestLpf)));
+
+        const auto paddedChannels = (static_cast<size_t> (numChannels) + kMaxLanes - 1) / kMaxLanes * kMaxLanes;
+        m_lpfState.assign (paddedChannels, 0.0);
+        m_prevInput.assign (paddedChannels, 0.0);
+        m_prevDrive.assign (paddedChannels, 0.0);
+        m_prevBlend.assign (paddedChannels, 0.0);
+        m_input.assign ((kChunkSize + 1) * kMaxLanes, 0.0);
+        m_work.assign (kChunkSize * kMaxLanes, 0.0);
+        m_inputFloat.assign ((kChunkSize + 1) * kMaxLanes, 0.0f);
+        m_workFloat.assign (kChunkSize * kMaxLanes, 0.0f);
+        // single channels only
+        m_saturatorInput.assign (kChunkSize + 1, 0.0);
+        m_saturatorInputFloat.assign (kChunkSize + 1, 0.0f);
+
+        // built by the first instance, not on the audio thread
+        m_saturatorTables = &getSaturatorTables();
+
+        m_isa = m_forcedIsa && isIsaSupported (*m_forcedIsa) ? *m_forcedIsa : getPreferredIsa();
+        m_kernels = &getKernelTable (m_isa);
+        setMode (m_type, m_brightness);
+    }
+
+    void ChannelBank::reset()
+    {
+        std::fill (m_lpfState.begin(), m_lpfState.end(), 0.0);
+        std::fill (m_prevInput.begin(), m_prevInput.end(), 0.0);
+        std::fill (m_prevDrive.begin(), m_prevDrive.end(), 0.0);
+        std::fill (m_prevBlend.begin(), m_prevBlend.end(), 0.0);
+        m_asleep = false;
+    }
+
+    void ChannelBank::setMode (Type type, Brightness brightness)
+    {
+        TONIX_TRACE_SCOPE ("coefficients");
+        m_type = type;
+        m_brightness = brightness;
+        m_mode = &getModeCoefficients (type, brightness);
+        // sample-rate scale
+        m_hpf_k = m_mode->hpf_k * m_srScale;
+        m_lpf_k = m_mode->lpf_k * m_srScale;
+        updateAutoGain();
+        updateKernel();
+    }
+
+    void ChannelBank::setProcessing (double amount)
+    {
+        m_processing = amount;
+        updateAutoGain();
+    }
+
+    void ChannelBank::setAutoGain (bool shouldUseAutoGain)
+    {
+        m_useAutoGain = shouldUseAutoGain;
+        updateKernel();
+    }
+
+    void ChannelBank::setPrecision (Precision precision)
+    {
+        m_precision = precision;
+        updateKernel();
+    }
+
+    void ChannelBank::setAntialiasing (Antialiasing antialiasing)
+    {
+        // the saturators' last inputs are only tracked while ADAA runs; switching on starts
+        // from stale values for one sample, which the LPF smooths over
+        m_antialiasing = antialiasing;
+        updateKernel();
+    }
+
+    void ChannelBank::setSaturatorTier (SaturatorTier tier)
+    {
+        m_saturatorTier = tier;
+        updateKernel();
+    }
+
+    void ChannelBank::updateAutoGain()
+    {
+        // simple auto-gain compensation
+        m_autoGain = 1.0 + m_processing * m_mode->autoGain_a1 + m_processing * m_processing * m_mode->autoGain_a2;
+    }
+
+    void ChannelBank::setUseSpecializedKernels (bool shouldUseSpecializedKernels)
+    {
+        m_useSpecializedKernels = shouldUseSpecializedKernels;
+        updateKernel();
+    }
+
+    void ChannelBank::forceIsa (std::optional<Isa> isa)
+    {
+        m_forcedIsa = isa;
+    }
+
+    void ChannelBank::updateKernel()
+    {
+        const auto select = [this] (const KernelSet& set)
+        {
+            auto shaping = Shaping::Polynomial;
+            if (m_antialiasing == Antialiasing::Adaa)
+                shaping = Shaping::Adaa;
+            // the tables only exist once prepared
+            else if (m_saturatorTier == SaturatorTier::Table && m_saturatorTables != nullptr)
+                shaping = Shaping::Table;
+            const auto index = static_cast<size_t> (shaping);
+            return m_useSpecializedKernels ? set.specialized[index][static_cast<size_t> (m_type)][m_useAutoGain ? 1 : 0]
+                                           : set.generic[index][static_cast<size_t> (m_mode->saturatorType)];
+        };
+        m_floatKernel = select (m_kernels->get (false, m_precision));
+        m_doubleKernel = select (m_kernels->get (true, m_precision));
+        m_floatGainKernel = m_kernels->get (false, m_precision).gain;
+        m_doubleGainKernel = m_kernels->get (true, m_precision).gain;
+    }
+
+    KernelArgs ChannelBank::makeArgs (int firstChannel, int numChannels, int numSamples, float inputGain, float outputGain)
+    {
+        const auto first = static_cast<size_t> (firstChannel);
+        KernelArgs args;
+        args.channels = nullptr;
+        args.channelsDouble = nullptr;
+        args.numChannels = numChannels;
+        args.numSamples = numSamples;
+        args.inputGain = inputGain;
+        args.outputGain = outputGain;
+        args.hpf_k = m_hpf_k;
+        args.lpf_k = m_lpf_k;
+        args.processing = m_processing;
+        args.autoGain = m_autoGain;
+        args.useAutoGain = m_useAutoGain;
+        args.mode = m_mode;
+        args.luster = m_type == Type::Luster;
+        args.lpfState = m_lpfState.data() + first;
+        args.prevInput = m_prevInput.data() + first;
+        args.prevDrive = m_prevDrive.data() + first;
+        args.prevBlend = m_prevBlend.data() + first;
+        args.saturatorTables = m_saturatorTables;
+        args.input = m_input.data();
+        args.work = m_work.data();
+        args.saturatorInput = m_saturatorInput.data();
+        args.inputFloat = m_inputFloat.data();
+        args.workFloat = m_workFloat.data();
+        args.saturatorInputFloat = m_saturatorInputFloat.data();
+        return args;
+    }
+
+    void ChannelBank::process (float* const* channels, int numChannels, int numSamples, float inputGain, float outputGain)
+    {
+        processChannels (channels, numChannels, numSamples, inputGain, outputGain);
+    }
+
+    void ChannelBank::process (double* const* channels, int numChannels, int numSamples, float inputGain, float outputGain)
+    {
+        processChannels (channels, numChannels, numSamples, inputGain, outputGain);
+    }
+
+    template <typename IO>
+    void ChannelBank::processChannels (IO* const* channels, int numChannels, int numSamples, float inputGain, float outputGain)
+    {
+        numChannels = std::min (numChannels, m_numChannels);
+        // one event per run of channels, valued with the first one
+        const auto run = [&] (Kernel kernel, int first, int count)
+        {
+            TONIX_TRACE_SCOPE_VALUE ("channels", first);
+            auto args = makeArgs (first, count, numSamples, inputGain, outputGain);
+            if constexpr (std::is_same_v<IO, float>)
+                args.channels = channels + first;
+            else
+                args.channelsDouble = channels + first;
+            kernel (args);
+        };
+
+        if (m_processing == 0.0)
+        {
+            m_asleep = true;
+            for (int ch = 0; ch < numChannels && m_asleep; ++ch)
+                m_asleep = std::all_of (channels[ch], channels[ch] + numSamples, [inputGain] (IO x)
+                                        { return std::abs (x * inputGain) <= kSilenceThreshold; });
+            run (std::is_same_v<IO, float> ? m_floatGainKernel : m_doubleGainKernel, 0, numChannels);
+            return;
+        }
+
+        // sleeping channels split the rest into runs, each processed as its own bank
+        const auto kernel = std::is_same_v<IO, float> ? m_floatKernel : m_doubleKernel;
+        int first = 0;
+        m_asleep = true;
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            if (! trySleep (channels[ch], ch, numSamples, inputGain))
+            {
+                m_asleep = false;
+                continue;
+            }
+            std::fill (channels[ch], channels[ch] + numSamples, IO (0));
+            if (ch > first)
+                run (kernel, first, ch - first);
+            first = ch + 1;
+        }
+        if (numChannels > first)
+            run (kernel, first, numChannels - first);
+    }
+
+    template <typename IO>
+    bool ChannelBank::trySleep (const IO* input, int channel, int numSamples, float inputGain)
+    {
+        const auto ch = static_cast<size_t> (channel);
+        const auto quiet = [] (double x)
+        {
+            return std::abs (x) <= kSilenceThreshold;
+        };
+        // the saturators' last inputs only matter with ADAA, they go stale otherwise
+        if (! quiet (m_lpfState[ch]) || ! quiet (m_prevInput[ch]))
+            return false;
+        if (m_antialiasing == Antialiasing::Adaa && (! quiet (m_prevDrive[ch]) || ! quiet (m_prevBlend[ch])))
+            return false;
+        if (! std::all_of (input, input + numSamples, [&] (IO x)
+                           { return quiet (x * inputGain); }))
+            return false;
+
+        m_lpfState[ch] = m_prevInput[ch] = m_prevDrive[ch] = m_prevBlend[ch] = 0.0;
+        return true;
+    }
+} // namespace tonix
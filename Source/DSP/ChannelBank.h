@@ -0,0 +1,113 @@
+#pragma once
+
+#include "Coefficients.h"
+#include "Kernels.h"
+
+#include <optional>
+#include <vector>
+
+namespace tonix
+{
+    // All channels of one processor, stored struct-of-arrays. Channels are processed in
+    // groups that fill a SIMD register (8/4/2 lanes depending on the ISA), so the whole
+    // chain including the recursive LPF advances all lanes of a group together.
+    // Channels left over after the full groups are vectorized along time instead.
+    //
+    // The kernel is picked from a table whenever the mode or auto-gain changes, so the
+    // per-sample loops carry no Type or auto-gain branches. The table itself is chosen by
+    // prepare() for the fastest instruction set the CPU supports.
+    //
+    // A channel sleeps while its input is silent and its filter memory has decayed: it
+    // outputs zeros without running the kernel. At 0% Process only the trims are applied.
+    class ChannelBank
+    {
+    public:
+        // inputs and filter memory below this (about -140 dBFS) count as silence
+        static constexpr double kSilenceThreshold = 1.0e-7;
+
+        // allocates and selects the instruction set, call before processing
+        void prepare (int numChannels, double sampleRate);
+        void reset();
+
+        void setMode (Type, Brightness);
+        void setProcessing (double amount);
+        void setAutoGain (bool shouldUseAutoGain);
+        // float doubles the lanes per register, switching keeps the channel state
+        void setPrecision (Precision);
+        Precision getPrecision() const { return m_precision; }
+        // ADAA costs a fraction of oversampling; the saturated path gains half a sample of delay
+        void setAntialiasing (Antialiasing);
+        Antialiasing getAntialiasing() const { return m_antialiasing; }
+        // the table tier trades about -100 dB of accuracy for cheaper saturators; ignored
+        // while ADAA is on
+        void setSaturatorTier (SaturatorTier);
+        SaturatorTier getSaturatorTier() const { return m_saturatorTier; }
+
+        // the generic kernel reads every coefficient at runtime, for A/B comparison
+        void setUseSpecializedKernels (bool shouldUseSpecializedKernels);
+
+        // for testing, overrides getPreferredIsa() from the next prepare() on;
+        // ignored if unsupported
+        void forceIsa (std::optional<Isa>);
+        Isa getIsa() const { return m_isa; }
+
+        int getNumChannels() const { return m_numChannels; }
+
+        // whether every channel slept through the last block, or had silent input at 0% Process
+        bool isAsleep() const { return m_asleep; }
+        // samples until the output falls below kSilenceThreshold once the input stops,
+        // for the slowest mode
+        int getTailSamples() const { return m_tailSamples; }
+
+        // in-place, numChannels <= getNumChannels()
+        // the double overload runs on the host's 64-bit buffers directly
+        void process (float* const* channels, int numChannels, int numSamples, float inputGain, float outputGain);
+        void process (double* const* channels, int numChannels, int numSamples, float inputGain, float outputGain);
+
+    private:
+        void updateAutoGain();
+        void updateKernel();
+        KernelArgs makeArgs (int firstChannel, int numChannels, int numSamples, float inputGain, float outputGain);
+        template <typename IO>
+        void processChannels (IO* const* channels, int numChannels, int numSamples, float inputGain, float outputGain);
+        // zeroes the channel's memory if it can sleep through this block
+        template <typename IO>
+        bool trySleep (const IO* input, int channel, int numSamples, float inputGain);
+
+        int m_numChannels { 0 };
+        double m_srScale { 1.0 };
+        int m_tailSamples { 0 };
+        bool m_asleep { false };
+
+        // coeffs, shared by all channels
+        const ModeCoefficients* m_mode { &getModeCoefficients (Type::Iridescent, Brightness::Gold) };
+        Type m_type { Type::Iridescent };
+        Brightness m_brightness { Brightness::Gold };
+        double m_hpf_k { 0.0 }, m_lpf_k { 0.0 };
+        double m_processing { 0.0 };
+        double m_autoGain { 1.0 };
+        bool m_useAutoGain { true };
+        Precision m_precision { Precision::Double };
+        Antialiasing m_antialiasing { Antialiasing::Off };
+        SaturatorTier m_saturatorTier { SaturatorTier::Polynomial };
+        const SaturatorTables* m_saturatorTables { nullptr };
+
+        std::optional<Isa> m_forcedIsa;
+        Isa m_isa { Isa::Scalar };
+        const KernelTable* m_kernels { &getKernelTable (Isa::Scalar) };
+        bool m_useSpecializedKernels { true };
+        // for float and double host buffers
+        Kernel m_floatKernel { m_kernels->get (false, m_precision).specialized[0][static_cast<size_t> (m_type)][m_useAutoGain ? 1 : 0] };
+        Kernel m_doubleKernel { m_kernels->get (true, m_precision).specialized[0][static_cast<size_t> (m_type)][m_useAutoGain ? 1 : 0] };
+        Kernel m_floatGainKernel { m_kernels->get (false, m_precision).gain };
+        Kernel m_doubleGainKernel { m_kernels->get (true, m_precision).gain };
+
+        // per-channel memory, one entry per channel (padded to a full register)
+        std::vector<double> m_lpfState, m_prevInput, m_prevDrive, m_prevBlend;
+
+        // scratch, frames interleaved by lane: [frame][lane]
+        // m_input holds the previous frame in front for the HPF difference
+        std::vector<double> m_input, m_work, m_saturatorInput;
+        std::vector<float> m_inputFloat, m_workFloat, m_saturatorInputFloat;
+    };
+} // namespace tonix
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+namespace tonix
+{
+    enum class Brightness
+    {
+        Opal = 0,
+        Gold,
+        Sapphire
+    };
+
+    enum class Type
+    {
+        Luminiscent = 0,
+        Iridescent,
+        Radiant,
+        Luster,
+        DarkEssence
+    };
+
+    // how the saturators handle aliasing (besides oversampling)
+    enum class Antialiasing
+    {
+        Off = 0,
+        // first-order antiderivative anti-aliasing
+        Adaa
+    };
+
+    // how the saturator curves are evaluated
+    enum class SaturatorTier
+    {
+        // the 15-term polynomial
+        Polynomial = 0,
+        // linear interpolation in a precomputed table of the polynomial, about -100 dB
+        // away from it and cheaper, for tracking sessions
+        Table
+    };
+
+    constexpr size_t kNumBrightness = 3;
+    constexpr size_t kNumTypes = 5;
+    constexpr size_t kNumAntialiasing = 2;
+    constexpr size_t kNumSaturatorTiers = 2;
+
+    // coefficients of a single Type x Brightness combination (before sample-rate scaling)
+    struct ModeCoefficients
+    {
+        double hpf_k, lpf_k;
+        double a3, f1, p20, p24;
+        bool g0;
+        int saturatorType;
+        double autoGain_a1, autoGain_a2;
+    };
+
+    namespace detail
+    {
+        struct FilterCoefficients
+        {
+            double hpf_k, lpf_k;
+        };
+
+        struct TypeDefinition
+        {
+            // indexed by Brightness
+            std::array<FilterCoefficients, kNumBrightness> filters;
+            double a3, f1, p20, p24;
+            bool g0;
+            int saturatorType;
+            double autoGain_a1, autoGain_a2;
+        };
+
+        // values from JClones_Phoenix, indexed by Type
+        constexpr std::array<TypeDefinition, kNumTypes> kTypes { {
+            // Luminiscent
+            { { { { 0.625, 0.1875 }, { 0.4375, 0.3125 }, { 0.1875, 0.375 } } }, 0.25, 0.75, 0.3125, 0.0625, true, 0, -0.416, 0.092 },
+            // Iridescent
+            { { { { 0.625, 0.1875 }, { 0.375, 0.3125 }, { 0.3125, 0.5 } } }, 0.25, 0.875, 0.3125, 0.0625, true, 0, -0.393, 0.082 },
+            // Radiant
+            { { { { 0.75, 0.125 }, { 0.45629901, 0.375 }, { 0.375, 0.5 } } }, 0.375, 0.75, 0.1875, 0.0125, false, 1, -0.441, 0.103 },
+            // Luster
+            { { { { 0.75, 0.125 }, { 0.45629901, 0.375 }, { 0.375, 0.5625 } } }, 1.0, 0.6875, 0.27343899, 0.1171875, false, 2, -0.712, 0.172 },
+            // Dark Essence
+            { { { { 0.75, 0.125 }, { 0.45629901, 0.375 }, { 0.375, 0.5625 } } }, 0.375, 0.75, 0.5625, 0.0125, false, 2, -0.636, 0.17 },
+        } };
+
+        constexpr auto buildModeTable()
+        {
+            std::array<std::array<ModeCoefficients, kNumBrightness>, kNumTypes> table {};
+            for (size_t t = 0; t < kNumTypes; ++t)
+            {
+                const auto& def = kTypes[t];
+                for (size_t b = 0; b < kNumBrightness; ++b)
+                    table[t][b] = { def.filters[b].hpf_k, def.filters[b].lpf_k, def.a3, def.f1, def.p20, def.p24, def.g0, def.saturatorType, def.autoGain_a1, def.autoGain_a2 };
+            }
+            return table;
+        }
+    } // namespace detail
+
+    // all 15 Type x Brightness coefficient sets, resolved at compile time
+    inline constexpr auto kModeTable = detail::buildModeTable();
+
+    constexpr const ModeCoefficients& getModeCoefficients (Type type, Brightness brightness)
+    {
+        return kModeTable[static_cast<size_t> (type)][static_cast<size_t> (brightness)];
+    }
+
+    static_assert (getModeCoefficients (Type::Radiant, Brightness::Sapphire).lpf_k == 0.5);
+    static_assert (getModeCoefficients (Type::Luster, Brightness::Opal).a3 == 1.0);
+} // namespace tonix
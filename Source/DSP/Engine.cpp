@@ -0,0 +1,704 @@
+#include "Engine.h"
+#include "Simd.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+namespace tonix
+{
+    namespace
+    {
+        // core-rate samples a path processes before it fades in; covers the longest
+        // oversampler and padding, and the LPF settles well within it
+        constexpr int kHistorySize = 256;
+        // quality and bypass crossfades
+        constexpr double kFadeSeconds = 0.01;
+
+        template <typename T>
+        bool isSilent (const T* const* channels, int numChannels, int numSamples)
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+                for (int i = 0; i < numSamples; ++i)
+                    if (std::abs (channels[ch][i]) > ChannelBank::kSilenceThreshold)
+                        return false;
+            return true;
+        }
+
+        // wet = dry + gain * (wet - dry), the gain moving by delta per sample from start
+        // and held within [0, 1]
+        template <typename T>
+        void crossfade (T* wet, const T* dry, int numSamples, double start, double delta)
+        {
+            using simd::max;
+            using simd::min;
+            using simd::mulAdd;
+            using Vec = simd::Vec<T, simd::kNativeWidth<T>>;
+            constexpr int width = static_cast<int> (Vec::size);
+
+            T ramp[width];
+            for (int l = 0; l < width; ++l)
+                ramp[l] = static_cast<T> ((l + 1) * delta);
+            const auto steps = Vec::load (ramp);
+
+            int i = 0;
+            for (; i + width <= numSamples; i += width)
+            {
+                const auto gain = min (max (Vec (static_cast<T> (start + i * delta)) + steps, Vec (T (0))), Vec (T (1)));
+                const auto d = Vec::load (dry + i);
+                mulAdd (gain, Vec::load (wet + i) - d, d).store (wet + i);
+            }
+            for (; i < numSamples; ++i)
+            {
+                const auto gain = static_cast<T> (std::clamp (start + (i + 1) * delta, 0.0, 1.0));
+                wet[i] = dry[i] + gain * (wet[i] - dry[i]);
+            }
+        }
+
+        // x *= start + (i + 1) * delta
+        template <typename T>
+        void applyRamp (T* x, int numSamples, double start, double delta)
+        {
+            using simd::mulAdd;
+            using Vec = simd::Vec<T, simd::kNativeWidth<T>>;
+            constexpr int width = static_cast<int> (Vec::size);
+
+            T ramp[width];
+            for (int l = 0; l < width; ++l)
+                ramp[l] = static_cast<T> ((l + 1) * delta);
+            const auto steps = Vec::load (ramp);
+
+            int i = 0;
+            for (; i + width <= numSamples; i += width)
+                (Vec::load (x + i) * (Vec (static_cast<T> (start + i * delta)) + steps)).store (x + i);
+            for (; i < numSamples; ++i)
+                x[i] = static_cast<T> (x[i] * (start + (i + 1) * delta));
+        }
+    } // namespace
+
+    void Engine::Ramp::prepare (int newLength)
+    {
+        length = std::max (1, newLength);
+        snap();
+    }
+
+    void Engine::Ramp::setTarget (double newTarget)
+    {
+        if (newTarget == target)
+            return;
+        target = newTarget;
+        remaining = length;
+        step = (target - current) / length;
+    }
+
+    void Engine::Ramp::snap()
+    {
+        current = target;
+        remaining = 0;
+    }
+
+    double Engine::Ramp::advance (int numSamples)
+    {
+        // from the end rather than accumulated, so how a glide is split into blocks
+        // doesn't matter and it lands on the target exactly
+        remaining = std::max (0, remaining - numSamples);
+        current = target - remaining * step;
+        return current;
+    }
+
+    void Engine::Delay::prepare (int numChannels, int newLength)
+    {
+        length = std::max (0, newLength);
+        lines.assign (static_cast<size_t> (numChannels), std::vector<double> (static_cast<size_t> (length), 0.0));
+        index = 0;
+    }
+
+    void Engine::Delay::reset()
+    {
+        for (auto& line : lines)
+            std::fill (line.begin(), line.end(), 0.0);
+        index = 0;
+    }
+
+    template <typename T>
+    void Engine::Delay::process (const T* const* input, T* const* output, int numChannels, int numSamples)
+    {
+        const auto numLines = std::min (static_cast<size_t> (numChannels), lines.size());
+        if (length == 0)
+        {
+            if (output != nullptr && output != input)
+                for (size_t ch = 0; ch < numLines; ++ch)
+                    std::copy (input[ch], input[ch] + numSamples, output[ch]);
+            return;
+        }
+
+        // without output only the newest length samples matter
+        const auto start = output != nullptr ? 0 : std::max (0, numSamples - length);
+        for (size_t ch = 0; ch < numLines; ++ch)
+        {
+            auto& line = lines[ch];
+            auto i = static_cast<size_t> ((index + start) % length);
+            for (int s = start; s < numSamples; ++s)
+            {
+                const auto delayed = line[i];
+                line[i] = input[ch][s];
+                if (output != nullptr)
+                    output[ch][s] = static_cast<T> (delayed);
+                if (++i == line.size())
+                    i = 0;
+            }
+        }
+        index = (index + numSamples) % length;
+    }
+
+    template <typename T>
+    T* const* Engine::ChannelOffsets::get (T* const* channels, int numChannels, int offset)
+    {
+        auto& pointers = [this]() -> auto&
+        {
+            if constexpr (std::is_same_v<T, float>)
+                return floats;
+            else
+                return doubles;
+        }();
+        for (size_t ch = 0; ch < std::min (static_cast<size_t> (numChannels), pointers.size()); ++ch)
+            pointers[ch] = channels[ch] + offset;
+        return pointers.data();
+    }
+
+    void Engine::prepare (int numChannels, double sampleRate, int maxBlockSize, int oversamplingLog2, OversamplingPhase phase, InternalRate internalRate, bool fallbacks)
+    {
+        m_maxBlockSize = std::max (1, maxBlockSize);
+        m_internalRate = internalRate;
+        m_coreSampleRate = getInternalSampleRate (sampleRate, internalRate);
+        m_coreBlockSize = RateConverter::getMaxInternalSamples (sampleRate, m_coreSampleRate, m_maxBlockSize);
+
+        oversamplingLog2 = std::clamp (oversamplingLog2, 0, Oversampler::kMaxFactorLog2);
+        m_paths.clear();
+        m_paths.resize (fallbacks ? static_cast<size_t> (oversamplingLog2) + 1 : 1);
+        double coreLatency = 0.0;
+        for (size_t p = 0; p < m_paths.size(); ++p)
+        {
+            m_paths[p].oversampler.prepare (numChannels, m_coreBlockSize, oversamplingLog2 - static_cast<int> (p), phase);
+            coreLatency = std::max (coreLatency, m_paths[p].oversampler.getLatency());
+        }
+        for (auto& path : m_paths)
+        {
+            // rounded, minimum phase fallbacks are a fraction of a sample off
+            path.padding.prepare (numChannels, static_cast<int> (std::lround (coreLatency - path.oversampler.getLatency())));
+            path.bank.prepare (numChannels, m_coreSampleRate * path.oversampler.getFactor());
+            path.bank.setMode (m_type, m_brightness);
+            path.bank.setProcessing (m_processing);
+            path.bank.setAutoGain (m_useAutoGain);
+        }
+        m_converter.prepare (numChannels, sampleRate, m_coreSampleRate, m_maxBlockSize, coreLatency);
+        m_latency = m_converter.getLatency() + coreLatency * sampleRate / m_coreSampleRate;
+        // symmetric filters ring for as long again as they delay
+        m_flushLength = static_cast<int> (std::ceil (2.0 * m_latency));
+        const auto& top = m_paths.front();
+        m_tailLength = m_flushLength + top.bank.getTailSamples() / static_cast<double> (top.oversampler.getFactor()) * sampleRate / m_coreSampleRate;
+        m_silentLength = 0;
+        m_asleep = false;
+
+        // the plugin reports the rounded latency
+        m_dry.prepare (numChannels, static_cast<int> (std::lround (m_latency)));
+        m_dryFloat.assign (static_cast<size_t> (numChannels), std::vector<float> (static_cast<size_t> (m_maxBlockSize), 0.0f));
+        m_dryDouble.assign (static_cast<size_t> (numChannels), std::vector<double> (static_cast<size_t> (m_maxBlockSize), 0.0));
+        m_dryFloatPointers.clear();
+        for (auto& buffer : m_dryFloat)
+            m_dryFloatPointers.push_back (buffer.data());
+        m_dryDoublePointers.clear();
+        for (auto& buffer : m_dryDouble)
+            m_dryDoublePointers.push_back (buffer.data());
+        const auto smoothingLength = static_cast<int> (kSmoothingSeconds * sampleRate);
+        for (auto* ramp : { &m_processingRamp, &m_inputTrim, &m_outputTrim })
+            ramp->prepare (smoothingLength);
+        m_processingRamp.target = m_processing;
+        m_processingRamp.snap();
+        m_snapTrims = true;
+        m_bypassStep = 1.0 / std::max (1.0, kFadeSeconds * sampleRate);
+        m_wet = m_bypassed ? 0.0 : 1.0;
+        m_preroll = 0;
+
+        m_fadeLength = std::max (1, static_cast<int> (kFadeSeconds * m_coreSampleRate));
+        m_fadeBuffers.assign (static_cast<size_t> (numChannels), std::vector<double> (static_cast<size_t> (m_coreBlockSize), 0.0));
+        m_fadePointers.clear();
+        for (auto& buffer : m_fadeBuffers)
+            m_fadePointers.push_back (buffer.data());
+        for (auto* offsets : { &m_hostOffsets, &m_rampOffsets, &m_coreOffsets })
+        {
+            offsets->floats.assign (static_cast<size_t> (numChannels), nullptr);
+            offsets->doubles.assign (static_cast<size_t> (numChannels), nullptr);
+        }
+        m_history.assign (m_paths.size() > 1 ? static_cast<size_t> (numChannels) : 0, std::vector<double> (kHistorySize, 0.0));
+        m_historyIndex = 0;
+
+        m_qualityLevel = 0;
+        m_pendingLevel = -1;
+        m_fadeRemaining = 0;
+        updateQualityLevels();
+        applyQuality (false);
+    }
+
+    void Engine::reset()
+    {
+        resetProcessing();
+        m_dry.reset();
+        m_wet = m_bypassed ? 0.0 : 1.0;
+        m_preroll = 0;
+        m_silentLength = 0;
+        m_asleep = false;
+    }
+
+    void Engine::resetProcessing()
+    {
+        for (auto& path : m_paths)
+        {
+            path.bank.reset();
+            path.oversampler.reset();
+            path.padding.reset();
+        }
+        m_converter.reset();
+        // nothing to glide from either
+        if (m_processingRamp.isRamping())
+        {
+            m_processingRamp.snap();
+            setBankProcessing (m_processing);
+        }
+        m_snapTrims = true;
+        for (auto& line : m_history)
+            std::fill (line.begin(), line.end(), 0.0);
+        m_historyIndex = 0;
+
+        // nothing to fade from
+        m_fadeRemaining = 0;
+        if (m_pendingLevel >= 0)
+            m_qualityLevel = std::min (m_pendingLevel, m_numQualityLevels - 1);
+        m_pendingLevel = -1;
+        applyQuality (false);
+    }
+
+    void Engine::setBypassed (bool shouldBeBypassed)
+    {
+        if (shouldBeBypassed == m_bypassed)
+            return;
+        m_bypassed = shouldBeBypassed;
+        // nothing ran while fully bypassed, so start over rather than from stale memory,
+        // and let the filters fill before fading in
+        if (! m_bypassed && m_wet == 0.0)
+        {
+            resetProcessing();
+            m_preroll = m_flushLength;
+        }
+    }
+
+    void Engine::setMode (Type type, Brightness brightness)
+    {
+        // the processor hands every setting over again after each parameter change
+        if (type == m_type && brightness == m_brightness)
+            return;
+        m_type = type;
+        m_brightness = brightness;
+        for (auto& path : m_paths)
+            path.bank.setMode (type, brightness);
+    }
+
+    void Engine::setProcessing (double amount)
+    {
+        m_processing = amount;
+        m_processingRamp.setTarget (amount);
+    }
+
+    void Engine::setBankProcessing (double amount)
+    {
+        for (auto& path : m_paths)
+            path.bank.setProcessing (amount);
+    }
+
+    void Engine::setAutoGain (bool shouldUseAutoGain)
+    {
+        if (shouldUseAutoGain == m_useAutoGain)
+            return;
+        m_useAutoGain = shouldUseAutoGain;
+        for (auto& path : m_paths)
+            path.bank.setAutoGain (shouldUseAutoGain);
+    }
+
+    void Engine::setPrecision (Precision precision)
+    {
+        if (precision == m_precision)
+            return;
+        m_precision = precision;
+        updateQualityLevels();
+        applyQuality (true);
+    }
+
+    void Engine::setAntialiasing (Antialiasing antialiasing)
+    {
+        if (antialiasing == m_antialiasing)
+            return;
+        m_antialiasing = antialiasing;
+        updateQualityLevels();
+        applyQuality (true);
+    }
+
+    void Engine::setSaturatorTier (SaturatorTier tier)
+    {
+        if (tier == m_saturatorTier)
+            return;
+        m_saturatorTier = tier;
+        updateQualityLevels();
+        applyQuality (true);
+    }
+
+    void Engine::updateQualityLevels()
+    {
+        // cheapest first per CPU saved for what is lost: the table is inaudible, float
+        // nearly so, then the oversampling that ADAA partly makes up for
+        Quality quality { m_precision, m_saturatorTier, m_antialiasing, getOversamplingLog2() };
+        m_qualityLevels[0] = quality;
+        m_numQualityLevels = 1;
+        const auto add = [this] (const Quality& next)
+        {
+            if (! (next == m_qualityLevels[static_cast<size_t> (m_numQualityLevels - 1)]))
+                m_qualityLevels[static_cast<size_t> (m_numQualityLevels++)] = next;
+        };
+
+        // ignored while ADAA is on
+        if (quality.antialiasing == Antialiasing::Off)
+        {
+            quality.saturatorTier = SaturatorTier::Table;
+            add (quality);
+        }
+        quality.precision = Precision::Float;
+        add (quality);
+        const auto lowest = getOversamplingLog2() - static_cast<int> (m_paths.size()) + 1;
+        while (quality.oversamplingLog2 > lowest)
+        {
+            --quality.oversamplingLog2;
+            add (quality);
+        }
+        quality.antialiasing = Antialiasing::Off;
+        add (quality);
+        quality.saturatorTier = SaturatorTier::Table;
+        add (quality);
+
+        m_qualityLevel = std::min (m_qualityLevel, m_numQualityLevels - 1);
+    }
+
+    void Engine::setQualityLevel (int level)
+    {
+        level = std::clamp (level, 0, m_numQualityLevels - 1);
+        if (m_fadeRemaining > 0)
+        {
+            m_pendingLevel = level;
+            return;
+        }
+        m_qualityLevel = level;
+        applyQuality (true);
+    }
+
+    void Engine::applyQuality (bool crossfade)
+    {
+        const auto& quality = m_qualityLevels[static_cast<size_t> (m_qualityLevel)];
+        for (auto& path : m_paths)
+        {
+            path.bank.setPrecision (quality.precision);
+            path.bank.setSaturatorTier (quality.saturatorTier);
+            path.bank.setAntialiasing (quality.antialiasing);
+        }
+
+        const auto target = static_cast<size_t> (getOversamplingLog2() - quality.oversamplingLog2);
+        if (target == m_activePath)
+            return;
+        if (! crossfade)
+        {
+            m_activePath = target;
+            return;
+        }
+        // one crossfade at a time, this one follows
+        if (m_fadeRemaining > 0)
+        {
+            m_pendingLevel = m_qualityLevel;
+            return;
+        }
+        warmUp (m_paths[target]);
+        m_fadingPath = m_activePath;
+        m_activePath = target;
+        m_fadeRemaining = m_fadeLength;
+    }
+
+    void Engine::warmUp (Path& path)
+    {
+        path.bank.reset();
+        path.oversampler.reset();
+        path.padding.reset();
+
+        // oldest first, through the fade buffers, output discarded
+        const auto numChannels = static_cast<int> (m_history.size());
+        for (int offset = 0; offset < kHistorySize; offset += m_coreBlockSize)
+        {
+            const auto n = std::min (m_coreBlockSize, kHistorySize - offset);
+            for (size_t ch = 0; ch < m_history.size(); ++ch)
+            {
+                for (int i = 0; i < n; ++i)
+                    m_fadeBuffers[ch][static_cast<size_t> (i)] = m_history[ch][static_cast<size_t> ((m_historyIndex + offset + i) % kHistorySize)];
+            }
+            processPath (path, m_fadePointers.data(), numChannels, n);
+        }
+    }
+
+    void Engine::process (float* const* channels, int numChannels, int numSamples, float inputGain, float outputGain)
+    {
+        processBypassable (channels, numChannels, numSamples, inputGain, outputGain);
+    }
+
+    void Engine::process (double* const* channels, int numChannels, int numSamples, float inputGain, float outputGain)
+    {
+        processBypassable (channels, numChannels, numSamples, inputGain, outputGain);
+    }
+
+    template <typename T>
+    void Engine::processBypassable (T* const* channels, int numChannels, int numSamples, float inputGain, float outputGain)
+    {
+        if (m_wet == (m_bypassed ? 0.0 : 1.0))
+        {
+            if (m_bypassed)
+            {
+                TONIX_TRACE_SCOPE ("bypass");
+                m_dry.process<T> (channels, channels, numChannels, numSamples);
+                return;
+            }
+            // keeps the input the crossfade to bypass starts from
+            m_dry.process<T> (channels, nullptr, numChannels, numSamples);
+            processSmoothed (channels, numChannels, numSamples, inputGain, outputGain);
+            return;
+        }
+
+        TONIX_TRACE_SCOPE ("bypass crossfade");
+        auto* const* dry = [this]
+        {
+            if constexpr (std::is_same_v<T, float>)
+                return m_dryFloatPointers.data();
+            else
+                return m_dryDoublePointers.data();
+        }();
+        numChannels = std::min (numChannels, static_cast<int> (m_dryDouble.size()));
+        const auto delta = m_bypassed ? -m_bypassStep : m_bypassStep;
+        for (int offset = 0; offset < numSamples;)
+        {
+            const auto preroll = ! m_bypassed && m_preroll > 0;
+            const auto n = std::min ({ m_maxBlockSize, numSamples - offset, preroll ? m_preroll : m_maxBlockSize });
+            auto* const* chunk = m_hostOffsets.get (channels, numChannels, offset);
+            m_dry.process<T> (chunk, dry, numChannels, n);
+            processSmoothed (chunk, numChannels, n, inputGain, outputGain);
+            for (int ch = 0; ch < numChannels; ++ch)
+                crossfade (chunk[ch], dry[ch], n, m_wet, preroll ? 0.0 : delta);
+            if (preroll)
+                m_preroll -= n;
+            else
+                m_wet = std::clamp (m_wet + n * delta, 0.0, 1.0);
+            offset += n;
+        }
+    }
+
+    template <typename T>
+    void Engine::processSmoothed (T* const* channels, int numChannels, int numSamples, float inputGain, float outputGain)
+    {
+        m_inputTrim.setTarget (inputGain);
+        m_outputTrim.setTarget (outputGain);
+        if (m_snapTrims)
+        {
+            m_inputTrim.snap();
+            m_outputTrim.snap();
+            m_snapTrims = false;
+        }
+
+        // the trims go on either side of the chain at the host rate: inside the kernels a
+        // glide would land a filter delay away from where it switched to them
+        const auto trim = [] (Ramp& ramp, T* const* part, int numPartChannels, int n)
+        {
+            if (ramp.isRamping())
+            {
+                for (int ch = 0; ch < numPartChannels; ++ch)
+                    applyRamp (part[ch], n, ramp.current, ramp.step);
+                ramp.advance (n);
+            }
+            else if (ramp.current != 1.0)
+            {
+                for (int ch = 0; ch < numPartChannels; ++ch)
+                    applyRamp (part[ch], n, ramp.current, 0.0);
+            }
+        };
+
+        // while something glides, each part stays within one step of Process, counted
+        // from the end of its glide so the steps land on the same samples whatever the
+        // block size, and within the linear part of the trims
+        numChannels = std::min (numChannels, static_cast<int> (m_rampOffsets.doubles.size()));
+        for (int offset = 0; offset < numSamples;)
+        {
+            auto n = numSamples - offset;
+            int step = 0;
+            if (m_processingRamp.isRamping())
+            {
+                step = (m_processingRamp.remaining - 1) % kRampStep + 1;
+                n = std::min (n, step);
+            }
+            for (const auto* ramp : { &m_inputTrim, &m_outputTrim })
+                if (ramp->isRamping())
+                    n = std::min (n, ramp->remaining);
+            auto* const* part = offset == 0 ? channels : m_rampOffsets.get (channels, numChannels, offset);
+
+            // each step runs at the value it ends on
+            if (m_processingRamp.isRamping())
+            {
+                const auto& ramp = m_processingRamp;
+                setBankProcessing (ramp.remaining == step ? ramp.target : ramp.target - (ramp.remaining - step) * ramp.step);
+                m_processingRamp.advance (n);
+            }
+
+            trim (m_inputTrim, part, numChannels, n);
+            processAwake (part, numChannels, n);
+            trim (m_outputTrim, part, numChannels, n);
+            offset += n;
+        }
+    }
+
+    template <typename T>
+    void Engine::processAwake (T* const* channels, int numChannels, int numSamples)
+    {
+        // silence needs the filters flushed and the bank's memory decayed before it
+        // can be skipped; the reset on the way in drops what is left of them
+        const auto silent = isSilent<T> (channels, numChannels, numSamples);
+        m_silentLength = silent ? std::min (m_silentLength + numSamples, m_flushLength) : 0;
+        if (silent && m_silentLength >= m_flushLength && m_fadeRemaining == 0 && (m_asleep || m_paths[m_activePath].bank.isAsleep()))
+        {
+            TONIX_TRACE_SCOPE ("asleep");
+            if (! m_asleep)
+                resetProcessing();
+            m_asleep = true;
+            for (int ch = 0; ch < numChannels; ++ch)
+                std::fill (channels[ch], channels[ch] + numSamples, T (0));
+            return;
+        }
+        m_asleep = false;
+
+        if (m_converter.isActive())
+            processConverted (channels, numChannels, numSamples);
+        else
+            processCore (channels, numChannels, numSamples);
+    }
+
+    template <typename T>
+    void Engine::processConverted (T* const* channels, int numChannels, int numSamples)
+    {
+        for (int offset = 0; offset < numSamples; offset += m_maxBlockSize)
+        {
+            const auto n = std::min (m_maxBlockSize, numSamples - offset);
+            const auto numInternal = m_converter.toInternal (channels, numChannels, offset, n);
+            processCore (m_converter.getInternal(), numChannels, numInternal);
+            m_converter.fromInternal (channels, numChannels, offset, n, numInternal);
+        }
+    }
+
+    template <typename T>
+    void Engine::processCore (T* const* channels, int numChannels, int numSamples)
+    {
+        if (! m_history.empty())
+            recordHistory (channels, numChannels, numSamples);
+
+        if (m_fadeRemaining == 0)
+        {
+            processPath (m_paths[m_activePath], channels, numChannels, numSamples);
+            return;
+        }
+
+        numChannels = std::min (numChannels, static_cast<int> (m_fadeBuffers.size()));
+        for (int offset = 0; offset < numSamples; offset += m_coreBlockSize)
+        {
+            const auto n = std::min (m_coreBlockSize, numSamples - offset);
+            auto* const* pointers = m_coreOffsets.get (channels, numChannels, offset);
+            if (m_fadeRemaining > 0)
+                processFade (pointers, numChannels, n);
+            else
+                processPath (m_paths[m_activePath], pointers, numChannels, n);
+        }
+
+        // the history now covers this block, so a queued level can warm up from here
+        if (m_fadeRemaining == 0 && m_pendingLevel >= 0)
+        {
+            m_qualityLevel = std::min (m_pendingLevel, m_numQualityLevels - 1);
+            m_pendingLevel = -1;
+            applyQuality (true);
+        }
+    }
+
+    template <typename T>
+    void Engine::processPath (Path& path, T* const* channels, int numChannels, int numSamples)
+    {
+        TONIX_TRACE_SCOPE_VALUE ("path", path.oversampler.getFactor());
+        if (path.oversampler.getFactorLog2() == 0)
+        {
+            path.bank.process (channels, numChannels, numSamples, 1.0f, 1.0f);
+        }
+        else
+        {
+            // hosts may exceed the size given to prepare()
+            for (int offset = 0; offset < numSamples; offset += m_coreBlockSize)
+            {
+                const auto n = std::min (m_coreBlockSize, numSamples - offset);
+                auto* const* oversampled = path.oversampler.upsample (channels, numChannels, offset, n);
+                path.bank.process (oversampled, numChannels, n * path.oversampler.getFactor(), 1.0f, 1.0f);
+                path.oversampler.downsample (channels, numChannels, offset, n);
+            }
+        }
+
+        path.padding.process<T> (channels, channels, numChannels, numSamples);
+    }
+
+    template <typename T>
+    void Engine::processFade (T* const* channels, int numChannels, int numSamples)
+    {
+        TONIX_TRACE_SCOPE ("quality crossfade");
+        // the outgoing path runs on a copy, the incoming one in place
+        for (int ch = 0; ch < numChannels; ++ch)
+            std::copy (channels[ch], channels[ch] + numSamples, m_fadeBuffers[static_cast<size_t> (ch)].begin());
+        processPath (m_paths[m_fadingPath], m_fadePointers.data(), numChannels, numSamples);
+        processPath (m_paths[m_activePath], channels, numChannels, numSamples);
+
+        // both paths have the same latency, so a linear fade between them doesn't comb
+        const auto done = m_fadeLength - m_fadeRemaining;
+        const auto step = 1.0 / m_fadeLength;
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const auto* previous = m_fadeBuffers[static_cast<size_t> (ch)].data();
+            auto* samples = channels[ch];
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const auto gain = std::min (1.0, (done + i + 1) * step);
+                samples[i] = static_cast<T> (previous[i] + gain * (samples[i] - previous[i]));
+            }
+        }
+        m_fadeRemaining = std::max (0, m_fadeRemaining - numSamples);
+    }
+
+    template <typename T>
+    void Engine::recordHistory (const T* const* channels, int numChannels, int numSamples)
+    {
+        // only the newest kHistorySize samples matter
+        const auto start = std::max (0, numSamples - kHistorySize);
+        for (size_t ch = 0; ch < std::min (static_cast<size_t> (numChannels), m_history.size()); ++ch)
+        {
+            auto& line = m_history[ch];
+            auto index = m_historyIndex;
+            for (int i = start; i < numSamples; ++i)
+            {
+                line[static_cast<size_t> (index)] = channels[ch][i];
+                if (++index == kHistorySize)
+                    index = 0;
+            }
+        }
+        m_historyIndex = (m_historyIndex + numSamples - start) % kHistorySize;
+    }
+} // namespace tonix
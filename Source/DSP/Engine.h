@@ -0,0 +1,226 @@
+#pragma once
+
+#include "ChannelBank.h"
+#include "Oversampling.h"
+#include "Resampling.h"
+
+#include <algorithm>
+#include <array>
+
+namespace tonix
+{
+    // The channel bank inside an optional oversampler. With oversampling the whole chain
+    // runs at the higher rate, its filter coefficients scaled like the original does for
+    // high sample rates, and only the saturation products above the base band are lost.
+    // Outside of that, an optional rate converter runs the core at a canonical rate
+    // instead of the host's, so at 192 kHz the chain does a quarter of the work.
+    //
+    // Silent input puts it to sleep once the filters have flushed and the bank's memory
+    // has decayed; it then outputs zeros without processing. Bypass crossfades to the dry
+    // input delayed by the latency, and processes nothing once it's fully bypassed; coming
+    // back, the chain runs for a flush length before it fades in.
+    //
+    // Quality levels trade accuracy for CPU from the configured settings (level 0) down:
+    // table saturators, 32-bit, half the oversampling per level, no ADAA. Everything but
+    // the oversampling switches in place. Oversampling needs the fallbacks prepared: each
+    // one is a full oversampler and bank padded to the configured latency, warmed up on
+    // recent input and crossfaded in.
+    class Engine
+    {
+    public:
+        // the settings a quality level runs with
+        struct Quality
+        {
+            Precision precision;
+            SaturatorTier saturatorTier;
+            Antialiasing antialiasing;
+            int oversamplingLog2;
+
+            bool operator== (const Quality&) const = default;
+        };
+        static constexpr int kMaxQualityLevels = Oversampler::kMaxFactorLog2 + 4;
+
+        // Process and the trims glide to new values for this long
+        static constexpr double kSmoothingSeconds = 0.02;
+        // host samples between updates of the processing coefficients while they glide;
+        // the trims ramp every sample
+        static constexpr int kRampStep = 32;
+
+        // allocates, call before processing; fallbacks prepare the lower oversampling
+        // factors for quality levels. Settings survive, the quality level goes back to 0.
+        void prepare (int numChannels, double sampleRate, int maxBlockSize, int oversamplingLog2 = 0, OversamplingPhase = OversamplingPhase::Linear, InternalRate = InternalRate::Host, bool fallbacks = false);
+        void reset();
+
+        // like ChannelBank's, for the configured quality
+        void setMode (Type, Brightness);
+        // ramps there over kSmoothingSeconds, stepping every kRampStep host samples;
+        // prepare() and reset() jump to it
+        void setProcessing (double amount);
+        void setAutoGain (bool shouldUseAutoGain);
+        void setPrecision (Precision);
+        void setAntialiasing (Antialiasing);
+        void setSaturatorTier (SaturatorTier);
+
+        // the bank of the configured oversampling factor
+        const ChannelBank& getChannels() const { return m_paths.front().bank; }
+
+        int getOversamplingLog2() const { return m_paths.front().oversampler.getFactorLog2(); }
+        OversamplingPhase getOversamplingPhase() const { return m_paths.front().oversampler.getPhase(); }
+        InternalRate getInternalRate() const { return m_internalRate; }
+        // the rate the oversampler sees
+        double getCoreSampleRate() const { return m_coreSampleRate; }
+
+        // in host samples, fractional only for minimum phase; the same at every quality level
+        double getLatency() const { return m_latency; }
+        // host samples until the output is silent once the input stops, latency included
+        double getTailLength() const { return m_tailLength; }
+
+        // real-time safe, crossfades over a few milliseconds
+        void setBypassed (bool shouldBeBypassed);
+        bool isBypassed() const { return m_bypassed; }
+        // since the last process()
+        bool isAsleep() const { return m_asleep; }
+
+        // level 0 is the configured quality, each further one cheaper
+        int getNumQualityLevels() const { return m_numQualityLevels; }
+        Quality getQuality (int level) const { return m_qualityLevels[static_cast<size_t> (std::clamp (level, 0, m_numQualityLevels - 1))]; }
+        // real-time safe; applied once a running crossfade finishes
+        void setQualityLevel (int level);
+        int getQualityLevel() const { return m_qualityLevel; }
+        bool isChangingQuality() const { return m_fadeRemaining > 0; }
+
+        // in-place, numChannels <= the prepared count, any block size; trims that differ
+        // from the last block's ramp from them, except on the first block after a reset
+        void process (float* const* channels, int numChannels, int numSamples, float inputGain, float outputGain);
+        void process (double* const* channels, int numChannels, int numSamples, float inputGain, float outputGain);
+
+    private:
+        // whole-sample delay per channel
+        struct Delay
+        {
+            void prepare (int numChannels, int length);
+            void reset();
+            // output may be the input or nullptr, which only feeds the lines
+            template <typename T>
+            void process (const T* const* input, T* const* output, int numChannels, int numSamples);
+
+            std::vector<std::vector<double>> lines;
+            int length { 0 }, index { 0 };
+        };
+
+        // linear glide towards a target
+        struct Ramp
+        {
+            void prepare (int length);
+            // restarts from the current value
+            void setTarget (double);
+            void snap();
+            bool isRamping() const { return remaining > 0; }
+            // moves numSamples along, returns the new value
+            double advance (int numSamples);
+
+            double current { 0.0 }, target { 0.0 }, step { 0.0 };
+            int length { 1 }, remaining { 0 };
+        };
+
+        // offset views into a caller's channels, to process them in chunks
+        struct ChannelOffsets
+        {
+            template <typename T>
+            T* const* get (T* const* channels, int numChannels, int offset);
+
+            std::vector<float*> floats;
+            std::vector<double*> doubles;
+        };
+
+        // an oversampler and its bank, delayed to the latency of the slowest
+        struct Path
+        {
+            Oversampler oversampler;
+            ChannelBank bank;
+            Delay padding;
+        };
+
+        // what the banks run with, m_processing is where it glides to
+        void setBankProcessing (double amount);
+        void updateQualityLevels();
+        // crossfades when the level changes the oversampling factor
+        void applyQuality (bool crossfade);
+
+        template <typename T>
+        void processBypassable (T* const* channels, int numChannels, int numSamples, float inputGain, float outputGain);
+        // applies the trims around the rest, which runs at unity gain; splits the block
+        // while Process or the trims glide
+        template <typename T>
+        void processSmoothed (T* const* channels, int numChannels, int numSamples, float inputGain, float outputGain);
+        template <typename T>
+        void processAwake (T* const* channels, int numChannels, int numSamples);
+        // everything but the bypass, back to silence
+        void resetProcessing();
+        template <typename T>
+        void processConverted (T* const* channels, int numChannels, int numSamples);
+        template <typename T>
+        void processCore (T* const* channels, int numChannels, int numSamples);
+        template <typename T>
+        void processPath (Path&, T* const* channels, int numChannels, int numSamples);
+        // numSamples <= m_coreBlockSize
+        template <typename T>
+        void processFade (T* const* channels, int numChannels, int numSamples);
+        template <typename T>
+        void recordHistory (const T* const* channels, int numChannels, int numSamples);
+        void warmUp (Path&);
+
+        // [0] has the configured factor, each next one half the previous
+        std::vector<Path> m_paths = std::vector<Path> (1);
+        RateConverter m_converter;
+        InternalRate m_internalRate { InternalRate::Host };
+        double m_coreSampleRate { 44100.0 };
+        double m_latency { 0.0 }, m_tailLength { 0.0 };
+        int m_maxBlockSize { 0 };
+        // at the core rate
+        int m_coreBlockSize { 0 };
+
+        // configured settings
+        Type m_type { Type::Iridescent };
+        Brightness m_brightness { Brightness::Gold };
+        double m_processing { 0.0 };
+        bool m_useAutoGain { true };
+        Precision m_precision { Precision::Double };
+        Antialiasing m_antialiasing { Antialiasing::Off };
+        SaturatorTier m_saturatorTier { SaturatorTier::Polynomial };
+
+        std::array<Quality, kMaxQualityLevels> m_qualityLevels {};
+        int m_numQualityLevels { 1 };
+        int m_qualityLevel { 0 }, m_pendingLevel { -1 };
+        size_t m_activePath { 0 }, m_fadingPath { 0 };
+        int m_fadeLength { 0 }, m_fadeRemaining { 0 };
+        // the fading path's copy of the input
+        std::vector<std::vector<double>> m_fadeBuffers;
+        std::vector<double*> m_fadePointers;
+        ChannelOffsets m_hostOffsets, m_rampOffsets, m_coreOffsets;
+        // the last core-rate input, to warm a path up before it fades in
+        std::vector<std::vector<double>> m_history;
+        int m_historyIndex { 0 };
+
+        // Process as the banks have it, and the trims at the host rate
+        Ramp m_processingRamp, m_inputTrim, m_outputTrim;
+        // the next block's trims apply without a ramp
+        bool m_snapTrims { true };
+
+        // host samples of silent input in a row, up to m_flushLength
+        int m_silentLength { 0 }, m_flushLength { 0 };
+        bool m_asleep { false };
+
+        bool m_bypassed { false };
+        // 1 processed, 0 bypassed, between while crossfading
+        double m_wet { 1.0 }, m_bypassStep { 1.0 };
+        // host samples to process after un-bypassing before the fade starts
+        int m_preroll { 0 };
+        Delay m_dry;
+        // m_maxBlockSize of the delayed input per channel, in the host's sample type
+        std::vector<std::vector<float>> m_dryFloat;
+        std::vector<std::vector<double>> m_dryDouble;
+        std::vector<float*> m_dryFloatPointers;
+        std::vector<double*> m_dryDoublePointers;
+    };
+} // namespace tonix
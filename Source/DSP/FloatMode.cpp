@@ -0,0 +1,57 @@
+#include "FloatMode.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#define TONIX_X86_FLOAT_MODE 1
+#endif
+
+namespace tonix
+{
+    namespace
+    {
+#if TONIX_X86_FLOAT_MODE
+        // MXCSR's FTZ and DAZ
+        constexpr uint64_t kFlushToZero = 0x8040;
+#elif defined(__aarch64__) && ! defined(_MSC_VER)
+        // FPCR's FZ
+        constexpr uint64_t kFlushToZero = uint64_t (1) << 24;
+#else
+        constexpr uint64_t kFlushToZero = 0;
+#endif
+    } // namespace
+
+    uint64_t getFloatMode()
+    {
+#if TONIX_X86_FLOAT_MODE
+        return _mm_getcsr();
+#elif defined(__aarch64__) && ! defined(_MSC_VER)
+        uint64_t fpcr;
+        __asm__ volatile ("mrs %0, fpcr" : "=r"(fpcr));
+        return fpcr;
+#else
+        return 0;
+#endif
+    }
+
+    void setFloatMode ([[maybe_unused]] uint64_t mode)
+    {
+#if TONIX_X86_FLOAT_MODE
+        _mm_setcsr (static_cast<unsigned int> (mode));
+#elif defined(__aarch64__) && ! defined(_MSC_VER)
+        __asm__ volatile ("msr fpcr, %0" : : "r"(mode));
+#endif
+    }
+
+    ScopedFlushToZero::ScopedFlushToZero()
+        : m_previous (getFloatMode())
+    {
+        if ((m_previous & kFlushToZero) != kFlushToZero)
+            setFloatMode (m_previous | kFlushToZero);
+    }
+
+    ScopedFlushToZero::~ScopedFlushToZero()
+    {
+        if ((m_previous & kFlushToZero) != kFlushToZero)
+            setFloatMode (m_previous);
+    }
+} // namespace tonix
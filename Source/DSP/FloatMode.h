@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+namespace tonix
+{
+    // the thread's floating-point control register: MXCSR on x86, FPCR on arm64, 0
+    // elsewhere
+    uint64_t getFloatMode();
+    void setFloatMode (uint64_t mode);
+
+    // Flush-to-zero and denormals-are-zero until it goes out of scope, like the
+    // juce::ScopedNoDenormals the plugin processes under. The saturators' higher powers
+    // run into subnormals on quiet input otherwise, which costs time and changes the
+    // output.
+    class ScopedFlushToZero
+    {
+    public:
+        ScopedFlushToZero();
+        ~ScopedFlushToZero();
+
+        ScopedFlushToZero (const ScopedFlushToZero&) = delete;
+        ScopedFlushToZero& operator= (const ScopedFlushToZero&) = delete;
+
+    private:
+        uint64_t m_previous;
+    };
+} // namespace tonix
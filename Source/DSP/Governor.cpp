@@ -0,0 +1,70 @@
+#include "Governor.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace tonix
+{
+    void CpuGovernor::prepare (const Options& options)
+    {
+        m_options = options;
+        reset();
+    }
+
+    void CpuGovernor::reset()
+    {
+        m_hold = m_options.hold;
+        m_sinceStepUp = -1.0;
+        setLevel (0);
+    }
+
+    void CpuGovernor::setLevel (int level)
+    {
+        // the old level's load says little about the new one
+        m_level = level;
+        m_average = -1.0;
+        m_atLevel = 0.0;
+        m_calm = 0.0;
+    }
+
+    int CpuGovernor::update (double processingSeconds, double blockSeconds, int numLevels)
+    {
+        if (m_level >= numLevels)
+            setLevel (std::max (0, numLevels - 1));
+        if (blockSeconds <= 0.0)
+            return m_level;
+
+        const auto load = processingSeconds / blockSeconds;
+        if (m_average < 0.0)
+            m_average = load;
+        else
+            m_average += (1.0 - std::exp (-blockSeconds / m_options.averaging)) * (load - m_average);
+        m_atLevel += blockSeconds;
+        if (m_sinceStepUp >= 0.0)
+            m_sinceStepUp += blockSeconds;
+        // long stable stretches forget earlier back-offs
+        if (m_atLevel >= m_options.maxHold)
+            m_hold = m_options.hold;
+
+        const auto overloaded = load > m_options.critical || (m_average > m_options.high && m_atLevel >= m_options.averaging);
+        if (overloaded)
+        {
+            if (m_level + 1 >= numLevels)
+                return m_level;
+            // the last step up didn't hold, wait longer before the next one
+            if (m_sinceStepUp >= 0.0 && m_sinceStepUp < m_hold)
+                m_hold = std::min (m_hold * 2.0, m_options.maxHold);
+            m_sinceStepUp = -1.0;
+            setLevel (m_level + 1);
+            return m_level;
+        }
+
+        m_calm = m_average < m_options.low ? m_calm + blockSeconds : 0.0;
+        if (m_level > 0 && m_calm >= m_hold)
+        {
+            setLevel (m_level - 1);
+            m_sinceStepUp = 0.0;
+        }
+        return m_level;
+    }
+} // namespace tonix
@@ -0,0 +1,49 @@
+#pragma once
+
+namespace tonix
+{
+    // Picks an Engine quality level from how long each block took against its deadline,
+    // the block's duration. Steps down right away when a single block gets close to the
+    // deadline or the average load stays high, and back up only once the load has been
+    // low for a while. Stepping back down soon after a step up doubles that wait, so a
+    // level the machine can't sustain isn't retried every few seconds.
+    class CpuGovernor
+    {
+    public:
+        struct Options
+        {
+            // fractions of the block's duration spent processing; the host's deadline is
+            // shared with everything else in the session, so these stay well below 1
+            double critical { 0.7 };
+            double high { 0.4 };
+            double low { 0.2 };
+            // seconds of audio
+            double averaging { 0.25 };
+            double hold { 2.0 }, maxHold { 60.0 };
+        };
+
+        void prepare (const Options&);
+        void reset();
+
+        // feed every processed block; returns the level for the next one, in
+        // [0, numLevels). Real-time safe.
+        int update (double processingSeconds, double blockSeconds, int numLevels);
+
+        int getLevel() const { return m_level; }
+        // smoothed fraction of the deadline used at the current level
+        double getAverageLoad() const { return m_average; }
+
+    private:
+        void setLevel (int level);
+
+        Options m_options;
+        int m_level { 0 };
+        // negative until the first block at the current level
+        double m_average { -1.0 };
+        // seconds of audio at the current level, and with the average below low
+        double m_atLevel { 0.0 }, m_calm { 0.0 };
+        double m_hold { 2.0 };
+        // since the last step up, negative if it was followed by a step down
+        double m_sinceStepUp { -1.0 };
+    };
+} // namespace tonix
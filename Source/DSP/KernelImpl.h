@@ -0,0 +1,558 @@
+#pragma once
+
+#include "Kernels.h"
+#include "Stages.h"
+
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+// Kernel templates, compiled once per instruction set by Kernels.cpp and
+// Kernels<ISA>.cpp. Everything here is in the ISA's inline namespace (see Simd.h);
+// keep calls out of it to trivial inline functions so no differently flagged copy of
+// shared code can leak into the rest of the binary.
+namespace tonix::inline TONIX_ISA_NAMESPACE
+{
+    namespace kernels
+    {
+        // Stage coefficients with everything the Type decides known at compile time.
+        // Static members are read through the instance (c.f1) like the runtime version,
+        // so the stage functions don't need to know which one they got. V is a
+        // simd::Vec where every lane has its own filters and Process (the batch kernels).
+        template <typename T, Type Mode, typename V = T>
+        struct FixedCoefficients
+        {
+            static constexpr detail::TypeDefinition def = detail::kTypes[static_cast<size_t> (Mode)];
+            static constexpr int curve = def.saturatorType;
+            static constexpr T f1 = static_cast<T> (def.f1), p20 = static_cast<T> (def.p20), p24 = static_cast<T> (def.p24);
+            static constexpr bool luster = Mode == Type::Luster, g0 = def.g0;
+            static constexpr T outScale = luster ? T (0.5) : T (1);
+
+            V hpf_k, lpf_k, curProcessing;
+        };
+
+        template <typename T, int Curve>
+        struct RuntimeCoefficients : StageCoefficients<T>
+        {
+            static constexpr int curve = Curve;
+        };
+
+        // channels per lane group: a full register, but at least a pair
+        template <typename T>
+        constexpr size_t kLanes = std::max<size_t> (simd::kNativeWidth<T>, 2);
+        static_assert (kLanes<float> <= kMaxLanes && kLanes<double> <= kMaxLanes);
+
+        // half a register, for the channels left over from full groups in tiny blocks
+        template <typename T>
+        constexpr size_t kNarrowLanes = std::max<size_t> (kLanes<T> / 2, 2);
+
+        // below this many samples the time-vectorized path spends most of a call in its
+        // scalar remainder
+        template <typename T>
+        constexpr int kTinyBlock = 2 * static_cast<int> (simd::kNativeWidth<T>);
+
+        // scratch of the kernel's precision, from KernelArgs or BatchArgs
+        template <typename T, typename Args>
+        T* getInput (const Args& a)
+        {
+            if constexpr (std::is_same_v<T, float>)
+                return a.inputFloat;
+            else
+                return a.input;
+        }
+
+        template <typename T, typename Args>
+        T* getWork (const Args& a)
+        {
+            if constexpr (std::is_same_v<T, float>)
+                return a.workFloat;
+            else
+                return a.work;
+        }
+
+        template <typename T>
+        T* getSaturatorInput (const KernelArgs& a)
+        {
+            if constexpr (std::is_same_v<T, float>)
+                return a.saturatorInputFloat;
+            else
+                return a.saturatorInput;
+        }
+
+        // f (V(), i) over [0, n), whole registers first and the rest one sample at a time
+        template <typename T, typename F>
+        void acrossTime (int n, F&& f)
+        {
+            using Vec = simd::Vec<T, simd::kNativeWidth<T>>;
+            constexpr int width = static_cast<int> (Vec::size);
+            int i = 0;
+            for (; i + width <= n; i += width)
+                f (Vec(), i);
+            for (; i < n; ++i)
+                f (simd::Vec<T, 1>(), i);
+        }
+
+        // per-channel memory is kept in double so the precision can change between blocks
+        template <typename V, typename T>
+        V loadState (const double* p)
+        {
+            if constexpr (std::is_same_v<T, double>)
+            {
+                return V::load (p);
+            }
+            else
+            {
+                T narrowed[V::size];
+                for (size_t i = 0; i < V::size; ++i)
+                    narrowed[i] = static_cast<T> (p[i]);
+                return V::load (narrowed);
+            }
+        }
+
+        template <typename T, typename V>
+        void storeState (V v, double* p)
+        {
+            T values[V::size];
+            v.store (values);
+            for (size_t i = 0; i < V::size; ++i)
+                p[i] = values[i];
+        }
+
+        // host buffers of the I/O sample type
+        template <typename IO>
+        IO* const* getChannels (const KernelArgs& a)
+        {
+            if constexpr (std::is_same_v<IO, double>)
+                return a.channelsDouble;
+            else
+                return a.channels;
+        }
+
+        // whole chain up to the gains, one frame of all lanes at a time; xs holds the
+        // previous frame in front, work receives n frames
+        template <Shaping S, typename Vec, typename C, typename T>
+        void processFrames (const T* xs, T* work, int n, Vec& state, Vec lpf, Vec& prevDrive, Vec& prevBlend, const C& c, [[maybe_unused]] const SaturatorTable<T>* table)
+        {
+            constexpr auto lanes = static_cast<int> (Vec::size);
+            for (int i = 0; i < n; ++i)
+            {
+                const auto x = Vec::load (xs + (i + 1) * lanes);
+                Vec x5;
+                if constexpr (S == Shaping::Adaa)
+                    x5 = shapeStageAdaa<C::curve> (x, Vec::load (xs + i * lanes), prevDrive, prevBlend, c);
+                else if constexpr (S == Shaping::Table)
+                    x5 = shapeStageTable (x, Vec::load (xs + i * lanes), c, *table);
+                else
+                    x5 = shapeStage<C::curve> (x, Vec::load (xs + i * lanes), c);
+                const auto s = lowpassStage (state, x5, lpf);
+                mixStage (x, s, c).store (work + i * lanes);
+            }
+        }
+
+        // T is the precision the chain runs in, IO the host's sample type
+        template <typename T, typename IO, size_t Lanes, bool AutoGain, Shaping S, typename C>
+        void processLanes (const KernelArgs& a, int firstChannel, const C& c)
+        {
+            constexpr bool adaa = S == Shaping::Adaa;
+            using Vec = simd::Vec<T, Lanes>;
+            constexpr auto lanes = static_cast<int> (Lanes);
+
+            const Vec lpf (c.lpf_k);
+            const T autoGain = static_cast<T> (a.autoGain);
+            const T outputGain = a.outputGain;
+            const IO inputGain = a.inputGain;
+            IO* const* channels = getChannels<IO> (a);
+            T* const xs = getInput<T> (a);
+            T* const work = getWork<T> (a);
+            const auto first = static_cast<size_t> (firstChannel);
+            [[maybe_unused]] const SaturatorTable<T>* table = S == Shaping::Table ? &a.saturatorTables->get<T> (C::curve) : nullptr;
+
+            Vec state = loadState<Vec, T> (a.lpfState + first);
+            loadState<Vec, T> (a.prevInput + first).store (xs);
+            // only ADAA reads and advances them
+            Vec prevDrive, prevBlend;
+            if constexpr (adaa)
+            {
+                prevDrive = loadState<Vec, T> (a.prevDrive + first);
+                prevBlend = loadState<Vec, T> (a.prevBlend + first);
+            }
+
+            for (int offset = 0; offset < a.numSamples; offset += kChunkSize)
+            {
+                const auto n = std::min (kChunkSize, a.numSamples - offset);
+
+                // input trim, interleaving the group's channels
+                for (int l = 0; l < lanes; ++l)
+                {
+                    const IO* in = channels[firstChannel + l] + offset;
+                    for (int i = 0; i < n; ++i)
+                        xs[(i + 1) * lanes + l] = static_cast<T> (in[i] * inputGain);
+                }
+
+                processFrames<S> (xs, work, n, state, lpf, prevDrive, prevBlend, c, table);
+
+                // gains, back to planar
+                for (int l = 0; l < lanes; ++l)
+                {
+                    IO* out = channels[firstChannel + l] + offset;
+                    for (int i = 0; i < n; ++i)
+                    {
+                        if constexpr (AutoGain)
+                            out[i] = static_cast<IO> (work[i * lanes + l] * autoGain * outputGain);
+                        else
+                            out[i] = static_cast<IO> (work[i * lanes + l] * outputGain);
+                    }
+                }
+
+                // the last frame becomes the previous one of the next chunk
+                Vec::load (xs + n * lanes).store (xs);
+            }
+
+            storeState<T> (state, a.lpfState + first);
+            storeState<T> (Vec::load (xs), a.prevInput + first);
+            if constexpr (adaa)
+            {
+                storeState<T> (prevDrive, a.prevDrive + first);
+                storeState<T> (prevBlend, a.prevBlend + first);
+            }
+        }
+
+        template <typename T, typename IO, bool AutoGain, Shaping S, typename C>
+        void processSingle (const KernelArgs& a, int channel, const C& c)
+        {
+            using Vec = simd::Vec<T, simd::kNativeWidth<T>>;
+            using Scalar = simd::Vec<T, 1>;
+            constexpr int width = static_cast<int> (Vec::size);
+
+            const T autoGain = static_cast<T> (a.autoGain);
+            const T outputGain = a.outputGain;
+            const IO inputGain = a.inputGain;
+            T* const xs = getInput<T> (a);
+            T* const work = getWork<T> (a);
+            auto& state = a.lpfState[channel];
+            auto& prevInput = a.prevInput[channel];
+            [[maybe_unused]] const SaturatorTable<T>* table = S == Shaping::Table ? &a.saturatorTables->get<T> (C::curve) : nullptr;
+
+            for (int offset = 0; offset < a.numSamples; offset += kChunkSize)
+            {
+                const auto n = std::min (kChunkSize, a.numSamples - offset);
+                IO* const io = getChannels<IO> (a)[channel] + offset;
+
+                // input trim, keeping the previous sample in front for the HPF difference
+                xs[0] = static_cast<T> (prevInput);
+                for (int i = 0; i < n; ++i)
+                    xs[i + 1] = static_cast<T> (io[i] * inputGain);
+
+                if constexpr (S == Shaping::Adaa)
+                {
+                    // each saturator needs its previous input, so they take one pass each
+                    // with that input in front
+                    T* const u = getSaturatorInput<T> (a);
+                    u[0] = static_cast<T> (a.prevDrive[channel]);
+                    acrossTime<T> (n, [&] (auto v, int j)
+                                   {
+                        using V = decltype (v);
+                        driveInput (filterStage (V::load (xs + j + 1), V::load (xs + j), c), c).store (u + j + 1); });
+                    acrossTime<T> (n, [&] (auto v, int j)
+                                   {
+                        using V = decltype (v);
+                        saturateAdaa<C::curve> (V::load (u + j + 1), V::load (u + j)).store (work + j); });
+                    a.prevDrive[channel] = u[n];
+
+                    u[0] = static_cast<T> (a.prevBlend[channel]);
+                    acrossTime<T> (n, [&] (auto v, int j)
+                                   {
+                        using V = decltype (v);
+                        const auto x = V::load (xs + j + 1);
+                        blendInput (x, filterStage (x, V::load (xs + j), c), V::load (work + j), c).store (u + j + 1); });
+                    acrossTime<T> (n, [&] (auto v, int j)
+                                   {
+                        using V = decltype (v);
+                        saturateAdaa<C::curve> (V::load (u + j + 1), V::load (u + j)).store (work + j); });
+                    a.prevBlend[channel] = u[n];
+                }
+                else if constexpr (S == Shaping::Table)
+                {
+                    int i = 0;
+                    for (; i + width <= n; i += width)
+                        shapeStageTable (Vec::load (xs + i + 1), Vec::load (xs + i), c, *table).store (work + i);
+                    for (; i < n; ++i)
+                        shapeStageTable (Scalar::load (xs + i + 1), Scalar::load (xs + i), c, *table).store (work + i);
+                }
+                else
+                {
+                    // memoryless stages across time
+                    int i = 0;
+                    for (; i + width <= n; i += width)
+                        shapeStage<C::curve> (Vec::load (xs + i + 1), Vec::load (xs + i), c).store (work + i);
+                    for (; i < n; ++i)
+                        shapeStage<C::curve> (Scalar::load (xs + i + 1), Scalar::load (xs + i), c).store (work + i);
+                }
+
+                int i = 0;
+                T s = static_cast<T> (state);
+                for (; i < n; ++i)
+                    work[i] = lowpassStage (s, work[i], c.lpf_k);
+                state = s;
+                prevInput = xs[n];
+
+                for (i = 0; i + width <= n; i += width)
+                    mixStage (Vec::load (xs + i + 1), Vec::load (work + i), c).store (work + i);
+                for (; i < n; ++i)
+                    mixStage (Scalar::load (xs + i + 1), Scalar::load (work + i), c).store (work + i);
+
+                for (i = 0; i < n; ++i)
+                {
+                    if constexpr (AutoGain)
+                        io[i] = static_cast<IO> (work[i] * autoGain * outputGain);
+                    else
+                        io[i] = static_cast<IO> (work[i] * outputGain);
+                }
+            }
+        }
+
+        template <typename T, typename IO, bool AutoGain, Shaping S, typename C>
+        void processChannels (const KernelArgs& a, const C& c)
+        {
+            constexpr auto lanes = static_cast<int> (kLanes<T>);
+            int ch = 0;
+            for (; ch + lanes <= a.numChannels; ch += lanes)
+                processLanes<T, IO, kLanes<T>, AutoGain, S> (a, ch, c);
+            // tiny blocks take the rest in half-width groups where there are any; pairs
+            // of 128-bit lanes measured slower than single channels under AVX-512
+            if constexpr (kNarrowLanes<T> < kLanes<T>)
+            {
+                constexpr auto narrow = static_cast<int> (kNarrowLanes<T>);
+                if (a.numSamples < kTinyBlock<T>)
+                    for (; ch + narrow <= a.numChannels; ch += narrow)
+                        processLanes<T, IO, kNarrowLanes<T>, AutoGain, S> (a, ch, c);
+            }
+            // a partly filled group would waste lanes, the time-vectorized path is wider
+            for (; ch < a.numChannels; ++ch)
+                processSingle<T, IO, AutoGain, S> (a, ch, c);
+        }
+
+        template <typename T, typename IO, Type Mode, bool AutoGain, Shaping S>
+        void specialized (const KernelArgs& a)
+        {
+            using C = FixedCoefficients<T, Mode>;
+            processChannels<T, IO, AutoGain, S> (a, C { static_cast<T> (a.hpf_k), static_cast<T> (a.lpf_k), static_cast<T> (a.processing * C::def.a3) });
+        }
+
+        template <typename T, typename IO, int Curve, Shaping S>
+        void generic (const KernelArgs& a)
+        {
+            const auto& m = *a.mode;
+            RuntimeCoefficients<T, Curve> c;
+            static_cast<StageCoefficients<T>&> (c) = { static_cast<T> (a.hpf_k), static_cast<T> (a.lpf_k), static_cast<T> (m.f1), static_cast<T> (m.p20), static_cast<T> (m.p24), static_cast<T> (a.processing * m.a3), a.luster ? T (0.5) : T (1), a.luster, m.g0 };
+            auto args = a;
+            args.autoGain = a.useAutoGain ? a.autoGain : 1.0;
+            processChannels<T, IO, true, S> (args, c);
+        }
+
+        // Matches the full kernels at zero processing bit for bit: the mix returns the
+        // trimmed input unchanged and auto-gain is exactly 1. Only the HPF's previous input
+        // is kept up to date; the LPF resettles within a few samples once Process moves.
+        template <typename T, typename IO>
+        void gain (const KernelArgs& a)
+        {
+            const T outputGain = a.outputGain;
+            const IO inputGain = a.inputGain;
+            IO* const* channels = getChannels<IO> (a);
+            for (int ch = 0; ch < a.numChannels; ++ch)
+            {
+                IO* const io = channels[ch];
+                if (a.numSamples > 0)
+                    a.prevInput[ch] = static_cast<T> (io[a.numSamples - 1] * inputGain);
+                for (int i = 0; i < a.numSamples; ++i)
+                    io[i] = static_cast<IO> (static_cast<T> (io[i] * inputGain) * outputGain);
+            }
+        }
+
+        // A group of a BatchEngine Type's streams, like processLanes but with each lane's
+        // filters, Process, auto-gain and trims read from the arrays. Lanes from used on
+        // are computed but never read from or written back to a buffer.
+        template <typename T, size_t Lanes, Type Mode, Shaping S>
+        void processStreams (const BatchArgs& a, int firstStream, int used)
+        {
+            constexpr bool adaa = S == Shaping::Adaa;
+            constexpr auto lanes = static_cast<int> (Lanes);
+            using Vec = simd::Vec<T, Lanes>;
+            using C = FixedCoefficients<T, Mode, Vec>;
+            T* const xs = getInput<T> (a);
+            T* const work = getWork<T> (a);
+            [[maybe_unused]] const SaturatorTable<T>* table = S == Shaping::Table ? &a.saturatorTables->get<T> (C::curve) : nullptr;
+
+            const auto first = static_cast<size_t> (firstStream);
+            float* io[Lanes];
+            float inputGain[Lanes];
+            T hpf_k[Lanes], lpf_k[Lanes], curProcessing[Lanes], autoGain[Lanes], outputGain[Lanes];
+            for (size_t l = 0; l < Lanes; ++l)
+            {
+                io[l] = static_cast<int> (l) < used ? a.streams[a.ids[first + l]] : nullptr;
+                inputGain[l] = a.inputGain[first + l];
+                hpf_k[l] = static_cast<T> (a.hpf_k[first + l]);
+                lpf_k[l] = static_cast<T> (a.lpf_k[first + l]);
+                curProcessing[l] = static_cast<T> (a.processing[first + l] * C::def.a3);
+                autoGain[l] = static_cast<T> (a.autoGain[first + l]);
+                outputGain[l] = a.outputGain[first + l];
+            }
+            const C c { Vec::load (hpf_k), Vec::load (lpf_k), Vec::load (curProcessing) };
+
+            Vec state = loadState<Vec, T> (a.lpfState + first);
+            loadState<Vec, T> (a.prevInput + first).store (xs);
+            Vec prevDrive, prevBlend;
+            if constexpr (adaa)
+            {
+                prevDrive = loadState<Vec, T> (a.prevDrive + first);
+                prevBlend = loadState<Vec, T> (a.prevBlend + first);
+            }
+
+            for (int offset = 0; offset < a.numSamples; offset += kChunkSize)
+            {
+                const auto n = std::min (kChunkSize, a.numSamples - offset);
+
+                // unused lanes run on silence, what an earlier group left there could
+                // produce subnormals
+                for (int l = 0; l < lanes; ++l)
+                {
+                    if (l >= used)
+                    {
+                        for (int i = 0; i < n; ++i)
+                            xs[(i + 1) * lanes + l] = T (0);
+                        continue;
+                    }
+                    const float* in = io[l] + offset;
+                    for (int i = 0; i < n; ++i)
+                        xs[(i + 1) * lanes + l] = static_cast<T> (in[i] * inputGain[l]);
+                }
+
+                processFrames<S> (xs, work, n, state, c.lpf_k, prevDrive, prevBlend, c, table);
+
+                for (int l = 0; l < used; ++l)
+                {
+                    float* out = io[l] + offset;
+                    for (int i = 0; i < n; ++i)
+                        out[i] = static_cast<float> (work[i * lanes + l] * autoGain[l] * outputGain[l]);
+                }
+
+                Vec::load (xs + n * lanes).store (xs);
+            }
+
+            storeState<T> (state, a.lpfState + first);
+            storeState<T> (Vec::load (xs), a.prevInput + first);
+            if constexpr (adaa)
+            {
+                storeState<T> (prevDrive, a.prevDrive + first);
+                storeState<T> (prevBlend, a.prevBlend + first);
+            }
+        }
+
+        // full register groups, then the rest in one group of half the width if it fits;
+        // the arrays are padded, so reading a full group's entries is always safe
+        template <typename T, Type Mode, Shaping S>
+        void batch (const BatchArgs& a)
+        {
+            constexpr auto lanes = static_cast<int> (kLanes<T>);
+            int stream = 0;
+            for (; stream + lanes <= a.numStreams; stream += lanes)
+                processStreams<T, kLanes<T>, Mode, S> (a, stream, lanes);
+            const auto rest = a.numStreams - stream;
+            if (rest > static_cast<int> (kNarrowLanes<T>))
+                processStreams<T, kLanes<T>, Mode, S> (a, stream, rest);
+            else if (rest > 0)
+                processStreams<T, kNarrowLanes<T>, Mode, S> (a, stream, rest);
+        }
+
+        // time-vectorized, output samples across the lanes
+        inline void halfband (const double* x, double* out, int numSamples, const double* taps, int numTaps)
+        {
+            using Vec = simd::Vec<double, simd::kNativeDoubles>;
+            constexpr int width = static_cast<int> (Vec::size);
+            const int delay = 2 * numTaps - 1;
+
+            int i = 0;
+            // independent accumulators hide the multiply-add latency
+            for (; i + 4 * width <= numSamples; i += 4 * width)
+            {
+                Vec a0 (0.0), a1 (0.0), a2 (0.0), a3 (0.0);
+                const auto* y = x + i;
+                for (int k = 0; k < numTaps; ++k)
+                {
+                    const Vec tap (taps[k]);
+                    a0 = mulAdd (tap, Vec::load (y + delay - k) + Vec::load (y + k), a0);
+                    a1 = mulAdd (tap, Vec::load (y + width + delay - k) + Vec::load (y + width + k), a1);
+                    a2 = mulAdd (tap, Vec::load (y + 2 * width + delay - k) + Vec::load (y + 2 * width + k), a2);
+                    a3 = mulAdd (tap, Vec::load (y + 3 * width + delay - k) + Vec::load (y + 3 * width + k), a3);
+                }
+                a0.store (out + i);
+                a1.store (out + i + width);
+                a2.store (out + i + 2 * width);
+                a3.store (out + i + 3 * width);
+            }
+            for (; i + width <= numSamples; i += width)
+            {
+                Vec acc (0.0);
+                for (int k = 0; k < numTaps; ++k)
+                    acc = mulAdd (Vec (taps[k]), Vec::load (x + i + delay - k) + Vec::load (x + i + k), acc);
+                acc.store (out + i);
+            }
+            for (; i < numSamples; ++i)
+            {
+                double acc = 0.0;
+                for (int k = 0; k < numTaps; ++k)
+                    acc = simd::mulAdd (taps[k], x[i + delay - k] + x[i + k], acc);
+                out[i] = acc;
+            }
+        }
+
+        template <typename T, typename IO, Shaping S, size_t... M>
+        constexpr auto makeSpecializedKernels (std::index_sequence<M...>)
+        {
+            return std::array<std::array<Kernel, 2>, kNumTypes> { { { { &specialized<T, IO, static_cast<Type> (M), false, S>, &specialized<T, IO, static_cast<Type> (M), true, S> } }... } };
+        }
+
+        template <typename T, typename IO, Shaping S>
+        constexpr std::array<Kernel, 3> makeGenericKernels()
+        {
+            return { &generic<T, IO, 0, S>, &generic<T, IO, 1, S>, &generic<T, IO, 2, S> };
+        }
+
+        template <typename T, typename IO>
+        constexpr KernelSet makeKernelSet()
+        {
+            constexpr auto types = std::make_index_sequence<kNumTypes> {};
+            KernelSet set {};
+            set.specialized = { makeSpecializedKernels<T, IO, Shaping::Polynomial> (types), makeSpecializedKernels<T, IO, Shaping::Adaa> (types), makeSpecializedKernels<T, IO, Shaping::Table> (types) };
+            set.generic = { makeGenericKernels<T, IO, Shaping::Polynomial>(), makeGenericKernels<T, IO, Shaping::Adaa>(), makeGenericKernels<T, IO, Shaping::Table>() };
+            set.gain = &gain<T, IO>;
+            return set;
+        }
+
+        template <typename T, Shaping S, size_t... M>
+        constexpr std::array<BatchKernel, kNumTypes> makeBatchKernels (std::index_sequence<M...>)
+        {
+            return { &batch<T, static_cast<Type> (M), S>... };
+        }
+
+        template <typename T>
+        constexpr auto makeBatchKernels()
+        {
+            constexpr auto types = std::make_index_sequence<kNumTypes> {};
+            return std::array<std::array<BatchKernel, kNumTypes>, kNumShapings> { makeBatchKernels<T, Shaping::Polynomial> (types), makeBatchKernels<T, Shaping::Adaa> (types), makeBatchKernels<T, Shaping::Table> (types) };
+        }
+
+        constexpr KernelTable makeKernelTable()
+        {
+            KernelTable table {};
+            table.sets = { { { makeKernelSet<double, float>(), makeKernelSet<float, float>() },
+                             { makeKernelSet<double, double>(), makeKernelSet<float, double>() } } };
+            table.batch = { makeBatchKernels<double>(), makeBatchKernels<float>() };
+            table.halfband = &halfband;
+            return table;
+        }
+    } // namespace kernels
+
+    // this translation unit's table, defined in the ISA's Kernels*.cpp
+    const KernelTable& getKernelTable();
+} // namespace tonix::inline TONIX_ISA_NAMESPACE
@@ -0,0 +1,189 @@
+#include "KernelImpl.h"
+
+#include <cstdlib>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define TONIX_X86_KERNELS 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace tonix
+{
+    // baseline of this architecture, built with the target's own flags
+    inline namespace TONIX_ISA_NAMESPACE
+    {
+        const KernelTable& getKernelTable()
+        {
+            static constexpr auto table = kernels::makeKernelTable();
+            return table;
+        }
+    } // namespace TONIX_ISA_NAMESPACE
+
+    // tables of the other ISA translation units
+    namespace scalar
+    {
+        const KernelTable& getKernelTable();
+    }
+#if TONIX_X86_KERNELS
+    namespace avx2
+    {
+        const KernelTable& getKernelTable();
+    }
+    namespace avx512
+    {
+        const KernelTable& getKernelTable();
+    }
+#endif
+
+    namespace
+    {
+#if TONIX_X86_KERNELS
+        struct CpuFeatures
+        {
+            bool avx2 { false }, avx512 { false };
+        };
+
+        void cpuid (int leaf, int subleaf, unsigned int (&regs)[4])
+        {
+#if defined(_MSC_VER)
+            int r[4];
+            __cpuidex (r, leaf, subleaf);
+            for (int i = 0; i < 4; ++i)
+                regs[i] = static_cast<unsigned int> (r[i]);
+#else
+            __cpuid_count (leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+        }
+
+        // register state the OS saves on context switches
+        unsigned long long xgetbv()
+        {
+#if defined(_MSC_VER)
+            return _xgetbv (0);
+#else
+            unsigned int eax, edx;
+            __asm__ volatile ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+            return (static_cast<unsigned long long> (edx) << 32) | eax;
+#endif
+        }
+
+        CpuFeatures detectCpuFeatures()
+        {
+            CpuFeatures features;
+            unsigned int regs[4] {};
+            cpuid (0, 0, regs);
+            const auto maxLeaf = regs[0];
+            if (maxLeaf < 7)
+                return features;
+
+            cpuid (1, 0, regs);
+            const bool osxsave = (regs[2] & (1u << 27)) != 0;
+            const bool avx = (regs[2] & (1u << 28)) != 0;
+            const bool fma = (regs[2] & (1u << 12)) != 0;
+            if (! osxsave || ! avx)
+                return features;
+
+            // XMM and YMM, then opmask and both ZMM halves
+            const auto xcr0 = xgetbv();
+            const bool osYmm = (xcr0 & 0x06) == 0x06;
+            const bool osZmm = (xcr0 & 0xe6) == 0xe6;
+
+            cpuid (7, 0, regs);
+            const bool avx2 = (regs[1] & (1u << 5)) != 0;
+            const bool avx512f = (regs[1] & (1u << 16)) != 0;
+
+            features.avx2 = osYmm && avx2 && fma;
+            features.avx512 = features.avx2 && osZmm && avx512f;
+            return features;
+        }
+
+        const CpuFeatures& getCpuFeatures()
+        {
+            static const auto features = detectCpuFeatures();
+            return features;
+        }
+#endif
+
+        constexpr const char* kIsaNames[] = { "scalar", "sse2", "neon", "avx2", "avx512" };
+
+#if TONIX_SIMD_SSE2
+        constexpr std::optional<Isa> kBaselineIsa = Isa::SSE2;
+#elif TONIX_SIMD_NEON
+        constexpr std::optional<Isa> kBaselineIsa = Isa::NEON;
+#else
+        constexpr std::optional<Isa> kBaselineIsa;
+#endif
+    } // namespace
+
+    const char* getIsaName (Isa isa)
+    {
+        return kIsaNames[static_cast<size_t> (isa)];
+    }
+
+    std::optional<Isa> getIsaFromName (std::string_view name)
+    {
+        for (size_t i = 0; i < std::size (kIsaNames); ++i)
+            if (name == kIsaNames[i])
+                return static_cast<Isa> (i);
+        return std::nullopt;
+    }
+
+    bool isIsaSupported (Isa isa)
+    {
+        switch (isa)
+        {
+            case Isa::Scalar:
+                return true;
+            case Isa::SSE2:
+            case Isa::NEON:
+                return kBaselineIsa == isa;
+#if TONIX_X86_KERNELS
+            case Isa::AVX2:
+                return getCpuFeatures().avx2;
+            case Isa::AVX512:
+                return getCpuFeatures().avx512;
+#endif
+            default:
+                return false;
+        }
+    }
+
+    Isa getBestIsa()
+    {
+        for (const auto isa : { Isa::AVX512, Isa::AVX2, Isa::NEON, Isa::SSE2 })
+            if (isIsaSupported (isa))
+                return isa;
+        return Isa::Scalar;
+    }
+
+    Isa getPreferredIsa()
+    {
+        // forcing a tier is meant for testing, so it is read every time
+        if (const auto* forced = std::getenv ("TONIX_ISA"))
+            if (const auto isa = getIsaFromName (forced); isa && isIsaSupported (*isa))
+                return *isa;
+        return getBestIsa();
+    }
+
+    const KernelTable& getKernelTable (Isa isa)
+    {
+        switch (isa)
+        {
+#if TONIX_X86_KERNELS
+            case Isa::AVX512:
+                return avx512::getKernelTable();
+            case Isa::AVX2:
+                return avx2::getKernelTable();
+#endif
+            case Isa::SSE2:
+            case Isa::NEON:
+                return getKernelTable();
+            default:
+                return scalar::getKernelTable();
+        }
+    }
+} // namespace tonix
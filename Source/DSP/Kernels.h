@@ -0,0 +1,152 @@
+#pragma once
+
+#include "Coefficients.h"
+#include "SaturatorTable.h"
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+namespace tonix
+{
+    // frames processed per pass
+    constexpr int kChunkSize = 256;
+
+    // widest lane group of any instruction set (AVX-512 floats), sizes the scratch buffers
+    constexpr size_t kMaxLanes = 16;
+
+    // sample type the kernels compute in, independent of the host's sample type
+    enum class Precision
+    {
+        Double,
+        Float
+    };
+    constexpr size_t kNumPrecisions = 2;
+
+    // how a kernel evaluates the saturators, from Antialiasing and SaturatorTier; ADAA
+    // needs the polynomial's antiderivative, so it takes precedence over the table
+    enum class Shaping
+    {
+        Polynomial,
+        Adaa,
+        Table
+    };
+    constexpr size_t kNumShapings = 3;
+
+    // everything a kernel needs for one block, filled by ChannelBank
+    struct KernelArgs
+    {
+        // one of them is set, depending on the host's sample type
+        float* const* channels;
+        double* const* channelsDouble;
+        int numChannels, numSamples;
+        float inputGain, outputGain;
+
+        // sample-rate scaled filter coefficients
+        double hpf_k, lpf_k;
+        double processing;
+        double autoGain;
+        bool useAutoGain;
+        // only read by the generic kernels
+        const ModeCoefficients* mode;
+        bool luster;
+
+        // per-channel memory, always double, see ChannelBank
+        double* lpfState;
+        double* prevInput;
+        // last input of each saturator, only used by the ADAA kernels
+        double *prevDrive, *prevBlend;
+        // only read by the table kernels
+        const SaturatorTables* saturatorTables;
+        // scratch for each precision
+        double *input, *work, *saturatorInput;
+        float *inputFloat, *workFloat, *saturatorInputFloat;
+    };
+
+    using Kernel = void (*) (const KernelArgs&);
+
+    // one Type's streams of a BatchEngine, packed: the arrays hold an entry per stream,
+    // padded to a multiple of kMaxLanes
+    struct BatchArgs
+    {
+        // host buffers by stream id, float only
+        float* const* streams;
+        const int* ids;
+        int numStreams, numSamples;
+
+        // per stream: sample-rate scaled filter coefficients, Process, auto-gain (1 while
+        // off) and trims
+        const double *hpf_k, *lpf_k, *processing, *autoGain;
+        const float *inputGain, *outputGain;
+
+        // per-stream memory, like KernelArgs
+        double *lpfState, *prevInput, *prevDrive, *prevBlend;
+        const SaturatorTables* saturatorTables;
+        // lane-interleaved scratch for each precision
+        double *input, *work;
+        float *inputFloat, *workFloat;
+    };
+
+    using BatchKernel = void (*) (const BatchArgs&);
+
+    // Even branch of a polyphase half-band FIR (see Oversampling.cpp), symmetric:
+    // out[i] = sum_k taps[k] * (x[i + delay - k] + x[i + k]) with delay = 2 * numTaps - 1,
+    // so x holds delay samples of history in front of the block.
+    using HalfbandKernel = void (*) (const double* x, double* out, int numSamples, const double* taps, int numTaps);
+
+    // kernels for one I/O sample type and precision
+    struct KernelSet
+    {
+        // one kernel per Type x auto-gain, with the Type's constants and branches folded in
+        // [shaping][type][useAutoGain]
+        std::array<std::array<std::array<Kernel, 2>, kNumTypes>, kNumShapings> specialized;
+        // reads every coefficient and the auto-gain switch at runtime, kept for A/B comparison
+        // [shaping][saturatorType]
+        std::array<std::array<Kernel, 3>, kNumShapings> generic;
+        // Process at 0%: the chain reduces to the trims
+        Kernel gain;
+    };
+
+    // every kernel built for one instruction set
+    struct KernelTable
+    {
+        const KernelSet& get (bool doubleIO, Precision precision) const
+        {
+            return sets[doubleIO ? 1 : 0][static_cast<size_t> (precision)];
+        }
+
+        // [float I/O, double I/O][precision]
+        std::array<std::array<KernelSet, kNumPrecisions>, 2> sets;
+        // [precision][shaping][type]
+        std::array<std::array<std::array<BatchKernel, kNumTypes>, kNumShapings>, kNumPrecisions> batch;
+        HalfbandKernel halfband;
+    };
+
+    // Instruction sets the kernels are compiled for. SSE2 and NEON are the baselines of
+    // their architectures; AVX2 (with FMA) and AVX-512 are built into x86-64 binaries and
+    // only used when CPUID reports them.
+    enum class Isa
+    {
+        Scalar,
+        SSE2,
+        NEON,
+        AVX2,
+        AVX512
+    };
+
+    const char* getIsaName (Isa);
+    std::optional<Isa> getIsaFromName (std::string_view);
+
+    // whether this binary has kernels for it and the CPU/OS can run them
+    bool isIsaSupported (Isa);
+    // fastest supported
+    Isa getBestIsa();
+    // the TONIX_ISA environment variable (a name from getIsaName) if set and supported,
+    // otherwise getBestIsa()
+    Isa getPreferredIsa();
+
+    // isa must be supported
+    const KernelTable& getKernelTable (Isa);
+
+} // namespace tonix
@@ -0,0 +1,19 @@
+// x86-64 kernels for AVX-512F. Built with extra flags (see CMakeLists.txt) and
+// only called when CPUID reports support, see Kernels.cpp.
+#if defined(__x86_64__) || defined(_M_X64)
+
+#if ! defined(__AVX512F__)
+#error "this file needs to be compiled with AVX-512F enabled"
+#endif
+
+#include "KernelImpl.h"
+
+namespace tonix::inline TONIX_ISA_NAMESPACE
+{
+    const KernelTable& getKernelTable()
+    {
+        static constexpr auto table = kernels::makeKernelTable();
+        return table;
+    }
+} // namespace tonix::inline TONIX_ISA_NAMESPACE
+#endif
@@ -0,0 +1,13 @@
+// Portable kernels without explicit SIMD, the fallback when nothing else is supported.
+#define TONIX_SIMD_SCALAR 1
+
+#include "KernelImpl.h"
+
+namespace tonix::inline TONIX_ISA_NAMESPACE
+{
+    const KernelTable& getKernelTable()
+    {
+        static constexpr auto table = kernels::makeKernelTable();
+        return table;
+    }
+} // namespace tonix::inline TONIX_ISA_NAMESPACE
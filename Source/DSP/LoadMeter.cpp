@@ -0,0 +1,140 @@
+#include "LoadMeter.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+
+namespace tonix
+{
+    namespace
+    {
+        // the float's exponent and top mantissa bits, no log needed
+        int getBucket (double load)
+        {
+            constexpr auto lowest = 1.0 / (1 << -LoadMeter::kMinLoadLog2);
+            constexpr auto highest = static_cast<double> (1 << LoadMeter::kMaxLoadLog2);
+            const auto bits = std::bit_cast<uint32_t> (static_cast<float> (std::clamp (load, lowest, highest * 0.999)));
+            const auto exponent = static_cast<int> (bits >> 23) - 127;
+            const auto step = static_cast<int> ((bits >> 20) & (LoadMeter::kBucketsPerOctave - 1));
+            return (exponent - LoadMeter::kMinLoadLog2) * LoadMeter::kBucketsPerOctave + step;
+        }
+
+        double getBucketCentre (int bucket)
+        {
+            const auto exponent = bucket / LoadMeter::kBucketsPerOctave + LoadMeter::kMinLoadLog2;
+            const auto step = bucket % LoadMeter::kBucketsPerOctave;
+            return std::ldexp (1.0 + (step + 0.5) / LoadMeter::kBucketsPerOctave, exponent);
+        }
+
+        template <typename T>
+        void increment (std::atomic<T>& value, T amount)
+        {
+            // one writer, so no read-modify-write needed
+            value.store (value.load (std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+        }
+    } // namespace
+
+    void LoadMeter::record (double processingSeconds, double blockSeconds)
+    {
+        if (m_resetRequested.load (std::memory_order_relaxed) && m_resetRequested.exchange (false, std::memory_order_acquire))
+            clear();
+        if (blockSeconds <= 0.0)
+            return;
+
+        const auto load = processingSeconds / blockSeconds;
+        const auto blocks = m_blocks.load (std::memory_order_relaxed);
+        increment (m_buckets[static_cast<size_t> (getBucket (load))], 1u);
+        increment (m_sum, load);
+        if (load > m_max.load (std::memory_order_relaxed))
+            m_max.store (static_cast<float> (load), std::memory_order_relaxed);
+        m_ring[blocks % kRingSize].store (static_cast<float> (load), std::memory_order_relaxed);
+
+        if (load > 1.0)
+        {
+            const auto overruns = m_overruns.load (std::memory_order_relaxed);
+            const auto now = std::chrono::duration_cast<std::chrono::milliseconds> (std::chrono::system_clock::now().time_since_epoch());
+            m_overrunTimes[overruns % kNumOverruns].store (now.count(), std::memory_order_relaxed);
+            m_overrunLoads[overruns % kNumOverruns].store (static_cast<float> (load), std::memory_order_relaxed);
+            m_overruns.store (overruns + 1, std::memory_order_release);
+        }
+        m_blocks.store (blocks + 1, std::memory_order_release);
+    }
+
+    void LoadMeter::clear()
+    {
+        for (auto& bucket : m_buckets)
+            bucket.store (0, std::memory_order_relaxed);
+        m_sum.store (0.0, std::memory_order_relaxed);
+        m_max.store (0.0f, std::memory_order_relaxed);
+        m_overruns.store (0, std::memory_order_relaxed);
+        m_blocks.store (0, std::memory_order_release);
+    }
+
+    LoadMeter::Stats LoadMeter::getStats() const
+    {
+        Stats stats {};
+        stats.blocks = m_blocks.load (std::memory_order_acquire);
+        stats.overruns = m_overruns.load (std::memory_order_relaxed);
+        stats.max = m_max.load (std::memory_order_relaxed);
+        std::array<uint32_t, kNumBuckets> counts;
+        uint64_t total = 0;
+        for (size_t b = 0; b < counts.size(); ++b)
+            total += counts[b] = m_buckets[b].load (std::memory_order_relaxed);
+        if (total == 0)
+            return stats;
+        stats.mean = m_sum.load (std::memory_order_relaxed) / static_cast<double> (total);
+
+        const auto getPercentile = [&] (double fraction)
+        {
+            const auto target = static_cast<uint64_t> (fraction * static_cast<double> (total - 1));
+            uint64_t seen = 0;
+            for (int b = 0; b < kNumBuckets; ++b)
+            {
+                seen += counts[static_cast<size_t> (b)];
+                if (seen > target)
+                    return getBucketCentre (b);
+            }
+            return getBucketCentre (kNumBuckets - 1);
+        };
+        stats.p50 = getPercentile (0.5);
+        stats.p99 = getPercentile (0.99);
+        return stats;
+    }
+
+    LoadMeter::Stats LoadMeter::getRecentStats (int numBlocks) const
+    {
+        const auto blocks = m_blocks.load (std::memory_order_acquire);
+        const auto count = static_cast<size_t> (std::min<uint64_t> ({ static_cast<uint64_t> (std::max (0, numBlocks)), blocks, static_cast<uint64_t> (kRingSize) }));
+        Stats stats {};
+        stats.blocks = count;
+        if (count == 0)
+            return stats;
+
+        std::array<float, kRingSize> loads;
+        for (size_t i = 0; i < count; ++i)
+        {
+            loads[i] = m_ring[(blocks - 1 - i) % kRingSize].load (std::memory_order_relaxed);
+            stats.mean += loads[i];
+            stats.overruns += loads[i] > 1.0f;
+        }
+        stats.mean /= static_cast<double> (count);
+        std::sort (loads.begin(), loads.begin() + static_cast<ptrdiff_t> (count));
+        stats.p50 = loads[count / 2];
+        stats.p99 = loads[std::min (count - 1, count * 99 / 100)];
+        stats.max = loads[count - 1];
+        return stats;
+    }
+
+    int LoadMeter::getOverruns (Overrun* overruns) const
+    {
+        const auto total = m_overruns.load (std::memory_order_acquire);
+        const auto count = static_cast<int> (std::min<uint64_t> (total, kNumOverruns));
+        for (int i = 0; i < count; ++i)
+        {
+            const auto index = (total - 1 - static_cast<uint64_t> (i)) % kNumOverruns;
+            overruns[i] = { m_overrunTimes[index].load (std::memory_order_relaxed), m_overrunLoads[index].load (std::memory_order_relaxed) };
+        }
+        return count;
+    }
+} // namespace tonix
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace tonix
+{
+    // How long each block took against its deadline, the block's duration, for finding
+    // the instance that makes a session drop out. The audio thread records every block
+    // with a few relaxed stores; any other thread reads. Loads go into a histogram since
+    // the last reset, for the percentiles, and a ring of the latest blocks for meters.
+    // Blocks over their deadline also keep the wall-clock time they ended at, to line
+    // them up with the host's dropouts.
+    //
+    // Readers see each value whole but not the set at one instant, which is fine for
+    // statistics over thousands of blocks.
+    class LoadMeter
+    {
+    public:
+        // loads, as fractions of the deadline, resolved to 1/8 octave from 1/1024 to 16
+        static constexpr int kBucketsPerOctave = 8;
+        static constexpr int kMinLoadLog2 = -10, kMaxLoadLog2 = 4;
+        static constexpr int kNumBuckets = (kMaxLoadLog2 - kMinLoadLog2) * kBucketsPerOctave;
+        static constexpr int kRingSize = 1024;
+        static constexpr int kNumOverruns = 16;
+
+        struct Stats
+        {
+            uint64_t blocks;
+            // fractions of the deadline; the percentiles are bucket centres
+            double mean, p50, p99, max;
+            // blocks past their deadline
+            uint64_t overruns;
+        };
+
+        struct Overrun
+        {
+            // milliseconds since the Unix epoch
+            int64_t time;
+            float load;
+        };
+
+        // audio thread, every block
+        void record (double processingSeconds, double blockSeconds);
+        // any thread; the audio thread clears everything with its next block
+        void reset() { m_resetRequested.store (true, std::memory_order_relaxed); }
+
+        Stats getStats() const;
+        // of the newest numBlocks blocks, at most kRingSize
+        Stats getRecentStats (int numBlocks) const;
+        // the newest first, up to kNumOverruns; returns how many
+        int getOverruns (Overrun* overruns) const;
+
+    private:
+        void clear();
+
+        std::atomic<bool> m_resetRequested { false };
+        std::array<std::atomic<uint32_t>, kNumBuckets> m_buckets {};
+        std::atomic<uint64_t> m_blocks { 0 }, m_overruns { 0 };
+        std::atomic<double> m_sum { 0.0 };
+        std::atomic<float> m_max { 0.0f };
+
+        std::array<std::atomic<float>, kRingSize> m_ring {};
+        std::array<std::atomic<int64_t>, kNumOverruns> m_overrunTimes {};
+        std::array<std::atomic<float>, kNumOverruns> m_overrunLoads {};
+    };
+} // namespace tonix
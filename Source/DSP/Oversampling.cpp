@@ -0,0 +1,409 @@
+#include "Oversampling.h"
+
+#include "Kernels.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+#include <utility>
+
+namespace tonix
+{
+    namespace
+    {
+        constexpr double kPi = std::numbers::pi;
+
+        // passband kept flat by every stage, as a fraction of the base rate (20 kHz at 44.1)
+        constexpr double kPassband = 0.4535;
+        constexpr double kFirAttenuationDb = 110.0;
+        constexpr double kIirAttenuationDb = 100.0;
+
+        // Kaiser windowed half-band. Returns the first half of the even branch, scaled by
+        // two for the upsampler's zero stuffing; the odd branch is the centre tap only.
+        std::vector<double> designHalfbandFir (double transition, double attenuationDb)
+        {
+            const auto beta = 0.1102 * (attenuationDb - 8.7);
+            const auto order = (attenuationDb - 7.95) / (14.36 * transition);
+            // the centre tap must land on an odd index for the polyphase split
+            auto delay = static_cast<int> (std::ceil (order / 2.0));
+            delay += (delay % 2 == 0) ? 1 : 0;
+
+            const int numTaps = (delay + 1) / 2;
+            std::vector<double> taps (static_cast<size_t> (numTaps));
+            double sum = 0.0;
+            for (int k = 0; k < numTaps; ++k)
+            {
+                // offset of the k-th even tap from the centre, always odd
+                const double offset = delay - 2 * k;
+                const double r = offset / delay;
+                const double window = besselI0 (beta * std::sqrt (1.0 - r * r)) / besselI0 (beta);
+                taps[static_cast<size_t> (k)] = std::sin (kPi * offset / 2.0) / (kPi * offset) * window;
+                sum += taps[static_cast<size_t> (k)];
+            }
+            // unity gain at DC: the full even branch sums to one
+            for (auto& t : taps)
+                t /= 2.0 * sum;
+            return taps;
+        }
+
+        // Polyphase allpass half-band (elliptic prototype), after Valenzuela and
+        // Constantinides as popularised by de Soras' HIIR.
+        struct TransitionParams
+        {
+            double k, q;
+        };
+
+        TransitionParams getTransitionParams (double transition)
+        {
+            auto k = std::tan ((1.0 - transition * 2.0) * kPi / 4.0);
+            k *= k;
+            const auto kksqrt = std::pow (1.0 - k * k, 0.25);
+            const auto e = 0.5 * (1.0 - kksqrt) / (1.0 + kksqrt);
+            const auto e2 = e * e;
+            const auto e4 = e2 * e2;
+            return { k, e * (1.0 + e4 * (2.0 + e4 * (15.0 + 150.0 * e4))) };
+        }
+
+        double getIirCoefficient (int index, TransitionParams p, int order)
+        {
+            const int c = index + 1;
+
+            double num = 0.0, term = 0.0;
+            double sign = 1.0;
+            for (int i = 0; i == 0 || std::abs (term) > 1e-100; ++i, sign = -sign)
+            {
+                term = std::pow (p.q, i * (i + 1)) * std::sin ((i * 2 + 1) * c * kPi / order) * sign;
+                num += term;
+            }
+            num *= std::pow (p.q, 0.25);
+
+            double den = 0.0;
+            sign = -1.0;
+            for (int i = 1; i == 1 || std::abs (term) > 1e-100; ++i, sign = -sign)
+            {
+                term = std::pow (p.q, i * i) * std::cos (i * 2 * c * kPi / order) * sign;
+                den += term;
+            }
+            den += 0.5;
+
+            const auto ww = num / den;
+            const auto wwsq = ww * ww;
+            const auto x = std::sqrt ((1.0 - wwsq * p.k) * (1.0 - wwsq / p.k)) / (1.0 + wwsq);
+            return (1.0 - x) / (1.0 + x);
+        }
+
+        // coefficients alternate between the two branches
+        std::vector<double> designHalfbandIir (double transition, double attenuationDb)
+        {
+            const auto params = getTransitionParams (transition);
+            const auto attn = std::pow (10.0, -attenuationDb / 10.0);
+            const auto a = attn / (1.0 - attn);
+            auto order = static_cast<int> (std::ceil (std::log (a * a / 16.0) / std::log (params.q)));
+            order |= 1;
+            // an even count so both branches share a register
+            auto numCoefs = std::max (2, (order - 1) / 2);
+            numCoefs += numCoefs % 2;
+            order = numCoefs * 2 + 1;
+
+            std::vector<double> coefs (static_cast<size_t> (numCoefs));
+            for (int i = 0; i < numCoefs; ++i)
+                coefs[static_cast<size_t> (i)] = getIirCoefficient (i, params, order);
+            return coefs;
+        }
+
+        const HalfbandKernel& getHalfbandKernel()
+        {
+            static const auto kernel = getKernelTable (getPreferredIsa()).halfband;
+            return kernel;
+        }
+    } // namespace
+
+    double besselI0 (double x)
+    {
+        double sum = 1.0, term = 1.0;
+        for (int k = 1; term > sum * 1e-17; ++k)
+        {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+        }
+        return sum;
+    }
+
+    inline namespace TONIX_ISA_NAMESPACE
+    {
+        namespace
+        {
+            // both branches of the allpass pair advance together, one per lane
+            using Pair = simd::Vec<double, 2>;
+            constexpr size_t kMaxSections = 8;
+
+            // Up reads one input per pair of outputs, down two inputs per output. The
+            // section memory stays in registers for the whole block.
+            template <size_t Sections, bool Up>
+            void allpassBlock (const double* in, double* out, int numSamples, const double* coefs, double* x, double* y)
+            {
+                Pair a[Sections], xs[Sections], ys[Sections];
+                for (size_t k = 0; k < Sections; ++k)
+                {
+                    a[k] = Pair::load (coefs + 2 * k);
+                    xs[k] = Pair::load (x + 2 * k);
+                    ys[k] = Pair::load (y + 2 * k);
+                }
+
+                double pair[2];
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    Pair v;
+                    if constexpr (Up)
+                    {
+                        v = Pair (in[i]);
+                    }
+                    else
+                    {
+                        // the newer sample runs through the first branch
+                        pair[0] = in[2 * i + 1];
+                        pair[1] = in[2 * i];
+                        v = Pair::load (pair);
+                    }
+
+                    for (size_t k = 0; k < Sections; ++k)
+                    {
+                        const auto o = mulAdd (v - ys[k], a[k], xs[k]);
+                        xs[k] = v;
+                        ys[k] = o;
+                        v = o;
+                    }
+
+                    if constexpr (Up)
+                    {
+                        v.store (out + 2 * i);
+                    }
+                    else
+                    {
+                        v.store (pair);
+                        out[i] = 0.5 * (pair[0] + pair[1]);
+                    }
+                }
+
+                for (size_t k = 0; k < Sections; ++k)
+                {
+                    xs[k].store (x + 2 * k);
+                    ys[k].store (y + 2 * k);
+                }
+            }
+
+            template <bool Up, size_t... S>
+            void allpass (size_t numSections, const double* in, double* out, int numSamples, const double* coefs, double* x, double* y, std::index_sequence<S...>)
+            {
+                // one instantiation per section count
+                ((numSections == S + 1 ? allpassBlock<S + 1, Up> (in, out, numSamples, coefs, x, y) : void()), ...);
+            }
+        } // namespace
+    } // namespace TONIX_ISA_NAMESPACE
+
+    void HalfbandStage::prepare (int numChannels, int maxLowRateSamples, OversamplingPhase phase, double transition, double attenuationDb)
+    {
+        m_phase = phase;
+        m_maxSamples = maxLowRateSamples;
+        m_channels.assign (static_cast<size_t> (numChannels), {});
+        m_taps.clear();
+        m_coefs.clear();
+
+        if (phase == OversamplingPhase::Linear)
+        {
+            m_taps = designHalfbandFir (transition, attenuationDb);
+            m_delay = 2 * static_cast<int> (m_taps.size()) - 1;
+            // up and down each delay by m_delay at the high rate
+            m_latency = m_delay;
+            for (auto& c : m_channels)
+            {
+                c.upInput.resize (static_cast<size_t> (m_delay + maxLowRateSamples));
+                c.downEven.resize (static_cast<size_t> (m_delay + maxLowRateSamples));
+                c.downOdd.resize (static_cast<size_t> ((m_delay + 1) / 2 + maxLowRateSamples));
+            }
+        }
+        else
+        {
+            m_coefs = designHalfbandIir (transition, attenuationDb);
+            assert (m_coefs.size() <= 2 * kMaxSections);
+            // group delay at DC: each section (a + z^-1) / (1 + a z^-1) delays its branch
+            // by (1 - a) / (1 + a) low-rate samples, and up and down each see half of the
+            // branches' sum at the high rate
+            m_latency = 0.0;
+            for (const auto a : m_coefs)
+                m_latency += (1.0 - a) / (1.0 + a);
+            for (auto& c : m_channels)
+                for (auto* s : { &c.upX, &c.upY, &c.downX, &c.downY })
+                    s->resize (m_coefs.size());
+        }
+        reset();
+    }
+
+    void HalfbandStage::reset()
+    {
+        for (auto& c : m_channels)
+            for (auto* s : { &c.upInput, &c.downEven, &c.downOdd, &c.upX, &c.upY, &c.downX, &c.downY })
+                std::fill (s->begin(), s->end(), 0.0);
+    }
+
+    void HalfbandStage::upsample (int channel, const double* in, double* out, int numSamples)
+    {
+        assert (numSamples <= m_maxSamples);
+        auto& c = m_channels[static_cast<size_t> (channel)];
+
+        if (m_phase == OversamplingPhase::Minimum)
+        {
+            allpass<true> (m_coefs.size() / 2, in, out, numSamples, m_coefs.data(), c.upX.data(), c.upY.data(), std::make_index_sequence<kMaxSections> {});
+            return;
+        }
+
+        // the even outputs are the filtered branch, the odd ones a delayed copy of the input
+        auto* x = c.upInput.data();
+        std::copy (in, in + numSamples, x + m_delay);
+        double even[kChunkSize];
+        const int half = (m_delay + 1) / 2;
+        for (int offset = 0; offset < numSamples; offset += kChunkSize)
+        {
+            const auto n = std::min (kChunkSize, numSamples - offset);
+            getHalfbandKernel() (x + offset, even, n, m_taps.data(), static_cast<int> (m_taps.size()));
+            for (int i = 0; i < n; ++i)
+            {
+                out[2 * (offset + i)] = even[i];
+                out[2 * (offset + i) + 1] = x[offset + i + half];
+            }
+        }
+        std::memmove (x, x + numSamples, static_cast<size_t> (m_delay) * sizeof (double));
+    }
+
+    void HalfbandStage::downsample (int channel, const double* in, double* out, int numSamples)
+    {
+        assert (numSamples <= m_maxSamples);
+        auto& c = m_channels[static_cast<size_t> (channel)];
+
+        if (m_phase == OversamplingPhase::Minimum)
+        {
+            allpass<false> (m_coefs.size() / 2, in, out, numSamples, m_coefs.data(), c.downX.data(), c.downY.data(), std::make_index_sequence<kMaxSections> {});
+            return;
+        }
+
+        const int half = (m_delay + 1) / 2;
+        auto* even = c.downEven.data();
+        auto* odd = c.downOdd.data();
+        for (int i = 0; i < numSamples; ++i)
+        {
+            even[m_delay + i] = in[2 * i];
+            odd[half + i] = in[2 * i + 1];
+        }
+        getHalfbandKernel() (even, out, numSamples, m_taps.data(), static_cast<int> (m_taps.size()));
+        for (int i = 0; i < numSamples; ++i)
+            out[i] = 0.5 * (out[i] + odd[i]);
+        std::memmove (even, even + numSamples, static_cast<size_t> (m_delay) * sizeof (double));
+        std::memmove (odd, odd + numSamples, static_cast<size_t> (half) * sizeof (double));
+    }
+
+    double prepareHalfbandCascade (std::vector<HalfbandStage>& stages, int numChannels, int maxBlockSize, int numStages, OversamplingPhase phase, double passband)
+    {
+        stages.assign (static_cast<size_t> (numStages), {});
+
+        // Every stage keeps the base band flat, so later stages get wide transitions and
+        // cost little. In units of the stage's high rate.
+        double latency = 0.0;
+        for (int s = 0; s < numStages; ++s)
+        {
+            const auto transition = 0.5 - passband / (1 << s);
+            auto& stage = stages[static_cast<size_t> (s)];
+            stage.prepare (numChannels, maxBlockSize << s, phase, transition, phase == OversamplingPhase::Linear ? kFirAttenuationDb : kIirAttenuationDb);
+            latency += stage.getLatency() / (1 << s);
+        }
+        return latency;
+    }
+
+    void Oversampler::prepare (int numChannels, int maxBlockSize, int factorLog2, OversamplingPhase phase)
+    {
+        factorLog2 = std::clamp (factorLog2, 0, kMaxFactorLog2);
+        m_phase = phase;
+        auto latency = prepareHalfbandCascade (m_stages, numChannels, maxBlockSize, factorLog2, phase, kPassband);
+        m_buffers.assign (static_cast<size_t> (factorLog2), {});
+        for (int s = 0; s < factorLog2; ++s)
+            m_buffers[static_cast<size_t> (s)].assign (static_cast<size_t> (numChannels), std::vector<double> (static_cast<size_t> (maxBlockSize << (s + 1))));
+
+        // pad linear phase to whole base-rate samples at the top rate so the host can
+        // compensate exactly
+        const int factor = 1 << factorLog2;
+        m_padding = 0;
+        if (phase == OversamplingPhase::Linear && factorLog2 > 0)
+        {
+            const auto topRateLatency = static_cast<int> (std::lround (latency * factor));
+            m_padding = (factor - topRateLatency % factor) % factor;
+            latency += static_cast<double> (m_padding) / factor;
+        }
+        m_latency = latency;
+        m_paddingLines.assign (m_padding > 0 ? static_cast<size_t> (numChannels) : 0, std::vector<double> (static_cast<size_t> (m_padding + (maxBlockSize << factorLog2))));
+
+        m_scratch.assign (static_cast<size_t> (maxBlockSize), 0.0);
+        m_top.assign (static_cast<size_t> (numChannels), nullptr);
+        if (factorLog2 > 0)
+            for (size_t ch = 0; ch < m_top.size(); ++ch)
+                m_top[ch] = m_buffers.back()[ch].data();
+        reset();
+    }
+
+    void Oversampler::reset()
+    {
+        for (auto& stage : m_stages)
+            stage.reset();
+        for (auto& line : m_paddingLines)
+            std::fill (line.begin(), line.end(), 0.0);
+    }
+
+    template <typename T>
+    double* const* Oversampler::upsample (const T* const* channels, int numChannels, int startSample, int numSamples)
+    {
+        assert (! m_stages.empty());
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const auto c = static_cast<size_t> (ch);
+            std::copy (channels[ch] + startSample, channels[ch] + startSample + numSamples, m_scratch.begin());
+            m_stages[0].upsample (ch, m_scratch.data(), m_buffers[0][c].data(), numSamples);
+
+            int n = numSamples * 2;
+            for (size_t s = 1; s < m_stages.size(); ++s, n *= 2)
+                m_stages[s].upsample (ch, m_buffers[s - 1][c].data(), m_buffers[s][c].data(), n);
+        }
+        return m_top.data();
+    }
+
+    template <typename T>
+    void Oversampler::downsample (T* const* channels, int numChannels, int startSample, int numSamples)
+    {
+        const auto numStages = m_stages.size();
+        const int topSamples = numSamples << numStages;
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const auto c = static_cast<size_t> (ch);
+            const double* top = m_top[c];
+            if (m_padding > 0)
+            {
+                auto& line = m_paddingLines[c];
+                std::copy (top, top + topSamples, line.begin() + m_padding);
+                std::copy (line.begin(), line.begin() + topSamples, m_top[c]);
+                std::copy (line.begin() + topSamples, line.begin() + topSamples + m_padding, line.begin());
+            }
+
+            // each stage halves into the buffer below it
+            int n = topSamples / 2;
+            for (size_t s = numStages - 1; s > 0; --s, n /= 2)
+                m_stages[s].downsample (ch, m_buffers[s][c].data(), m_buffers[s - 1][c].data(), n);
+            m_stages[0].downsample (ch, m_buffers[0][c].data(), m_scratch.data(), numSamples);
+            std::copy (m_scratch.begin(), m_scratch.begin() + numSamples, channels[ch] + startSample);
+        }
+    }
+
+    template double* const* Oversampler::upsample (const float* const*, int, int, int);
+    template double* const* Oversampler::upsample (const double* const*, int, int, int);
+    template void Oversampler::downsample (float* const*, int, int, int);
+    template void Oversampler::downsample (double* const*, int, int, int);
+} // namespace tonix
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <vector>
+
+namespace tonix
+{
+    enum class OversamplingPhase
+    {
+        // symmetric FIR half-bands, constant delay
+        Linear,
+        // polyphase allpass (IIR) half-bands, lower latency and CPU, phase shift near Nyquist
+        Minimum
+    };
+
+    // One 2x stage. Both variants are polyphase: only the non-zero branches of the
+    // half-band are computed, at the low rate.
+    class HalfbandStage
+    {
+    public:
+        // transition in units of the high rate, centred on a quarter of it
+        void prepare (int numChannels, int maxLowRateSamples, OversamplingPhase, double transition, double attenuationDb);
+        void reset();
+
+        // up and down together, in low-rate samples; fractional for minimum phase (DC delay)
+        double getLatency() const { return m_latency; }
+
+        // out holds 2 * numSamples
+        void upsample (int channel, const double* in, double* out, int numSamples);
+        // in holds 2 * numSamples
+        void downsample (int channel, const double* in, double* out, int numSamples);
+
+    private:
+        OversamplingPhase m_phase { OversamplingPhase::Linear };
+        double m_latency { 0.0 };
+
+        // FIR: first half of the symmetric even branch; the odd branch is a pure delay
+        std::vector<double> m_taps;
+        int m_delay { 0 };
+
+        // IIR: allpass coefficients, even/odd interleaved so each pair runs as one register
+        std::vector<double> m_coefs;
+
+        struct ChannelState
+        {
+            // FIR input with the filter's history in front
+            std::vector<double> upInput, downEven, downOdd;
+            // IIR allpass memory, interleaved like m_coefs
+            std::vector<double> upX, upY, downX, downY;
+        };
+        std::vector<ChannelState> m_channels;
+        int m_maxSamples { 0 };
+    };
+
+    // Prepares numStages 2x stages that all keep the band up to passband (a fraction of
+    // the base rate) flat; maxBlockSize is at the base rate. Returns their round trip
+    // latency in base-rate samples.
+    double prepareHalfbandCascade (std::vector<HalfbandStage>&, int numChannels, int maxBlockSize, int numStages, OversamplingPhase, double passband);
+
+    // Zeroth-order modified Bessel function of the first kind, for Kaiser windows.
+    double besselI0 (double x);
+
+    // Cascade of 2x stages, 2^factorLog2 overall.
+    class Oversampler
+    {
+    public:
+        static constexpr int kMaxFactorLog2 = 3;
+
+        // allocates; maxBlockSize is at the base rate
+        void prepare (int numChannels, int maxBlockSize, int factorLog2, OversamplingPhase);
+        void reset();
+
+        int getFactorLog2() const { return static_cast<int> (m_stages.size()); }
+        int getFactor() const { return 1 << getFactorLog2(); }
+        OversamplingPhase getPhase() const { return m_phase; }
+
+        // round trip in base-rate samples. Linear phase is padded to a whole number of
+        // samples; minimum phase reports its delay at DC.
+        double getLatency() const { return m_latency; }
+
+        // reads numSamples <= maxBlockSize from startSample on; the result has
+        // numSamples * getFactor() per channel and can be processed in place before
+        // downsample() writes the same range back
+        template <typename T>
+        double* const* upsample (const T* const* channels, int numChannels, int startSample, int numSamples);
+        template <typename T>
+        void downsample (T* const* channels, int numChannels, int startSample, int numSamples);
+
+    private:
+        OversamplingPhase m_phase { OversamplingPhase::Linear };
+        std::vector<HalfbandStage> m_stages;
+        double m_latency { 0.0 };
+
+        // pads the linear-phase latency to whole base-rate samples, at the top rate
+        int m_padding { 0 };
+        std::vector<std::vector<double>> m_paddingLines;
+
+        // per stage output, [stage][channel]
+        std::vector<std::vector<std::vector<double>>> m_buffers;
+        std::vector<double*> m_top;
+        // base-rate samples in the stages' format
+        std::vector<double> m_scratch;
+    };
+} // namespace tonix
@@ -0,0 +1,151 @@
+#include "ParallelEngine.h"
+#include "Trace.h"
+
+#include <algorithm>
+
+namespace tonix
+{
+    void ParallelEngine::prepare (int numChannels, double sampleRate, int maxBlockSize, int oversamplingLog2, OversamplingPhase phase, InternalRate internalRate, bool fallbacks, int numSlices, TaskRunner* runner)
+    {
+        numSlices = std::clamp (numSlices, 1, std::max (1, numChannels));
+        // settings survive like Engine's: the new slices take them from the old first one
+        const auto& settings = getEngine();
+        std::vector<Slice> slices (static_cast<size_t> (numSlices));
+        for (int s = 0; s < numSlices; ++s)
+        {
+            auto& slice = slices[static_cast<size_t> (s)];
+            // the first numChannels % numSlices slices take one more
+            slice.firstChannel = s * (numChannels / numSlices) + std::min (s, numChannels % numSlices);
+            slice.numChannels = numChannels / numSlices + (s < numChannels % numSlices ? 1 : 0);
+            slice.engine = settings;
+            slice.engine.prepare (slice.numChannels, sampleRate, maxBlockSize, oversamplingLog2, phase, internalRate, fallbacks);
+        }
+        m_slices = std::move (slices);
+        m_runner = numSlices > 1 ? runner : nullptr;
+    }
+
+    int ParallelEngine::getNumSlices (int numChannels, const WorkerPool* pool)
+    {
+        if (pool == nullptr)
+            return 1;
+        return std::max (1, std::min (numChannels / kMinChannelsPerSlice, pool->getNumThreads() + 1));
+    }
+
+    void ParallelEngine::reset()
+    {
+        forEachEngine ([] (Engine& e)
+                       { e.reset(); });
+    }
+
+    void ParallelEngine::setMode (Type type, Brightness brightness)
+    {
+        forEachEngine ([=] (Engine& e)
+                       { e.setMode (type, brightness); });
+    }
+
+    void ParallelEngine::setProcessing (double amount)
+    {
+        forEachEngine ([=] (Engine& e)
+                       { e.setProcessing (amount); });
+    }
+
+    void ParallelEngine::setAutoGain (bool shouldUseAutoGain)
+    {
+        forEachEngine ([=] (Engine& e)
+                       { e.setAutoGain (shouldUseAutoGain); });
+    }
+
+    void ParallelEngine::setPrecision (Precision precision)
+    {
+        forEachEngine ([=] (Engine& e)
+                       { e.setPrecision (precision); });
+    }
+
+    void ParallelEngine::setAntialiasing (Antialiasing antialiasing)
+    {
+        forEachEngine ([=] (Engine& e)
+                       { e.setAntialiasing (antialiasing); });
+    }
+
+    void ParallelEngine::setSaturatorTier (SaturatorTier tier)
+    {
+        forEachEngine ([=] (Engine& e)
+                       { e.setSaturatorTier (tier); });
+    }
+
+    void ParallelEngine::setBypassed (bool shouldBeBypassed)
+    {
+        forEachEngine ([=] (Engine& e)
+                       { e.setBypassed (shouldBeBypassed); });
+    }
+
+    void ParallelEngine::setQualityLevel (int level)
+    {
+        forEachEngine ([=] (Engine& e)
+                       { e.setQualityLevel (level); });
+    }
+
+    bool ParallelEngine::isChangingQuality() const
+    {
+        return std::any_of (m_slices.begin(), m_slices.end(), [] (const Slice& s)
+                            { return s.engine.isChangingQuality(); });
+    }
+
+    bool ParallelEngine::isAsleep() const
+    {
+        return std::all_of (m_slices.begin(), m_slices.end(), [] (const Slice& s)
+                            { return s.engine.isAsleep(); });
+    }
+
+    void ParallelEngine::process (float* const* channels, int numChannels, int numSamples, float inputGain, float outputGain)
+    {
+        processSlices (channels, numChannels, numSamples, inputGain, outputGain);
+    }
+
+    void ParallelEngine::process (double* const* channels, int numChannels, int numSamples, float inputGain, float outputGain)
+    {
+        processSlices (channels, numChannels, numSamples, inputGain, outputGain);
+    }
+
+    template <typename T>
+    void ParallelEngine::processSlices (T* const* channels, int numChannels, int numSamples, float inputGain, float outputGain)
+    {
+        if constexpr (std::is_same_v<T, float>)
+            m_floatChannels = channels;
+        else
+            m_doubleChannels = channels;
+        m_numChannels = numChannels;
+        m_numSamples = numSamples;
+        m_inputGain = inputGain;
+        m_outputGain = outputGain;
+
+        const auto numSlices = static_cast<int> (m_slices.size());
+        if (m_runner != nullptr && numSamples >= kMinParallelSamples)
+        {
+            m_runner->run (&processSlice<T>, this, numSlices);
+            return;
+        }
+        for (int s = 0; s < numSlices; ++s)
+            processSlice<T> (this, s);
+    }
+
+    template <typename T>
+    void ParallelEngine::processSlice (void* context, int index)
+    {
+        auto& self = *static_cast<ParallelEngine*> (context);
+        auto& slice = self.m_slices[static_cast<size_t> (index)];
+        // hosts may hand over fewer channels than prepared
+        const auto numChannels = std::min (slice.numChannels, self.m_numChannels - slice.firstChannel);
+        if (numChannels <= 0)
+            return;
+        TONIX_TRACE_SCOPE_VALUE ("slice", index);
+        T* const* channels = [&self]
+        {
+            if constexpr (std::is_same_v<T, float>)
+                return self.m_floatChannels;
+            else
+                return self.m_doubleChannels;
+        }();
+        slice.engine.process (channels + slice.firstChannel, numChannels, self.m_numSamples, self.m_inputGain, self.m_outputGain);
+    }
+} // namespace tonix
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Engine.h"
+#include "WorkerPool.h"
+
+#include <vector>
+
+namespace tonix
+{
+    // Engines for contiguous slices of a wide layout's channels, run in parallel by a
+    // TaskRunner. Channels are independent all the way through the chain, so the output
+    // matches a single Engine's, except that each slice goes to sleep on its own. Every
+    // setting goes to all slices; the getters report the first one's, which are the same.
+    class ParallelEngine
+    {
+    public:
+        // blocks shorter than this stay on the caller's thread, where handing them over
+        // would cost more than it saves
+        static constexpr int kMinParallelSamples = 32;
+        // fewer per slice and the handover costs more than the channels do
+        static constexpr int kMinChannelsPerSlice = 4;
+
+        // a slice for the caller and each of the pool's threads, with at least
+        // kMinChannelsPerSlice channels each; 1 without a pool
+        static int getNumSlices (int numChannels, const WorkerPool* pool);
+
+        // allocates, call before processing; numSlices is clamped to the channel count.
+        // A single slice or no runner processes on the caller's thread.
+        void prepare (int numChannels, double sampleRate, int maxBlockSize, int oversamplingLog2 = 0, OversamplingPhase = OversamplingPhase::Linear, InternalRate = InternalRate::Host, bool fallbacks = false, int numSlices = 1, TaskRunner* = nullptr);
+        void reset();
+
+        void setMode (Type, Brightness);
+        void setProcessing (double amount);
+        void setAutoGain (bool shouldUseAutoGain);
+        void setPrecision (Precision);
+        void setAntialiasing (Antialiasing);
+        void setSaturatorTier (SaturatorTier);
+        void setBypassed (bool shouldBeBypassed);
+        void setQualityLevel (int level);
+
+        int getNumSlices() const { return static_cast<int> (m_slices.size()); }
+        const Engine& getEngine (int slice = 0) const { return m_slices[static_cast<size_t> (slice)].engine; }
+
+        int getOversamplingLog2() const { return getEngine().getOversamplingLog2(); }
+        OversamplingPhase getOversamplingPhase() const { return getEngine().getOversamplingPhase(); }
+        InternalRate getInternalRate() const { return getEngine().getInternalRate(); }
+        double getLatency() const { return getEngine().getLatency(); }
+        double getTailLength() const { return getEngine().getTailLength(); }
+        bool isBypassed() const { return getEngine().isBypassed(); }
+        int getNumQualityLevels() const { return getEngine().getNumQualityLevels(); }
+        Engine::Quality getQuality (int level) const { return getEngine().getQuality (level); }
+        int getQualityLevel() const { return getEngine().getQualityLevel(); }
+        // any slice
+        bool isChangingQuality() const;
+        // every slice
+        bool isAsleep() const;
+
+        // like Engine's
+        void process (float* const* channels, int numChannels, int numSamples, float inputGain, float outputGain);
+        void process (double* const* channels, int numChannels, int numSamples, float inputGain, float outputGain);
+
+    private:
+        // on its own cache lines, the threads write to nothing else
+        struct alignas (kCacheLineSize) Slice
+        {
+            Engine engine;
+            int firstChannel { 0 }, numChannels { 0 };
+        };
+
+        template <typename T>
+        void processSlices (T* const* channels, int numChannels, int numSamples, float inputGain, float outputGain);
+        template <typename T>
+        static void processSlice (void* context, int index);
+
+        template <typename F>
+        void forEachEngine (F&& f)
+        {
+            for (auto& slice : m_slices)
+                f (slice.engine);
+        }
+
+        std::vector<Slice> m_slices = std::vector<Slice> (1);
+        TaskRunner* m_runner { nullptr };
+
+        // the block being processed, for the tasks
+        float* const* m_floatChannels { nullptr };
+        double* const* m_doubleChannels { nullptr };
+        int m_numChannels { 0 }, m_numSamples { 0 };
+        float m_inputGain { 1.0f }, m_outputGain { 1.0f };
+    };
+} // namespace tonix
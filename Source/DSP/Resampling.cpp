@@ -0,0 +1,378 @@
+#include "Resampling.h"
+
+#include "Simd.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numbers>
+#include <numeric>
+
+namespace tonix
+{
+    namespace
+    {
+        constexpr double kPi = std::numbers::pi;
+
+        // The core only has to keep the audible band, which leaves the filters at 48 kHz
+        // and up much wider transitions than the oversampler's 0.4535 of the base rate.
+        double getPassband (double sampleRate)
+        {
+            return std::min (0.4535, 20000.0 / sampleRate);
+        }
+
+        constexpr double kAttenuationDb = 100.0;
+        // linear interpolation between 512 phases stays below the stopband
+        constexpr int kPhases = 512;
+        // 441 for 32 <-> 44.1 kHz
+        constexpr double kMaxExactPhases = 1024;
+
+        bool isPowerOfTwoAbove (double ratio, int& log2)
+        {
+            int exponent = 0;
+            if (ratio <= 1.0 || std::frexp (ratio, &exponent) != 0.5)
+                return false;
+            log2 = exponent - 1;
+            return true;
+        }
+    } // namespace
+
+    inline namespace TONIX_ISA_NAMESPACE
+    {
+        namespace
+        {
+            using Pair = simd::Vec<double, 2>;
+
+            double sum (Pair v)
+            {
+                double lanes[2];
+                v.store (lanes);
+                return lanes[0] + lanes[1];
+            }
+
+            // x starts at the first tap
+            double dot (const double* x, const double* row, int rowSize)
+            {
+                Pair a (0.0);
+                for (int j = 0; j < rowSize; j += 2)
+                    a = mulAdd (Pair::load (x + j), Pair::load (row + j), a);
+                return sum (a);
+            }
+
+            // between row and the next, both dotted in one pass
+            double interpolate (const double* x, const double* row, int rowSize, double fraction)
+            {
+                Pair a (0.0), b (0.0);
+                for (int j = 0; j < rowSize; j += 2)
+                {
+                    const auto v = Pair::load (x + j);
+                    a = mulAdd (v, Pair::load (row + j), a);
+                    b = mulAdd (v, Pair::load (row + rowSize + j), b);
+                }
+                return sum (a + (b - a) * fraction);
+            }
+        } // namespace
+    } // namespace TONIX_ISA_NAMESPACE
+
+    double getInternalSampleRate (double hostRate, InternalRate rate)
+    {
+        if (rate == InternalRate::Host || hostRate <= 0.0)
+            return hostRate;
+
+        const auto scale = rate == InternalRate::Double ? 2.0 : 1.0;
+        const double family[] = { 44100.0 * scale, 48000.0 * scale };
+        for (const auto r : family)
+        {
+            int log2 = 0;
+            if (hostRate == r || isPowerOfTwoAbove (hostRate / r, log2))
+                return r;
+        }
+        return std::abs (std::log (hostRate / family[0])) <= std::abs (std::log (hostRate / family[1])) ? family[0] : family[1];
+    }
+
+    void SincResampler::prepare (int numChannels, double inputRate, double outputRate, double passband, int maxInputSamples, double offset)
+    {
+        m_offset = offset;
+
+        // exact phases when the rates are whole and the table stays small
+        const auto isWhole = [] (double rate) { return rate == std::floor (rate) && rate < 1e9; };
+        const auto divisor = isWhole (inputRate) && isWhole (outputRate) ? std::gcd (static_cast<long long> (inputRate), static_cast<long long> (outputRate)) : 0;
+        m_interpolate = divisor == 0 || outputRate / static_cast<double> (divisor) > kMaxExactPhases;
+        m_numPhases = m_interpolate ? kPhases : static_cast<int> (outputRate / static_cast<double> (divisor));
+        const auto step = inputRate / outputRate * m_numPhases;
+        const auto numSteps = m_interpolate ? step : std::round (step);
+        m_stepSamples = static_cast<int> (numSteps) / m_numPhases;
+        m_stepPhase = numSteps - static_cast<double> (m_stepSamples) * m_numPhases;
+
+        // the band edge follows the lower rate, in units of the input rate
+        const auto scale = std::min (1.0, outputRate / inputRate);
+        const auto cutoff = 0.5 * scale;
+        const auto transition = (1.0 - 2.0 * passband) * scale;
+        const auto order = (kAttenuationDb - 7.95) / (14.36 * transition);
+        const auto beta = 0.1102 * (kAttenuationDb - 8.7);
+        m_half = static_cast<int> (std::ceil (order / 2.0));
+        m_rowSize = 2 * m_half;
+
+        // row p holds the taps for an output p / m_numPhases past the input sample at
+        // m_half - 1 in the row
+        const auto numRows = m_numPhases + (m_interpolate ? 1 : 0);
+        m_table.assign (static_cast<size_t> (numRows * m_rowSize), 0.0);
+        for (int p = 0; p < numRows; ++p)
+        {
+            auto* row = m_table.data() + p * m_rowSize;
+            double total = 0.0;
+            for (int j = 0; j < m_rowSize; ++j)
+            {
+                const auto t = (j - m_half + 1) - static_cast<double> (p) / m_numPhases;
+                const auto r = t / m_half;
+                const auto window = besselI0 (beta * std::sqrt (std::max (0.0, 1.0 - r * r))) / besselI0 (beta);
+                const auto x = 2.0 * cutoff * t;
+                row[j] = 2.0 * cutoff * (x == 0.0 ? 1.0 : std::sin (kPi * x) / (kPi * x)) * window;
+                total += row[j];
+            }
+            // unity gain at DC whatever the phase
+            for (int j = 0; j < m_rowSize; ++j)
+                row[j] /= total;
+        }
+
+        m_history.assign (static_cast<size_t> (numChannels), std::vector<double> (static_cast<size_t> (2 * m_half + maxInputSamples)));
+        reset();
+    }
+
+    void SincResampler::reset()
+    {
+        for (auto& h : m_history)
+            std::fill (h.begin(), h.end(), 0.0);
+        // silence in front so the first output has its context
+        m_filled = 2 * m_half;
+        const auto whole = std::floor (m_offset);
+        m_index = m_half + static_cast<int> (whole);
+        m_phase = (m_offset - whole) * m_numPhases;
+        if (! m_interpolate)
+            m_phase = std::round (m_phase);
+    }
+
+    int SincResampler::getMaxOutputSamples (int numInputSamples) const
+    {
+        const auto step = m_stepSamples + m_stepPhase / m_numPhases;
+        return static_cast<int> (std::ceil (numInputSamples / step)) + 1;
+    }
+
+    int SincResampler::process (const double* const* in, int numChannels, int numSamples, double* const* out)
+    {
+        const auto advance = [this] (int& index, double& phase)
+        {
+            index += m_stepSamples;
+            phase += m_stepPhase;
+            if (phase >= m_numPhases)
+            {
+                phase -= m_numPhases;
+                ++index;
+            }
+        };
+
+        // an output needs m_half inputs after its position
+        const auto limit = m_filled + numSamples - m_half;
+        int count = 0;
+        auto endIndex = m_index;
+        auto endPhase = m_phase;
+        for (; endIndex < limit; advance (endIndex, endPhase))
+            ++count;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto& h = m_history[static_cast<size_t> (ch)];
+            std::copy (in[ch], in[ch] + numSamples, h.begin() + m_filled);
+
+            auto index = m_index;
+            auto phase = m_phase;
+            for (int i = 0; i < count; ++i, advance (index, phase))
+            {
+                const auto* x = h.data() + index - m_half + 1;
+                if (m_interpolate)
+                {
+                    const auto p = static_cast<int> (phase);
+                    out[ch][i] = interpolate (x, m_table.data() + p * m_rowSize, m_rowSize, phase - p);
+                }
+                else
+                {
+                    out[ch][i] = dot (x, m_table.data() + static_cast<int> (phase) * m_rowSize, m_rowSize);
+                }
+            }
+        }
+
+        // keep the context of the next output
+        const auto shift = endIndex - m_half + 1;
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto& h = m_history[static_cast<size_t> (ch)];
+            std::copy (h.begin() + shift, h.begin() + m_filled + numSamples, h.begin());
+        }
+        m_filled += numSamples - shift;
+        m_index = endIndex - shift;
+        m_phase = endPhase;
+        return count;
+    }
+
+    int RateConverter::getMaxInternalSamples (double hostRate, double internalRate, int maxBlockSize)
+    {
+        if (hostRate <= 0.0 || internalRate <= 0.0 || hostRate == internalRate)
+            return maxBlockSize;
+        // a sample either way for the partial steps before and after the block
+        return static_cast<int> (std::ceil (maxBlockSize * internalRate / hostRate)) + 2;
+    }
+
+    void RateConverter::prepare (int numChannels, double hostRate, double internalRate, int maxBlockSize, double coreLatency)
+    {
+        const auto channels = static_cast<size_t> (numChannels);
+        m_mode = Mode::Off;
+        m_latency = 0.0;
+        m_prime = 0;
+        m_stages.clear();
+        m_buffers.clear();
+        m_input.clear();
+        m_output.clear();
+        m_internal.assign (channels, nullptr);
+        m_inputPointers.assign (channels, nullptr);
+        m_outputPointers.assign (channels, nullptr);
+        if (hostRate <= 0.0 || internalRate <= 0.0 || hostRate == internalRate)
+            return;
+
+        const auto ratio = hostRate / internalRate;
+        const auto maxInternalSamples = getMaxInternalSamples (hostRate, internalRate, maxBlockSize);
+        int numStages = 0;
+        int outputSize = 0;
+        if (isPowerOfTwoAbove (ratio, numStages))
+        {
+            m_mode = Mode::Halfband;
+            const int factor = 1 << numStages;
+            // a partial group of host samples waits for the next block
+            m_prime = factor - 1;
+            // linear phase cascades are whole samples at the top rate
+            m_latency = std::round (prepareHalfbandCascade (m_stages, numChannels, maxInternalSamples, numStages, OversamplingPhase::Linear, getPassband (internalRate)) * factor) + m_prime;
+            m_buffers.resize (static_cast<size_t> (numStages));
+            for (int s = 0; s < numStages; ++s)
+                m_buffers[static_cast<size_t> (s)].assign (channels, std::vector<double> (static_cast<size_t> (maxInternalSamples << s)));
+            m_input.assign (channels, std::vector<double> (static_cast<size_t> (maxBlockSize + factor)));
+            outputSize = m_prime + (maxInternalSamples << numStages);
+        }
+        else
+        {
+            m_mode = Mode::Sinc;
+            const auto passband = getPassband (std::min (hostRate, internalRate));
+            m_down.prepare (numChannels, hostRate, internalRate, passband, maxBlockSize);
+            // advance the way back by the fraction of a host sample the total delay has
+            m_up.prepare (numChannels, internalRate, hostRate, passband, maxInternalSamples);
+            const auto delay = (m_up.getDelay() + coreLatency) * ratio;
+            m_up.prepare (numChannels, internalRate, hostRate, passband, maxInternalSamples, (delay - std::floor (delay)) / ratio);
+            // both sides round their output counts, a host sample either way
+            m_prime = 2;
+            m_latency = m_down.getDelay() + m_up.getDelay() * ratio + m_prime;
+            m_buffers.resize (1);
+            m_buffers[0].assign (channels, std::vector<double> (static_cast<size_t> (maxInternalSamples)));
+            m_input.assign (channels, std::vector<double> (static_cast<size_t> (maxBlockSize)));
+            outputSize = m_prime + static_cast<int> (std::ceil (ratio)) + 2 + m_up.getMaxOutputSamples (maxInternalSamples);
+        }
+
+        for (size_t ch = 0; ch < channels; ++ch)
+            m_internal[ch] = m_buffers[0][ch].data();
+        m_output.assign (channels, std::vector<double> (static_cast<size_t> (outputSize)));
+        reset();
+    }
+
+    void RateConverter::reset()
+    {
+        for (auto& stage : m_stages)
+            stage.reset();
+        if (m_mode == Mode::Sinc)
+        {
+            m_down.reset();
+            m_up.reset();
+        }
+        for (auto& input : m_input)
+            std::fill (input.begin(), input.end(), 0.0);
+        for (auto& output : m_output)
+            std::fill (output.begin(), output.end(), 0.0);
+        m_pending = 0;
+        m_queued = m_prime;
+    }
+
+    template <typename T>
+    int RateConverter::toInternal (const T* const* channels, int numChannels, int startSample, int numSamples)
+    {
+        assert (isActive());
+        if (m_mode == Mode::Sinc)
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto& input = m_input[static_cast<size_t> (ch)];
+                std::copy (channels[ch] + startSample, channels[ch] + startSample + numSamples, input.begin());
+                m_inputPointers[static_cast<size_t> (ch)] = input.data();
+            }
+            return m_down.process (m_inputPointers.data(), numChannels, numSamples, m_internal.data());
+        }
+
+        const auto numStages = static_cast<int> (m_stages.size());
+        const auto total = m_pending + numSamples;
+        const auto numInternal = total >> numStages;
+        const auto used = numInternal << numStages;
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const auto c = static_cast<size_t> (ch);
+            auto& input = m_input[c];
+            std::copy (channels[ch] + startSample, channels[ch] + startSample + numSamples, input.begin() + m_pending);
+
+            // each stage halves into the buffer below it
+            for (int s = numStages - 1; s >= 0; --s)
+            {
+                const auto* high = s == numStages - 1 ? input.data() : m_buffers[static_cast<size_t> (s + 1)][c].data();
+                m_stages[static_cast<size_t> (s)].downsample (ch, high, m_buffers[static_cast<size_t> (s)][c].data(), numInternal << s);
+            }
+            std::copy (input.begin() + used, input.begin() + total, input.begin());
+        }
+        m_pending = total - used;
+        return numInternal;
+    }
+
+    template <typename T>
+    void RateConverter::fromInternal (T* const* channels, int numChannels, int startSample, int numSamples, int numInternal)
+    {
+        assert (isActive());
+        int produced = 0;
+        if (m_mode == Mode::Sinc)
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+                m_outputPointers[static_cast<size_t> (ch)] = m_output[static_cast<size_t> (ch)].data() + m_queued;
+            produced = m_up.process (m_internal.data(), numChannels, numInternal, m_outputPointers.data());
+        }
+        else
+        {
+            const auto numStages = static_cast<int> (m_stages.size());
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                const auto c = static_cast<size_t> (ch);
+                for (int s = 0; s < numStages; ++s)
+                {
+                    auto* high = s == numStages - 1 ? m_output[c].data() + m_queued : m_buffers[static_cast<size_t> (s + 1)][c].data();
+                    m_stages[static_cast<size_t> (s)].upsample (ch, m_buffers[static_cast<size_t> (s)][c].data(), high, numInternal << s);
+                }
+            }
+            produced = numInternal << numStages;
+        }
+
+        const auto available = m_queued + produced;
+        assert (available >= numSamples);
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto& output = m_output[static_cast<size_t> (ch)];
+            std::copy (output.begin(), output.begin() + numSamples, channels[ch] + startSample);
+            std::copy (output.begin() + numSamples, output.begin() + available, output.begin());
+        }
+        m_queued = available - numSamples;
+    }
+
+    template int RateConverter::toInternal (const float* const*, int, int, int);
+    template int RateConverter::toInternal (const double* const*, int, int, int);
+    template void RateConverter::fromInternal (float* const*, int, int, int, int);
+    template void RateConverter::fromInternal (double* const*, int, int, int, int);
+} // namespace tonix
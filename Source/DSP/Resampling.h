@@ -0,0 +1,123 @@
+#pragma once
+
+#include "Oversampling.h"
+
+#include <vector>
+
+namespace tonix
+{
+    // Rate the channel core runs at, independent of the host's.
+    enum class InternalRate
+    {
+        Host,
+        // 44.1 or 48 kHz
+        Single,
+        // 88.2 or 96 kHz
+        Double
+    };
+
+    // The canonical rate for a host rate: the one a power-of-two ratio below it when
+    // there is one, otherwise the nearest.
+    double getInternalSampleRate (double hostRate, InternalRate);
+
+    // Kaiser windowed-sinc resampler. Rates with a small common divisor, every standard
+    // pair, get one polyphase row per output phase; anything else interpolates linearly
+    // between the rows of a finer table.
+    class SincResampler
+    {
+    public:
+        // allocates; passband is the band kept flat as a fraction of the lower rate.
+        // offset, in input samples and well below the delay, takes that much off it.
+        void prepare (int numChannels, double inputRate, double outputRate, double passband, int maxInputSamples, double offset = 0.0);
+        void reset();
+
+        // in input samples
+        double getDelay() const { return m_half - m_offset; }
+        int getMaxOutputSamples (int numInputSamples) const;
+
+        // consumes numSamples <= maxInputSamples per channel; every channel gets the
+        // same number of outputs, which is returned
+        int process (const double* const* in, int numChannels, int numSamples, double* const* out);
+
+    private:
+        double m_offset { 0.0 };
+        // taps either side of the output position, 2 * m_half per row
+        int m_half { 0 };
+        int m_rowSize { 0 };
+        // rows per input sample; interpolated tables have one more for phase 1
+        int m_numPhases { 1 };
+        bool m_interpolate { false };
+        std::vector<double> m_table;
+
+        // one output on, in whole input samples and rows
+        int m_stepSamples { 0 };
+        double m_stepPhase { 0.0 };
+
+        // per channel input, the filter's context in front
+        std::vector<std::vector<double>> m_history;
+        int m_filled { 0 };
+        // next output: the m_history sample before it and the row between that and the next
+        int m_index { 0 };
+        double m_phase { 0.0 };
+    };
+
+    // Host rate to internal rate and back around the core. A power of two below the
+    // host goes through the oversampler's linear-phase half-bands, anything else through
+    // two SincResamplers. The output waits in a short delay line so every host block
+    // gets all its samples and the latency is a whole number of host samples.
+    class RateConverter
+    {
+    public:
+        // allocates; maxBlockSize is at the host rate. coreLatency is the delay of what
+        // runs at the internal rate, in internal samples.
+        void prepare (int numChannels, double hostRate, double internalRate, int maxBlockSize, double coreLatency = 0.0);
+        void reset();
+
+        // the most internal samples one call with maxBlockSize host samples produces
+        static int getMaxInternalSamples (double hostRate, double internalRate, int maxBlockSize);
+
+        bool isActive() const { return m_mode != Mode::Off; }
+        // round trip in host samples, without the core's. The sinc path sizes it so the
+        // total with coreLatency is whole.
+        double getLatency() const { return m_latency; }
+
+        // reads numSamples <= maxBlockSize from startSample on and returns how many
+        // internal samples that made available in getInternal()
+        template <typename T>
+        int toInternal (const T* const* channels, int numChannels, int startSample, int numSamples);
+        double* const* getInternal() { return m_internal.data(); }
+        // takes the numInternal processed samples back and writes numSamples to the host
+        template <typename T>
+        void fromInternal (T* const* channels, int numChannels, int startSample, int numSamples, int numInternal);
+
+    private:
+        enum class Mode
+        {
+            Off,
+            Halfband,
+            Sinc
+        };
+        Mode m_mode { Mode::Off };
+        double m_latency { 0.0 };
+
+        // half-band: stage s runs between internal * 2^s and internal * 2^(s + 1)
+        std::vector<HalfbandStage> m_stages;
+        // per stage low-rate side, [stage][channel]; stage 0 is the internal rate
+        std::vector<std::vector<std::vector<double>>> m_buffers;
+        // host samples short of a whole internal sample
+        std::vector<std::vector<double>> m_input;
+        int m_pending { 0 };
+
+        // sinc
+        SincResampler m_down, m_up;
+
+        std::vector<double*> m_internal;
+        std::vector<const double*> m_inputPointers;
+        std::vector<double*> m_outputPointers;
+
+        // host-rate output ahead of the host, primed with silence
+        std::vector<std::vector<double>> m_output;
+        int m_queued { 0 };
+        int m_prime { 0 };
+    };
+} // namespace tonix
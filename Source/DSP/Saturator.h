@@ -0,0 +1,194 @@
+#pragma once
+
+#include "SaturatorTable.h"
+#include "Simd.h"
+
+#include <array>
+#include <utility>
+
+namespace tonix::inline TONIX_ISA_NAMESPACE
+{
+    // std::max (lo, std::min (x, hi)) for scalars and vectors
+    template <typename V>
+    inline V hardClip (V x, double lo, double hi)
+    {
+        using simd::max;
+        using simd::min;
+        return max (V (lo), min (x, V (hi)));
+    }
+
+    // coefficients of x^1 .. x^15, per curve
+    constexpr double kSaturatorPolynomials[3][15] = {
+        { 2.827568855, 0.0003903798913, -4.17220229, -0.0001107320401, 0.523459874, 0.0002768079893, -0.423546883, -0.001448632, 3.224580615, 0.002728704, -5.495344862, -0.002846356, 5.449768693, 0.001310366, -2.414078731 },
+        { 1.501040337, -0.0002757478168, -0.301802438, 0.003273802, 1.786333688, -0.046104732, -24.582679252, 0.110553367, 41.112226106, -0.092987632, -16.724196818, 0.01857341, -9.331919223, 0.006696015, 6.543207186 },
+        { 2.063930806, 0.0002008141989, -0.414990906, -0.003741183, 2.456380956, 0.03108163, -33.802027499, -0.092816819, 56.531406839, 0.134928028, -22.998647073, -0.098216457, -12.829323005, 0.028676158, 8.996306767 }
+    };
+
+    // clip range of each curve
+    constexpr double kSaturatorLimits[3][2] = {
+        { -1.0, 1.0 },
+        { -0.991184403, 0.990821248 },
+        { -0.991022224, 0.990984424 }
+    };
+
+    // antiderivative coefficients of x^2 .. x^16, per curve
+    constexpr auto kSaturatorIntegrals = []
+    {
+        std::array<std::array<double, 15>, 3> integrals {};
+        for (size_t curve = 0; curve < 3; ++curve)
+            for (size_t k = 0; k < 15; ++k)
+                integrals[curve][k] = kSaturatorPolynomials[curve][k] / static_cast<double> (k + 2);
+        return integrals;
+    }();
+
+    constexpr double evaluateSaturatorPolynomial (int curve, double x)
+    {
+        double y = 0.0;
+        for (int k = 14; k >= 0; --k)
+            y = (y + kSaturatorPolynomials[curve][k]) * x;
+        return y;
+    }
+
+    // polynomial approximation instead of table lookup
+    // V is float, double or a simd::Vec of either; coefficients are rounded to its precision
+    template <int Curve, typename V = double>
+    inline V saturate (V x)
+    {
+        static_assert (Curve >= 0 && Curve <= 2, "unknown saturator curve");
+        using simd::mulAdd;
+        constexpr auto& c = kSaturatorPolynomials[Curve];
+        constexpr auto& limits = kSaturatorLimits[Curve];
+
+        // hard clip
+        x = hardClip (x, limits[0], limits[1]);
+        const V x2 = x * x;
+        const V x4 = x2 * x2;
+        const V x6 = x4 * x2;
+        const V x8 = x4 * x4;
+
+        // terms summed lowest power first, as in the original
+        V y = x * V (c[0]);
+        y = mulAdd (x2, V (c[1]), y);
+        y = mulAdd (x2 * x, V (c[2]), y);
+        y = mulAdd (x4, V (c[3]), y);
+        y = mulAdd (x4 * x, V (c[4]), y);
+        y = mulAdd (x6, V (c[5]), y);
+        y = mulAdd (x6 * x, V (c[6]), y);
+        y = mulAdd (x8, V (c[7]), y);
+        y = mulAdd (x8 * x, V (c[8]), y);
+        y = mulAdd (x8 * x2, V (c[9]), y);
+        y = mulAdd (x8 * x2 * x, V (c[10]), y);
+        y = mulAdd (x8 * x4, V (c[11]), y);
+        y = mulAdd (x8 * x4 * x, V (c[12]), y);
+        y = mulAdd (x8 * x6, V (c[13]), y);
+        return mulAdd (x8 * x6 * x, V (c[14]), y);
+    }
+
+    // First-order antiderivative anti-aliasing: the mean of the curve between the previous
+    // and the current input, (F(x) - F(prev)) / (x - prev). The polynomial part is the
+    // divided difference of F, summed term by term as (x^m - p^m) / (x - p), so nothing
+    // cancels and near-equal inputs converge to saturate(x) without a branch. Only the
+    // linear continuation past the clip limits needs the division, and it vanishes with
+    // x - prev. Adds half a sample of delay.
+    template <int Curve, typename V = double>
+    inline V saturateAdaa (V x, V prev)
+    {
+        static_assert (Curve >= 0 && Curve <= 2, "unknown saturator curve");
+        using simd::max;
+        using simd::min;
+        using simd::mulAdd;
+        using simd::selectLess;
+        constexpr auto& b = kSaturatorIntegrals[Curve];
+        constexpr auto& limits = kSaturatorLimits[Curve];
+        constexpr double lo = limits[0], hi = limits[1];
+        // slopes of F beyond the limits
+        constexpr double fLo = evaluateSaturatorPolynomial (Curve, lo), fHi = evaluateSaturatorPolynomial (Curve, hi);
+
+        const V xc = hardClip (x, lo, hi);
+        const V pc = hardClip (prev, lo, hi);
+
+        // e_m = (x^m - p^m) / (x - p) = x e_(m-1) + p^(m-1), from m = 2
+        V e = xc + pc;
+        V pm = pc * pc;
+        V dd = e * V (b[0]);
+        for (size_t k = 1; k < 15; ++k)
+        {
+            e = mulAdd (xc, e, pm);
+            pm = pm * pc;
+            dd = mulAdd (e, V (b[k]), dd);
+        }
+
+        const V zero (0.0);
+        const V dx = x - prev;
+        const V above = max (x - V (hi), zero) - max (prev - V (hi), zero);
+        const V below = min (x - V (lo), zero) - min (prev - V (lo), zero);
+        const V outside = mulAdd (V (fHi) - dd, above, (V (fLo) - dd) * below);
+        // outside is exactly zero whenever dx is
+        return dd + outside / selectLess (dx * dx, V (1e-24), V (1.0), dx);
+    }
+
+    // Linear interpolation in a curve's table, the table tier's stand-in for saturate().
+    // Clips the same way; a NaN that survives the clip reads the first entry rather
+    // than an arbitrary address.
+    template <typename V, typename T>
+    inline V saturateTable (V x, const SaturatorTable<T>& table)
+    {
+        using simd::gather;
+        using simd::mulAdd;
+        using simd::selectLess;
+        using simd::truncate;
+        constexpr T end = static_cast<T> (SaturatorTable<T>::kSegments + 1);
+
+        x = hardClip (x, table.lo, table.hi);
+        const V position = (x - V (table.lo)) * V (table.scale);
+        const V u = selectLess (position, V (end), position, V (T (0)));
+        const V i = truncate (u);
+        const V y0 = gather (table.value.data(), i);
+        const V y1 = gather (table.value.data() + 1, i);
+        return mulAdd (y1 - y0, u - i, y0);
+    }
+
+    template <typename T = double>
+    struct Saturator
+    {
+        T process (T sample) const
+        {
+            switch (type)
+            {
+                case 0:
+                    return saturate<0> (sample);
+                case 1:
+                    return saturate<1> (sample);
+                case 2:
+                    return saturate<2> (sample);
+                default:
+                    return T (0);
+            }
+        }
+
+        // table tier, see saturateTable()
+        T processTable (T sample) const
+        {
+            return saturateTable (sample, getSaturatorTables().get<T> (type));
+        }
+
+        // ADAA variant, previous holds the last input and is advanced
+        T processAdaa (T sample, T& previous) const
+        {
+            const T prev = std::exchange (previous, sample);
+            switch (type)
+            {
+                case 0:
+                    return saturateAdaa<0> (sample, prev);
+                case 1:
+                    return saturateAdaa<1> (sample, prev);
+                case 2:
+                    return saturateAdaa<2> (sample, prev);
+                default:
+                    return T (0);
+            }
+        }
+
+        int type { 0 };
+    };
+} // namespace tonix::inline TONIX_ISA_NAMESPACE
@@ -0,0 +1,44 @@
+#include "SaturatorTable.h"
+#include "Saturator.h"
+
+#include <memory>
+
+namespace tonix
+{
+    namespace
+    {
+        template <typename T>
+        void fillTable (SaturatorTable<T>& table, int curve)
+        {
+            constexpr int segments = SaturatorTable<T>::kSegments;
+            const double lo = kSaturatorLimits[curve][0], hi = kSaturatorLimits[curve][1];
+            const double step = (hi - lo) / segments;
+            table.lo = static_cast<T> (lo);
+            table.hi = static_cast<T> (hi);
+            table.scale = static_cast<T> (segments / (hi - lo));
+
+            // knots evaluated in double whatever T
+            for (int i = 0; i < segments; ++i)
+                table.value[static_cast<size_t> (i)] = static_cast<T> (evaluateSaturatorPolynomial (curve, lo + i * step));
+            table.value[segments] = table.value[segments + 1] = static_cast<T> (evaluateSaturatorPolynomial (curve, hi));
+        }
+
+        std::unique_ptr<SaturatorTables> buildTables()
+        {
+            auto tables = std::make_unique<SaturatorTables>();
+            for (int curve = 0; curve < 3; ++curve)
+            {
+                fillTable (tables->doubles[static_cast<size_t> (curve)], curve);
+                fillTable (tables->floats[static_cast<size_t> (curve)], curve);
+            }
+            return tables;
+        }
+    } // namespace
+
+    const SaturatorTables& getSaturatorTables()
+    {
+        // thread-safe initialization; on the heap, 74 KB is too much for the stack
+        static const auto tables = buildTables();
+        return *tables;
+    }
+} // namespace tonix
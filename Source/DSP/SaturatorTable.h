@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+
+namespace tonix
+{
+    // A saturator curve sampled across its clip range for linear interpolation, what the
+    // table tier reads instead of evaluating the polynomial. A register of segment
+    // indices fetches both ends of its segments with two gathers from the same array.
+    template <typename T>
+    struct SaturatorTable
+    {
+        // about -100 dB from the polynomial, 16 KB per curve in double
+        static constexpr int kSegments = 2048;
+
+        T lo, hi;
+        // segments per unit of input
+        T scale;
+        // curve at each segment boundary, with the value at hi repeated once more so the
+        // top of the range needs no clamp
+        alignas (64) std::array<T, kSegments + 2> value;
+    };
+
+    // one table per curve and precision
+    struct SaturatorTables
+    {
+        template <typename T>
+        const SaturatorTable<T>& get (int curve) const
+        {
+            if constexpr (std::is_same_v<T, float>)
+                return floats[static_cast<size_t> (curve)];
+            else
+                return doubles[static_cast<size_t> (curve)];
+        }
+
+        std::array<SaturatorTable<double>, 3> doubles;
+        std::array<SaturatorTable<float>, 3> floats;
+    };
+
+    // built on the first call, then shared by every instance in the process
+    const SaturatorTables& getSaturatorTables();
+} // namespace tonix
@@ -0,0 +1,455 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+
+// TONIX_SIMD_SCALAR forces the portable fallback (see KernelsScalar.cpp)
+#if defined(TONIX_SIMD_SCALAR)
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#define TONIX_SIMD_SSE2 1
+#if defined(__AVX__)
+#define TONIX_SIMD_AVX 1
+#endif
+#if defined(__AVX512F__)
+#define TONIX_SIMD_AVX512 1
+#endif
+// MSVC has no __FMA__, /arch:AVX2 implies it
+#if defined(__FMA__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define TONIX_SIMD_FMA 1
+#endif
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#include <cmath>
+#define TONIX_SIMD_NEON 1
+#define TONIX_SIMD_FMA 1
+#endif
+
+// Code compiled for a specific instruction set lives in an inline namespace named after
+// it, so variants of the same inline function from differently flagged translation units
+// never get merged by the linker (see Kernels.cpp).
+#if defined(TONIX_SIMD_SCALAR)
+#define TONIX_ISA_NAMESPACE scalar
+#elif TONIX_SIMD_AVX512
+#define TONIX_ISA_NAMESPACE avx512
+#elif defined(__AVX2__)
+#define TONIX_ISA_NAMESPACE avx2
+#elif TONIX_SIMD_AVX
+#define TONIX_ISA_NAMESPACE avx
+#elif TONIX_SIMD_SSE2
+#define TONIX_ISA_NAMESPACE sse2
+#elif TONIX_SIMD_NEON
+#define TONIX_ISA_NAMESPACE neon
+#else
+#define TONIX_ISA_NAMESPACE generic
+#endif
+
+namespace tonix::inline TONIX_ISA_NAMESPACE::simd
+{
+    // Thin wrappers around the native vector registers. Only the operations the DSP
+    // kernels need are provided; each one maps to a single instruction where possible.
+    // Scalars convert implicitly, so `v * 0.5` broadcasts. Each operation rounds like
+    // its scalar counterpart, so a kernel matches the equivalent scalar expression,
+    // except mulAdd which rounds once on ISAs with FMA.
+    // widest register the current translation unit is compiled for
+#if TONIX_SIMD_AVX512
+    constexpr size_t kNativeDoubles = 8;
+#elif TONIX_SIMD_AVX
+    constexpr size_t kNativeDoubles = 4;
+#elif TONIX_SIMD_SSE2 || TONIX_SIMD_NEON
+    constexpr size_t kNativeDoubles = 2;
+#else
+    constexpr size_t kNativeDoubles = 1;
+#endif
+    constexpr size_t kNativeFloats = kNativeDoubles == 1 ? 1 : kNativeDoubles * 2;
+
+    template <typename T>
+    constexpr size_t kNativeWidth = std::is_same_v<T, float> ? kNativeFloats : kNativeDoubles;
+
+    // scalar overloads so kernels can be written once for T and Vec<T, N>
+    inline double min (double a, double b) { return (b < a) ? b : a; }
+    inline double max (double a, double b) { return (a < b) ? b : a; }
+    inline float min (float a, float b) { return (b < a) ? b : a; }
+    inline float max (float a, float b) { return (a < b) ? b : a; }
+    // a < b ? x : y, lane by lane for vectors
+    inline double selectLess (double a, double b, double x, double y) { return (a < b) ? x : y; }
+    inline float selectLess (float a, float b, float x, float y) { return (a < b) ? x : y; }
+    // rounded toward zero, for values within the int range
+    inline double truncate (double x) { return static_cast<double> (static_cast<int> (x)); }
+    inline float truncate (float x) { return static_cast<float> (static_cast<int> (x)); }
+    // table[index], lane by lane for vectors; index holds non-negative whole numbers
+    inline double gather (const double* table, double index) { return table[static_cast<int> (index)]; }
+    inline float gather (const float* table, float index) { return table[static_cast<int> (index)]; }
+
+    // a * b + c, fused where the ISA has FMA, otherwise rounded like the plain expression
+    inline double mulAdd (double a, double b, double c)
+    {
+#if TONIX_SIMD_FMA && TONIX_SIMD_SSE2
+        return _mm_cvtsd_f64 (_mm_fmadd_sd (_mm_set_sd (a), _mm_set_sd (b), _mm_set_sd (c)));
+#elif TONIX_SIMD_FMA
+        return std::fma (a, b, c);
+#else
+        return a * b + c;
+#endif
+    }
+
+    inline float mulAdd (float a, float b, float c)
+    {
+#if TONIX_SIMD_FMA && TONIX_SIMD_SSE2
+        return _mm_cvtss_f32 (_mm_fmadd_ss (_mm_set_ss (a), _mm_set_ss (b), _mm_set_ss (c)));
+#elif TONIX_SIMD_FMA
+        return std::fma (a, b, c);
+#else
+        return a * b + c;
+#endif
+    }
+
+    // portable fallback, also used for lane counts the ISA doesn't provide
+    template <typename T, size_t N>
+    struct Vec
+    {
+        static constexpr size_t size = N;
+        T v[N];
+
+        Vec() = default;
+        Vec (T x)
+        {
+            for (auto& e : v)
+                e = x;
+        }
+        static Vec load (const T* p)
+        {
+            Vec r;
+            for (size_t i = 0; i < N; ++i)
+                r.v[i] = p[i];
+            return r;
+        }
+        void store (T* p) const
+        {
+            for (size_t i = 0; i < N; ++i)
+                p[i] = v[i];
+        }
+        friend Vec operator+ (Vec a, Vec b)
+        {
+            for (size_t i = 0; i < N; ++i)
+                a.v[i] += b.v[i];
+            return a;
+        }
+        friend Vec operator- (Vec a, Vec b)
+        {
+            for (size_t i = 0; i < N; ++i)
+                a.v[i] -= b.v[i];
+            return a;
+        }
+        friend Vec operator* (Vec a, Vec b)
+        {
+            for (size_t i = 0; i < N; ++i)
+                a.v[i] *= b.v[i];
+            return a;
+        }
+        friend Vec operator/ (Vec a, Vec b)
+        {
+            for (size_t i = 0; i < N; ++i)
+                a.v[i] /= b.v[i];
+            return a;
+        }
+        friend Vec min (Vec a, Vec b)
+        {
+            for (size_t i = 0; i < N; ++i)
+                a.v[i] = simd::min (a.v[i], b.v[i]);
+            return a;
+        }
+        friend Vec max (Vec a, Vec b)
+        {
+            for (size_t i = 0; i < N; ++i)
+                a.v[i] = simd::max (a.v[i], b.v[i]);
+            return a;
+        }
+        friend Vec mulAdd (Vec a, Vec b, Vec c)
+        {
+            for (size_t i = 0; i < N; ++i)
+                c.v[i] = simd::mulAdd (a.v[i], b.v[i], c.v[i]);
+            return c;
+        }
+        friend Vec selectLess (Vec a, Vec b, Vec x, Vec y)
+        {
+            for (size_t i = 0; i < N; ++i)
+                x.v[i] = simd::selectLess (a.v[i], b.v[i], x.v[i], y.v[i]);
+            return x;
+        }
+        friend Vec truncate (Vec a)
+        {
+            for (size_t i = 0; i < N; ++i)
+                a.v[i] = simd::truncate (a.v[i]);
+            return a;
+        }
+        friend Vec gather (const T* table, Vec index)
+        {
+            for (size_t i = 0; i < N; ++i)
+                index.v[i] = simd::gather (table, index.v[i]);
+            return index;
+        }
+    };
+
+#if TONIX_SIMD_SSE2
+    template <>
+    struct Vec<double, 2>
+    {
+        static constexpr size_t size = 2;
+        __m128d v;
+
+        Vec() = default;
+        Vec (__m128d x) : v (x) {}
+        Vec (double x) : v (_mm_set1_pd (x)) {}
+        static Vec load (const double* p) { return _mm_loadu_pd (p); }
+        void store (double* p) const { _mm_storeu_pd (p, v); }
+        friend Vec operator+ (Vec a, Vec b) { return _mm_add_pd (a.v, b.v); }
+        friend Vec operator- (Vec a, Vec b) { return _mm_sub_pd (a.v, b.v); }
+        friend Vec operator* (Vec a, Vec b) { return _mm_mul_pd (a.v, b.v); }
+        friend Vec operator/ (Vec a, Vec b) { return _mm_div_pd (a.v, b.v); }
+        friend Vec min (Vec a, Vec b) { return _mm_min_pd (a.v, b.v); }
+        friend Vec max (Vec a, Vec b) { return _mm_max_pd (a.v, b.v); }
+#if TONIX_SIMD_FMA
+        friend Vec mulAdd (Vec a, Vec b, Vec c) { return _mm_fmadd_pd (a.v, b.v, c.v); }
+#else
+        friend Vec mulAdd (Vec a, Vec b, Vec c) { return _mm_add_pd (_mm_mul_pd (a.v, b.v), c.v); }
+#endif
+        friend Vec selectLess (Vec a, Vec b, Vec x, Vec y)
+        {
+            const auto mask = _mm_cmplt_pd (a.v, b.v);
+            return _mm_or_pd (_mm_and_pd (mask, x.v), _mm_andnot_pd (mask, y.v));
+        }
+        friend Vec truncate (Vec a) { return _mm_cvtepi32_pd (_mm_cvttpd_epi32 (a.v)); }
+        friend Vec gather (const double* table, Vec index)
+        {
+            const auto i = _mm_cvttpd_epi32 (index.v);
+#if defined(__AVX2__)
+            return _mm_i32gather_pd (table, i, 8);
+#else
+            return _mm_set_pd (table[_mm_cvtsi128_si32 (_mm_shuffle_epi32 (i, 1))], table[_mm_cvtsi128_si32 (i)]);
+#endif
+        }
+    };
+
+    template <>
+    struct Vec<float, 4>
+    {
+        static constexpr size_t size = 4;
+        __m128 v;
+
+        Vec() = default;
+        Vec (__m128 x) : v (x) {}
+        Vec (float x) : v (_mm_set1_ps (x)) {}
+        static Vec load (const float* p) { return _mm_loadu_ps (p); }
+        void store (float* p) const { _mm_storeu_ps (p, v); }
+        friend Vec operator+ (Vec a, Vec b) { return _mm_add_ps (a.v, b.v); }
+        friend Vec operator- (Vec a, Vec b) { return _mm_sub_ps (a.v, b.v); }
+        friend Vec operator* (Vec a, Vec b) { return _mm_mul_ps (a.v, b.v); }
+        friend Vec operator/ (Vec a, Vec b) { return _mm_div_ps (a.v, b.v); }
+        friend Vec min (Vec a, Vec b) { return _mm_min_ps (a.v, b.v); }
+        friend Vec max (Vec a, Vec b) { return _mm_max_ps (a.v, b.v); }
+#if TONIX_SIMD_FMA
+        friend Vec mulAdd (Vec a, Vec b, Vec c) { return _mm_fmadd_ps (a.v, b.v, c.v); }
+#else
+        friend Vec mulAdd (Vec a, Vec b, Vec c) { return _mm_add_ps (_mm_mul_ps (a.v, b.v), c.v); }
+#endif
+        friend Vec selectLess (Vec a, Vec b, Vec x, Vec y)
+        {
+            const auto mask = _mm_cmplt_ps (a.v, b.v);
+            return _mm_or_ps (_mm_and_ps (mask, x.v), _mm_andnot_ps (mask, y.v));
+        }
+        friend Vec truncate (Vec a) { return _mm_cvtepi32_ps (_mm_cvttps_epi32 (a.v)); }
+        friend Vec gather (const float* table, Vec index)
+        {
+            const auto i = _mm_cvttps_epi32 (index.v);
+#if defined(__AVX2__)
+            return _mm_i32gather_ps (table, i, 4);
+#else
+            alignas (16) int lanes[4];
+            _mm_store_si128 (reinterpret_cast<__m128i*> (lanes), i);
+            return _mm_setr_ps (table[lanes[0]], table[lanes[1]], table[lanes[2]], table[lanes[3]]);
+#endif
+        }
+    };
+#elif TONIX_SIMD_NEON
+    template <>
+    struct Vec<double, 2>
+    {
+        static constexpr size_t size = 2;
+        float64x2_t v;
+
+        Vec() = default;
+        Vec (float64x2_t x) : v (x) {}
+        Vec (double x) : v (vdupq_n_f64 (x)) {}
+        static Vec load (const double* p) { return vld1q_f64 (p); }
+        void store (double* p) const { vst1q_f64 (p, v); }
+        friend Vec operator+ (Vec a, Vec b) { return vaddq_f64 (a.v, b.v); }
+        friend Vec operator- (Vec a, Vec b) { return vsubq_f64 (a.v, b.v); }
+        friend Vec operator* (Vec a, Vec b) { return vmulq_f64 (a.v, b.v); }
+        friend Vec operator/ (Vec a, Vec b) { return vdivq_f64 (a.v, b.v); }
+        friend Vec min (Vec a, Vec b) { return vminq_f64 (a.v, b.v); }
+        friend Vec max (Vec a, Vec b) { return vmaxq_f64 (a.v, b.v); }
+        friend Vec mulAdd (Vec a, Vec b, Vec c) { return vfmaq_f64 (c.v, a.v, b.v); }
+        friend Vec selectLess (Vec a, Vec b, Vec x, Vec y) { return vbslq_f64 (vcltq_f64 (a.v, b.v), x.v, y.v); }
+        friend Vec truncate (Vec a) { return vrndq_f64 (a.v); }
+        friend Vec gather (const double* table, Vec index)
+        {
+            const auto i = vcvtq_s64_f64 (index.v);
+            return vsetq_lane_f64 (table[vgetq_lane_s64 (i, 1)], vdupq_n_f64 (table[vgetq_lane_s64 (i, 0)]), 1);
+        }
+    };
+
+    template <>
+    struct Vec<float, 4>
+    {
+        static constexpr size_t size = 4;
+        float32x4_t v;
+
+        Vec() = default;
+        Vec (float32x4_t x) : v (x) {}
+        Vec (float x) : v (vdupq_n_f32 (x)) {}
+        static Vec load (const float* p) { return vld1q_f32 (p); }
+        void store (float* p) const { vst1q_f32 (p, v); }
+        friend Vec operator+ (Vec a, Vec b) { return vaddq_f32 (a.v, b.v); }
+        friend Vec operator- (Vec a, Vec b) { return vsubq_f32 (a.v, b.v); }
+        friend Vec operator* (Vec a, Vec b) { return vmulq_f32 (a.v, b.v); }
+        friend Vec operator/ (Vec a, Vec b) { return vdivq_f32 (a.v, b.v); }
+        friend Vec min (Vec a, Vec b) { return vminq_f32 (a.v, b.v); }
+        friend Vec max (Vec a, Vec b) { return vmaxq_f32 (a.v, b.v); }
+        friend Vec mulAdd (Vec a, Vec b, Vec c) { return vfmaq_f32 (c.v, a.v, b.v); }
+        friend Vec selectLess (Vec a, Vec b, Vec x, Vec y) { return vbslq_f32 (vcltq_f32 (a.v, b.v), x.v, y.v); }
+        friend Vec truncate (Vec a) { return vrndq_f32 (a.v); }
+        friend Vec gather (const float* table, Vec index)
+        {
+            int lanes[4];
+            vst1q_s32 (lanes, vcvtq_s32_f32 (index.v));
+            const float values[4] = { table[lanes[0]], table[lanes[1]], table[lanes[2]], table[lanes[3]] };
+            return vld1q_f32 (values);
+        }
+    };
+#endif
+
+#if TONIX_SIMD_AVX
+    template <>
+    struct Vec<double, 4>
+    {
+        static constexpr size_t size = 4;
+        __m256d v;
+
+        Vec() = default;
+        Vec (__m256d x) : v (x) {}
+        Vec (double x) : v (_mm256_set1_pd (x)) {}
+        static Vec load (const double* p) { return _mm256_loadu_pd (p); }
+        void store (double* p) const { _mm256_storeu_pd (p, v); }
+        friend Vec operator+ (Vec a, Vec b) { return _mm256_add_pd (a.v, b.v); }
+        friend Vec operator- (Vec a, Vec b) { return _mm256_sub_pd (a.v, b.v); }
+        friend Vec operator* (Vec a, Vec b) { return _mm256_mul_pd (a.v, b.v); }
+        friend Vec operator/ (Vec a, Vec b) { return _mm256_div_pd (a.v, b.v); }
+        friend Vec min (Vec a, Vec b) { return _mm256_min_pd (a.v, b.v); }
+        friend Vec max (Vec a, Vec b) { return _mm256_max_pd (a.v, b.v); }
+#if TONIX_SIMD_FMA
+        friend Vec mulAdd (Vec a, Vec b, Vec c) { return _mm256_fmadd_pd (a.v, b.v, c.v); }
+#else
+        friend Vec mulAdd (Vec a, Vec b, Vec c) { return _mm256_add_pd (_mm256_mul_pd (a.v, b.v), c.v); }
+#endif
+        friend Vec selectLess (Vec a, Vec b, Vec x, Vec y) { return _mm256_blendv_pd (y.v, x.v, _mm256_cmp_pd (a.v, b.v, _CMP_LT_OQ)); }
+        friend Vec truncate (Vec a) { return _mm256_round_pd (a.v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+        friend Vec gather (const double* table, Vec index)
+        {
+            const auto i = _mm256_cvttpd_epi32 (index.v);
+#if defined(__AVX2__)
+            return _mm256_i32gather_pd (table, i, 8);
+#else
+            alignas (16) int lanes[4];
+            _mm_store_si128 (reinterpret_cast<__m128i*> (lanes), i);
+            return _mm256_setr_pd (table[lanes[0]], table[lanes[1]], table[lanes[2]], table[lanes[3]]);
+#endif
+        }
+    };
+
+    template <>
+    struct Vec<float, 8>
+    {
+        static constexpr size_t size = 8;
+        __m256 v;
+
+        Vec() = default;
+        Vec (__m256 x) : v (x) {}
+        Vec (float x) : v (_mm256_set1_ps (x)) {}
+        static Vec load (const float* p) { return _mm256_loadu_ps (p); }
+        void store (float* p) const { _mm256_storeu_ps (p, v); }
+        friend Vec operator+ (Vec a, Vec b) { return _mm256_add_ps (a.v, b.v); }
+        friend Vec operator- (Vec a, Vec b) { return _mm256_sub_ps (a.v, b.v); }
+        friend Vec operator* (Vec a, Vec b) { return _mm256_mul_ps (a.v, b.v); }
+        friend Vec operator/ (Vec a, Vec b) { return _mm256_div_ps (a.v, b.v); }
+        friend Vec min (Vec a, Vec b) { return _mm256_min_ps (a.v, b.v); }
+        friend Vec max (Vec a, Vec b) { return _mm256_max_ps (a.v, b.v); }
+#if TONIX_SIMD_FMA
+        friend Vec mulAdd (Vec a, Vec b, Vec c) { return _mm256_fmadd_ps (a.v, b.v, c.v); }
+#else
+        friend Vec mulAdd (Vec a, Vec b, Vec c) { return _mm256_add_ps (_mm256_mul_ps (a.v, b.v), c.v); }
+#endif
+        friend Vec selectLess (Vec a, Vec b, Vec x, Vec y) { return _mm256_blendv_ps (y.v, x.v, _mm256_cmp_ps (a.v, b.v, _CMP_LT_OQ)); }
+        friend Vec truncate (Vec a) { return _mm256_round_ps (a.v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+        friend Vec gather (const float* table, Vec index)
+        {
+            const auto i = _mm256_cvttps_epi32 (index.v);
+#if defined(__AVX2__)
+            return _mm256_i32gather_ps (table, i, 4);
+#else
+            alignas (32) int lanes[8];
+            _mm256_store_si256 (reinterpret_cast<__m256i*> (lanes), i);
+            return _mm256_setr_ps (table[lanes[0]], table[lanes[1]], table[lanes[2]], table[lanes[3]], table[lanes[4]], table[lanes[5]], table[lanes[6]], table[lanes[7]]);
+#endif
+        }
+    };
+#endif
+
+#if TONIX_SIMD_AVX512
+    template <>
+    struct Vec<double, 8>
+    {
+        static constexpr size_t size = 8;
+        __m512d v;
+
+        Vec() = default;
+        Vec (__m512d x) : v (x) {}
+        Vec (double x) : v (_mm512_set1_pd (x)) {}
+        static Vec load (const double* p) { return _mm512_loadu_pd (p); }
+        void store (double* p) const { _mm512_storeu_pd (p, v); }
+        friend Vec operator+ (Vec a, Vec b) { return _mm512_add_pd (a.v, b.v); }
+        friend Vec operator- (Vec a, Vec b) { return _mm512_sub_pd (a.v, b.v); }
+        friend Vec operator* (Vec a, Vec b) { return _mm512_mul_pd (a.v, b.v); }
+        friend Vec operator/ (Vec a, Vec b) { return _mm512_div_pd (a.v, b.v); }
+        friend Vec min (Vec a, Vec b) { return _mm512_min_pd (a.v, b.v); }
+        friend Vec max (Vec a, Vec b) { return _mm512_max_pd (a.v, b.v); }
+        friend Vec mulAdd (Vec a, Vec b, Vec c) { return _mm512_fmadd_pd (a.v, b.v, c.v); }
+        friend Vec selectLess (Vec a, Vec b, Vec x, Vec y) { return _mm512_mask_blend_pd (_mm512_cmp_pd_mask (a.v, b.v, _CMP_LT_OQ), y.v, x.v); }
+        friend Vec truncate (Vec a) { return _mm512_roundscale_pd (a.v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+        friend Vec gather (const double* table, Vec index) { return _mm512_i32gather_pd (_mm512_cvttpd_epi32 (index.v), table, 8); }
+    };
+
+    template <>
+    struct Vec<float, 16>
+    {
+        static constexpr size_t size = 16;
+        __m512 v;
+
+        Vec() = default;
+        Vec (__m512 x) : v (x) {}
+        Vec (float x) : v (_mm512_set1_ps (x)) {}
+        static Vec load (const float* p) { return _mm512_loadu_ps (p); }
+        void store (float* p) const { _mm512_storeu_ps (p, v); }
+        friend Vec operator+ (Vec a, Vec b) { return _mm512_add_ps (a.v, b.v); }
+        friend Vec operator- (Vec a, Vec b) { return _mm512_sub_ps (a.v, b.v); }
+        friend Vec operator* (Vec a, Vec b) { return _mm512_mul_ps (a.v, b.v); }
+        friend Vec operator/ (Vec a, Vec b) { return _mm512_div_ps (a.v, b.v); }
+        friend Vec min (Vec a, Vec b) { return _mm512_min_ps (a.v, b.v); }
+        friend Vec max (Vec a, Vec b) { return _mm512_max_ps (a.v, b.v); }
+        friend Vec mulAdd (Vec a, Vec b, Vec c) { return _mm512_fmadd_ps (a.v, b.v, c.v); }
+        friend Vec selectLess (Vec a, Vec b, Vec x, Vec y) { return _mm512_mask_blend_ps (_mm512_cmp_ps_mask (a.v, b.v, _CMP_LT_OQ), y.v, x.v); }
+        friend Vec truncate (Vec a) { return _mm512_roundscale_ps (a.v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+        friend Vec gather (const float* table, Vec index) { return _mm512_i32gather_ps (_mm512_cvttps_epi32 (index.v), table, 4); }
+    };
+#endif
+} // namespace tonix::inline TONIX_ISA_NAMESPACE::simd
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "Saturator.h"
+
+namespace tonix::inline TONIX_ISA_NAMESPACE
+{
+    // per-block values shared by the stage functions below, in the kernel's precision
+    template <typename T>
+    struct StageCoefficients
+    {
+        T hpf_k, lpf_k, f1, p20, p24;
+        T curProcessing;
+        // 0.5 for Luster, 1.0 otherwise
+        T outScale;
+        bool luster, g0;
+    };
+
+    // Stages of Channel::process(), written once for scalars and simd::Vec so they can run
+    // across time (consecutive samples of one channel) or across lanes (one sample of
+    // several channels). Operation order follows the per-sample path exactly; each
+    // a * b + c goes through mulAdd, so only ISAs with FMA round differently.
+    // C is StageCoefficients or a type exposing the same members as compile-time
+    // constants (see kernels::FixedCoefficients).
+
+    // HPF/shelf (x1, x2)
+    template <typename V, typename C>
+    inline V filterStage (V x, V prevX, const C& c)
+    {
+        using simd::mulAdd;
+        const V x1 = mulAdd (V (c.hpf_k), x, x - prevX);
+        return mulAdd (x1, V (c.f1), x1);
+    }
+
+    // input of the first saturator
+    template <typename V, typename C>
+    inline V driveInput (V x2, const C& c)
+    {
+        return c.luster ? x2 * c.curProcessing : x2;
+    }
+
+    // input of the second saturator, the first one's output x4 over the dry or shelved x3
+    template <typename V, typename C>
+    inline V blendInput (V x, V x2, V x4, const C& c)
+    {
+        using simd::mulAdd;
+        const V x3 = c.g0 ? x2 : x;
+        return mulAdd (x4 * c.curProcessing, V (c.p20), x3);
+    }
+
+    // HPF/shelf and both saturators (x1..x5), no memory across samples
+    template <int Curve, typename V, typename C>
+    inline V shapeStage (V x, V prevX, const C& c)
+    {
+        const V x2 = filterStage (x, prevX, c);
+        const V x4 = saturate<Curve> (driveInput (x2, c));
+        return saturate<Curve> (blendInput (x, x2, x4, c));
+    }
+
+    // shapeStage with antiderivative anti-aliasing; each saturator remembers its last input
+    template <int Curve, typename V, typename C>
+    inline V shapeStageAdaa (V x, V prevX, V& prevDrive, V& prevBlend, const C& c)
+    {
+        const V x2 = filterStage (x, prevX, c);
+        const V drive = driveInput (x2, c);
+        const V x4 = saturateAdaa<Curve> (drive, prevDrive);
+        const V blend = blendInput (x, x2, x4, c);
+        const V x5 = saturateAdaa<Curve> (blend, prevBlend);
+        prevDrive = drive;
+        prevBlend = blend;
+        return x5;
+    }
+
+    // shapeStage with both saturators read from the curve's table
+    template <typename V, typename C, typename T>
+    inline V shapeStageTable (V x, V prevX, const C& c, const SaturatorTable<T>& table)
+    {
+        const V x2 = filterStage (x, prevX, c);
+        const V x4 = saturateTable (driveInput (x2, c), table);
+        return saturateTable (blendInput (x, x2, x4, c), table);
+    }
+
+    // one-pole LPF, the only recursive stage
+    template <typename V>
+    inline V lowpassStage (V& state, V x5, V lpf_k)
+    {
+        using simd::mulAdd;
+        state = mulAdd (x5 - state, lpf_k, state);
+        return state;
+    }
+
+    // dry/wet sum, before auto-gain and output trim
+    template <typename V, typename C>
+    inline V mixStage (V x, V s, const C& c)
+    {
+        using simd::mulAdd;
+        return mulAdd (V (c.curProcessing) * (s - x * c.p24), V (c.outScale), x);
+    }
+} // namespace tonix::inline TONIX_ISA_NAMESPACE
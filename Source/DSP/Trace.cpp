@@ -0,0 +1,238 @@
+// Only built with TONIX_ENABLE_TRACE, see Trace.h.
+#include "Trace.h"
+
+#if TONIX_TRACE
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace tonix::trace
+{
+    namespace
+    {
+        // threads that ever record, each keeps its buffer for good
+        constexpr int kMaxThreads = 32;
+        // events a thread can record between two flushes
+        constexpr uint64_t kCapacity = 1 << 14;
+        constexpr auto kFlushInterval = std::chrono::milliseconds (50);
+
+        struct Event
+        {
+            const char* name;
+            uint64_t begin, end;
+            int64_t value;
+        };
+
+        // the thread it belongs to writes, the writer thread reads
+        struct Buffer
+        {
+            std::unique_ptr<Event[]> events;
+            std::atomic<uint64_t> written { 0 }, read { 0 }, dropped { 0 };
+        };
+
+        struct Tracer
+        {
+            std::array<Buffer, kMaxThreads> buffers;
+            std::atomic<int> numBuffers { 0 };
+            std::atomic<bool> recording { false };
+            // threads past kMaxThreads
+            std::atomic<uint64_t> dropped { 0 };
+
+            std::mutex lock;
+            int numUsers = 0, numSessions = 0;
+            uint64_t origin = 0;
+            std::FILE* file = nullptr;
+            bool first = true;
+            std::thread writer;
+            std::condition_variable wakeUp;
+            bool stopping = false;
+        };
+
+        Tracer& getTracer()
+        {
+            static Tracer tracer;
+            return tracer;
+        }
+
+        int getProcessId()
+        {
+#ifdef _WIN32
+            return _getpid();
+#else
+            return static_cast<int> (getpid());
+#endif
+        }
+
+        Buffer* getThreadBuffer (Tracer& tracer)
+        {
+            // claimed with the thread's first event, -1 once they have run out
+            thread_local int index = -2;
+            if (index == -2)
+            {
+                index = tracer.numBuffers.fetch_add (1, std::memory_order_relaxed);
+                if (index >= kMaxThreads)
+                    index = -1;
+            }
+            return index >= 0 ? &tracer.buffers[static_cast<size_t> (index)] : nullptr;
+        }
+
+        // the caller holds the lock
+        void flush (Tracer& tracer)
+        {
+            const auto pid = getProcessId();
+            const auto toMicroseconds = [&tracer] (uint64_t time)
+            {
+                return static_cast<double> (time - std::min (time, tracer.origin)) * 1.0e-3;
+            };
+            const auto numBuffers = std::min (tracer.numBuffers.load (std::memory_order_acquire), kMaxThreads);
+            for (int b = 0; b < numBuffers; ++b)
+            {
+                auto& buffer = tracer.buffers[static_cast<size_t> (b)];
+                const auto written = buffer.written.load (std::memory_order_acquire);
+                auto read = buffer.read.load (std::memory_order_relaxed);
+                for (; read < written; ++read)
+                {
+                    const auto& event = buffer.events[read % kCapacity];
+                    // the JSON array format, which tolerates a missing ']' after a crash
+                    std::fprintf (tracer.file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f", tracer.first ? "" : ",\n", event.name, pid, b + 1, toMicroseconds (event.begin), static_cast<double> (event.end - event.begin) * 1.0e-3);
+                    if (event.value != Scope::kNoValue)
+                        std::fprintf (tracer.file, ",\"args\":{\"value\":%lld}", static_cast<long long> (event.value));
+                    std::fputs ("}", tracer.file);
+                    tracer.first = false;
+                }
+                buffer.read.store (read, std::memory_order_release);
+            }
+            std::fflush (tracer.file);
+        }
+
+        void writeDropped (Tracer& tracer)
+        {
+            uint64_t dropped = tracer.dropped.exchange (0, std::memory_order_relaxed);
+            for (auto& buffer : tracer.buffers)
+                dropped += buffer.dropped.exchange (0, std::memory_order_relaxed);
+            if (dropped == 0)
+                return;
+            // a global instant event, so it shows however the trace is filtered
+            std::fprintf (tracer.file, "%s{\"name\":\"dropped events\",\"ph\":\"i\",\"s\":\"g\",\"pid\":%d,\"tid\":0,\"ts\":%.3f,\"args\":{\"value\":%llu}}", tracer.first ? "" : ",\n", getProcessId(), static_cast<double> (now() - tracer.origin) * 1.0e-3, static_cast<unsigned long long> (dropped));
+            tracer.first = false;
+        }
+
+        std::string getFileName (int session)
+        {
+            if (const auto* file = std::getenv ("TONIX_TRACE_FILE"); file != nullptr && *file != '\0')
+                return session == 1 ? std::string (file) : std::string (file) + "." + std::to_string (session);
+            const auto name = "tonix-trace-" + std::to_string (getProcessId()) + "-" + std::to_string (session) + ".json";
+            std::error_code error;
+            const auto directory = std::filesystem::temp_directory_path (error);
+            return error ? name : (directory / name).string();
+        }
+    } // namespace
+
+    uint64_t now()
+    {
+        return static_cast<uint64_t> (std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    void record (const char* name, uint64_t begin, uint64_t end, int64_t value)
+    {
+        auto& tracer = getTracer();
+        if (! tracer.recording.load (std::memory_order_relaxed))
+            return;
+        auto* buffer = getThreadBuffer (tracer);
+        if (buffer == nullptr)
+        {
+            tracer.dropped.fetch_add (1, std::memory_order_relaxed);
+            return;
+        }
+        // one writer, so no read-modify-write needed
+        const auto written = buffer->written.load (std::memory_order_relaxed);
+        if (written - buffer->read.load (std::memory_order_acquire) >= kCapacity)
+        {
+            buffer->dropped.store (buffer->dropped.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return;
+        }
+        buffer->events[written % kCapacity] = { name, begin, end, value };
+        buffer->written.store (written + 1, std::memory_order_release);
+    }
+
+    void start()
+    {
+        auto& tracer = getTracer();
+        const std::lock_guard lock (tracer.lock);
+        if (tracer.numUsers++ > 0)
+            return;
+
+        const auto fileName = getFileName (++tracer.numSessions);
+        tracer.file = std::fopen (fileName.c_str(), "w");
+        if (tracer.file == nullptr)
+        {
+            std::fprintf (stderr, "tonix: can't write the trace to %s\n", fileName.c_str());
+            return;
+        }
+        std::fputs ("[\n", tracer.file);
+        std::fprintf (tracer.file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"Tonix\"}}", getProcessId());
+        tracer.first = false;
+
+        // allocated here rather than by the threads that record; what a previous
+        // session left unwritten is dropped
+        for (auto& buffer : tracer.buffers)
+        {
+            if (buffer.events == nullptr)
+                buffer.events = std::make_unique<Event[]> (kCapacity);
+            buffer.read.store (buffer.written.load (std::memory_order_acquire), std::memory_order_release);
+            buffer.dropped.store (0, std::memory_order_relaxed);
+        }
+        tracer.origin = now();
+        tracer.stopping = false;
+        tracer.recording.store (true, std::memory_order_release);
+
+        tracer.writer = std::thread ([&tracer]
+                                     {
+                                         std::unique_lock writerLock (tracer.lock);
+                                         while (! tracer.stopping)
+                                         {
+                                             tracer.wakeUp.wait_for (writerLock, kFlushInterval);
+                                             flush (tracer);
+                                         }
+                                     });
+    }
+
+    void stop()
+    {
+        auto& tracer = getTracer();
+        std::unique_lock lock (tracer.lock);
+        if (tracer.numUsers == 0 || --tracer.numUsers > 0 || tracer.file == nullptr)
+            return;
+
+        tracer.recording.store (false, std::memory_order_release);
+        tracer.stopping = true;
+        lock.unlock();
+        tracer.wakeUp.notify_one();
+        tracer.writer.join();
+        lock.lock();
+
+        // events still in flight on other threads are lost with the rest of the buffer
+        flush (tracer);
+        writeDropped (tracer);
+        std::fputs ("\n]\n", tracer.file);
+        std::fclose (tracer.file);
+        tracer.file = nullptr;
+    }
+} // namespace tonix::trace
+#endif
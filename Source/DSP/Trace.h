@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+
+// Scoped markers for where a block's time goes, written out as a Chrome trace for
+// chrome://tracing or ui.perfetto.dev. They are only built with TONIX_ENABLE_TRACE,
+// otherwise the macros expand to nothing and no code or data is left behind.
+//
+//     TONIX_TRACE_SCOPE ("process");             // from here to the end of the scope
+//     TONIX_TRACE_SCOPE_VALUE ("slice", index);  // with a number in the event's args
+//
+// Names must be string literals, events keep only the pointer. Events are recorded
+// between TONIX_TRACE_START() and the matching TONIX_TRACE_STOP().
+#if TONIX_TRACE
+#define TONIX_TRACE_CONCAT_(a, b) a##b
+#define TONIX_TRACE_CONCAT(a, b) TONIX_TRACE_CONCAT_ (a, b)
+#define TONIX_TRACE_SCOPE(name) const ::tonix::trace::Scope TONIX_TRACE_CONCAT (tonixTraceScope, __LINE__) (name)
+#define TONIX_TRACE_SCOPE_VALUE(name, value) const ::tonix::trace::Scope TONIX_TRACE_CONCAT (tonixTraceScope, __LINE__) (name, static_cast<int64_t> (value))
+#define TONIX_TRACE_START() ::tonix::trace::start()
+#define TONIX_TRACE_STOP() ::tonix::trace::stop()
+#else
+#define TONIX_TRACE_SCOPE(name) ((void) 0)
+#define TONIX_TRACE_SCOPE_VALUE(name, value) ((void) 0)
+#define TONIX_TRACE_START() ((void) 0)
+#define TONIX_TRACE_STOP() ((void) 0)
+#endif
+
+#if TONIX_TRACE
+namespace tonix::trace
+{
+    // Counted, for plugin instances coming and going. The first start allocates a
+    // buffer for each thread that will record and starts a thread writing them to
+    // TONIX_TRACE_FILE, or to tonix-trace-<pid>-<n>.json in the temp directory. The
+    // last stop writes what is left and closes the file.
+    void start();
+    void stop();
+
+    // nanoseconds on a monotonic clock
+    uint64_t now();
+    // lock- and allocation-free; dropped while stopped or when the thread's buffer is full
+    void record (const char* name, uint64_t begin, uint64_t end, int64_t value);
+
+    class Scope
+    {
+    public:
+        static constexpr int64_t kNoValue = INT64_MIN;
+
+        explicit Scope (const char* name, int64_t value = kNoValue)
+            : m_name (name), m_value (value), m_begin (now())
+        {
+        }
+
+        ~Scope() { record (m_name, m_begin, now(), m_value); }
+
+        Scope (const Scope&) = delete;
+        Scope& operator= (const Scope&) = delete;
+
+    private:
+        const char* m_name;
+        int64_t m_value;
+        uint64_t m_begin;
+    };
+} // namespace tonix::trace
+#endif
@@ -0,0 +1,154 @@
+#include "WorkerPool.h"
+#include "FloatMode.h"
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#define TONIX_X86_WORKERS 1
+#elif defined(_M_ARM64)
+#include <intrin.h>
+#endif
+
+namespace tonix
+{
+    namespace
+    {
+        // pause instructions an idle thread polls for before it sleeps, somewhere around
+        // a tenth of a millisecond
+        constexpr int kSpinIterations = 4096;
+
+        constexpr uint64_t kNextTask = uint64_t (1) << 16;
+
+        int getNext (uint64_t state) { return static_cast<int> ((state >> 16) & 0xffff); }
+        int getCount (uint64_t state) { return static_cast<int> (state & 0xffff); }
+
+        void pause()
+        {
+#if TONIX_X86_WORKERS
+            _mm_pause();
+#elif defined(_M_ARM64)
+            __yield();
+#elif defined(__aarch64__)
+            __asm__ volatile ("yield");
+#endif
+        }
+    } // namespace
+
+    bool WorkerPool::Job::runNext()
+    {
+        auto current = state.load (std::memory_order_acquire);
+        for (;;)
+        {
+            if (getNext (current) >= getCount (current))
+                return false;
+            if (state.compare_exchange_weak (current, current + kNextTask, std::memory_order_acq_rel, std::memory_order_acquire))
+                break;
+        }
+
+        // the owner is waiting for this task, so the job stays as it was claimed
+        if (getFloatMode() != floatMode)
+            setFloatMode (floatMode);
+        task (context, getNext (current));
+        done.fetch_add (1, std::memory_order_release);
+        return true;
+    }
+
+    WorkerPool::WorkerPool (int numThreads)
+    {
+        m_threads.reserve (static_cast<size_t> (std::max (0, numThreads)));
+        for (int i = 0; i < numThreads; ++i)
+            m_threads.emplace_back ([this]
+                                    { work(); });
+    }
+
+    WorkerPool::~WorkerPool()
+    {
+        {
+            const std::lock_guard lock (m_sleepMutex);
+            m_running.store (false);
+        }
+        m_wake.notify_all();
+        for (auto& thread : m_threads)
+            thread.join();
+    }
+
+    void WorkerPool::run (Task task, void* context, int numTasks)
+    {
+        Job* job = nullptr;
+        if (numTasks > 1 && numTasks <= kMaxTasks && ! m_threads.empty())
+        {
+            for (auto& slot : m_jobs)
+            {
+                if (! slot.taken.load (std::memory_order_relaxed) && ! slot.taken.exchange (true, std::memory_order_acquire))
+                {
+                    job = &slot;
+                    break;
+                }
+            }
+        }
+        if (job == nullptr)
+        {
+            for (int i = 0; i < numTasks; ++i)
+                task (context, i);
+            return;
+        }
+
+        job->task = task;
+        job->context = context;
+        job->floatMode = getFloatMode();
+        job->done.store (0, std::memory_order_relaxed);
+        const auto generation = (job->state.load (std::memory_order_relaxed) >> 32) + 1;
+        job->state.store ((generation << 32) | static_cast<uint64_t> (numTasks), std::memory_order_release);
+
+        // a thread that saw no sleepers hasn't started to sleep and will see the post
+        m_posted.fetch_add (1);
+        if (m_sleepers.load() > 0)
+            m_wake.notify_all();
+
+        while (job->runNext())
+        {
+        }
+        while (job->done.load (std::memory_order_acquire) < numTasks)
+            pause();
+        job->taken.store (false, std::memory_order_release);
+    }
+
+    bool WorkerPool::help()
+    {
+        for (auto& job : m_jobs)
+            if (job.runNext())
+                return true;
+        return false;
+    }
+
+    void WorkerPool::work()
+    {
+        while (m_running.load (std::memory_order_relaxed))
+        {
+            const auto seen = m_posted.load (std::memory_order_acquire);
+            while (help())
+            {
+            }
+
+            for (int i = 0; i < kSpinIterations && m_posted.load (std::memory_order_acquire) == seen; ++i)
+                pause();
+            if (m_posted.load (std::memory_order_acquire) != seen)
+                continue;
+
+            // a post between the check and the wait can go unnoticed until the next one,
+            // whose caller then runs more of its tasks itself
+            std::unique_lock lock (m_sleepMutex);
+            m_sleepers.fetch_add (1);
+            m_wake.wait (lock, [this, seen]
+                         { return m_posted.load() != seen || ! m_running.load(); });
+            m_sleepers.fetch_sub (1);
+        }
+    }
+
+    WorkerPool& getWorkerPool()
+    {
+        static WorkerPool pool (std::max (0, static_cast<int> (std::thread::hardware_concurrency()) - 1));
+        return pool;
+    }
+} // namespace tonix
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tonix
+{
+    // keeps data that different threads write on separate cache lines
+    constexpr size_t kCacheLineSize = 64;
+
+    // Runs a batch of independent tasks, each index once, and returns when all of them
+    // have finished. The calling thread may run any of them.
+    class TaskRunner
+    {
+    public:
+        using Task = void (*) (void* context, int index);
+
+        virtual ~TaskRunner() = default;
+        virtual void run (Task, void* context, int numTasks) = 0;
+    };
+
+    // Threads that help with jobs posted from any thread, other instances' audio threads
+    // included. Posting and waiting neither allocate nor lock: a job takes one of a fixed
+    // number of slots, threads claim its tasks with a compare-and-swap and the caller
+    // runs tasks too, then spins until the last one finishes. Idle threads poll for a
+    // while before they sleep, so a steady stream of blocks finds them awake.
+    //
+    // Tasks run with the caller's floating-point mode, flush-to-zero included.
+    class WorkerPool final : public TaskRunner
+    {
+    public:
+        static constexpr int kMaxJobs = 32;
+        static constexpr int kMaxTasks = 0xffff;
+
+        // starts the threads, not real-time safe
+        explicit WorkerPool (int numThreads);
+        ~WorkerPool() override;
+
+        int getNumThreads() const { return static_cast<int> (m_threads.size()); }
+
+        // real-time safe; runs everything on the caller's thread when all slots are taken
+        void run (Task, void* context, int numTasks) override;
+        // runs a task of any posted job, false if there was none; for threads lent by a host
+        bool help();
+
+    private:
+        struct alignas (kCacheLineSize) Job
+        {
+            // claims the next task and runs it, false once all are claimed
+            bool runNext();
+
+            Task task { nullptr };
+            void* context { nullptr };
+            uint64_t floatMode { 0 };
+            // generation << 32 | next task << 16 | number of tasks, so a thread that
+            // looked at a finished job can't claim from the one that reuses its slot
+            std::atomic<uint64_t> state { 0 };
+            std::atomic<int> done { 0 };
+            std::atomic<bool> taken { false };
+        };
+
+        void work();
+
+        std::array<Job, kMaxJobs> m_jobs;
+        alignas (kCacheLineSize) std::atomic<uint32_t> m_posted { 0 };
+        std::atomic<int> m_sleepers { 0 };
+        std::atomic<bool> m_running { true };
+        // std::atomic::wait needs macOS 11, idle threads sleep on a condition variable;
+        // posting notifies it without taking the mutex
+        std::mutex m_sleepMutex;
+        std::condition_variable m_wake;
+        std::vector<std::thread> m_threads;
+    };
+
+    // one per process, a thread per hardware thread but one; started by the first call,
+    // which must not be on an audio thread
+    WorkerPool& getWorkerPool();
+} // namespace tonix
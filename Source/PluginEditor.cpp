@@ -16,6 +16,7 @@ void TonixKnobStyle::drawRotarySlider (Graphics& g,
                                        Slider& slider)
 {
     juce::ignoreUnused (sliderPosProportional, rotaryStartAngle, rotaryEndAngle);
+    TONIX_TRACE_SCOPE ("knob paint");
     // Knob origin https://www.g200kg.com/en/webknobman/gallery.php?m=p&p=1540
     Image myStrip = ImageCache::getFromMemory (BinaryData::KNB_metal_pink_L_png, BinaryData::KNB_metal_pink_L_pngSize);
     const double fractRotation = (slider.getValue() - slider.getMinimum()) / (slider.getMaximum() - slider.getMinimum()); // normalized
@@ -38,8 +39,48 @@ void TonixKnobStyle::drawRotarySlider (Graphics& g,
                  myStrip.getWidth()); //Source
 }
 
+TonixLoadMeter::TonixLoadMeter (TonixProcessor& p)
+    : m_processor (p)
+{
+    startTimerHz (10);
+}
+
+void TonixLoadMeter::timerCallback()
+{
+    // about the last half second
+    const auto blocks = m_processor.getBlockSize() > 0 ? roundToInt (m_processor.getSampleRate() * 0.5 / m_processor.getBlockSize()) : 0;
+    m_recent = m_processor.getLoadMeter().getRecentStats (std::max (1, blocks));
+    m_total = m_processor.getLoadMeter().getStats();
+    repaint();
+}
+
+void TonixLoadMeter::mouseDown (const MouseEvent&)
+{
+    m_processor.resetLoadMeter();
+}
+
+void TonixLoadMeter::paint (Graphics& g)
+{
+    TONIX_TRACE_SCOPE ("load meter paint");
+    auto bounds = getLocalBounds().toFloat();
+    auto bar = bounds.removeFromBottom (3.0f);
+    g.setColour (Colours::black.withAlpha (0.4f));
+    g.fillRect (bar);
+    // the instance's share of the deadline, which the whole session has to fit in
+    const auto peak = static_cast<float> (jlimit (0.0, 1.0, m_recent.max));
+    g.setColour (peak < 0.25f ? Colours::limegreen : peak < 0.5f ? Colours::orange : Colours::red);
+    g.fillRect (bar.withWidth (bar.getWidth() * peak));
+
+    auto text = String::formatted ("CPU %.1f%%  p99 %.1f%%", m_recent.mean * 100.0, m_total.p99 * 100.0);
+    if (m_total.overruns > 0)
+        text << "  " << String (static_cast<int64> (m_total.overruns)) << " over";
+    g.setColour (Colours::white.withAlpha (0.8f));
+    g.setFont (FontOptions().withHeight (10.0f));
+    g.drawText (text, bounds, Justification::centredRight, false);
+}
+
 TonixEditor::TonixEditor (TonixProcessor& p)
-    : AudioProcessorEditor (&p), m_attachments (p.apvts, m_sliders, m_bypassButton, m_autoGainButton), processorRef (p)
+    : AudioProcessorEditor (&p), m_attachments (p.apvts, m_sliders, m_bypassButton, m_autoGainButton), processorRef (p), m_loadMeter (p)
 {
     juce::ignoreUnused (processorRef);
 
@@ -118,6 +159,15 @@ TonixEditor::TonixEditor (TonixProcessor& p)
     };
     addAndMakeVisible (m_undoButton);
     addAndMakeVisible (m_redoButton);
+
+    m_optionsButton.setButtonText ("OPTIONS");
+    m_optionsButton.setLookAndFeel (&m_textButtonStyle);
+    m_optionsButton.onClick = [this]
+    {
+        showOptionsMenu();
+    };
+    addAndMakeVisible (m_optionsButton);
+    addAndMakeVisible (m_loadMeter);
     m_undoButton.setEnabled (processorRef.undoManager.canUndo());
     m_redoButton.setEnabled (processorRef.undoManager.canRedo());
 
@@ -138,8 +188,93 @@ TonixEditor::~TonixEditor()
     processorRef.apvts.removeParameterListener ("bypass", m_bypassNotifier.get());
 }
 
+void TonixEditor::showOptionsMenu()
+{
+    const auto settings = processorRef.getEngineSettings();
+    // the processor outlives the menu, the editor might not
+    auto change = [&p = processorRef] (auto edit)
+    {
+        auto newSettings = p.getEngineSettings();
+        edit (newSettings);
+        p.setEngineSettings (newSettings);
+    };
+
+    PopupMenu precision;
+    precision.addItem ("64-bit", true, settings.precision == tonix::Precision::Double, [change]
+                       { change ([] (auto& s) { s.precision = tonix::Precision::Double; }); });
+    precision.addItem ("32-bit (lower CPU)", true, settings.precision == tonix::Precision::Float, [change]
+                       { change ([] (auto& s) { s.precision = tonix::Precision::Float; }); });
+
+    PopupMenu antialiasing;
+    antialiasing.addItem ("Off", true, settings.antialiasing == tonix::Antialiasing::Off, [change]
+                          { change ([] (auto& s) { s.antialiasing = tonix::Antialiasing::Off; }); });
+    antialiasing.addItem ("Antiderivative (low CPU)", true, settings.antialiasing == tonix::Antialiasing::Adaa, [change]
+                          { change ([] (auto& s) { s.antialiasing = tonix::Antialiasing::Adaa; }); });
+
+    PopupMenu saturator;
+    saturator.addItem ("Polynomial", true, settings.saturatorTier == tonix::SaturatorTier::Polynomial, [change]
+                       { change ([] (auto& s) { s.saturatorTier = tonix::SaturatorTier::Polynomial; }); });
+    saturator.addItem ("Lookup Table (lower CPU)", true, settings.saturatorTier == tonix::SaturatorTier::Table, [change]
+                       { change ([] (auto& s) { s.saturatorTier = tonix::SaturatorTier::Table; }); });
+
+    PopupMenu realtime, offline;
+    for (int factor = 1; factor <= 1 << tonix::Oversampler::kMaxFactorLog2; factor *= 2)
+    {
+        const auto name = factor == 1 ? String ("Off") : String (factor) + "x";
+        realtime.addItem (name, true, settings.oversampling == factor, [change, factor]
+                          { change ([factor] (auto& s) { s.oversampling = factor; }); });
+        offline.addItem (name, true, settings.offlineOversampling == factor, [change, factor]
+                         { change ([factor] (auto& s) { s.offlineOversampling = factor; }); });
+    }
+
+    PopupMenu filter;
+    filter.addItem ("Linear Phase", true, settings.oversamplingPhase == tonix::OversamplingPhase::Linear, [change]
+                    { change ([] (auto& s) { s.oversamplingPhase = tonix::OversamplingPhase::Linear; }); });
+    filter.addItem ("Minimum Phase (lower latency)", true, settings.oversamplingPhase == tonix::OversamplingPhase::Minimum, [change]
+                    { change ([] (auto& s) { s.oversamplingPhase = tonix::OversamplingPhase::Minimum; }); });
+
+    PopupMenu internalRate;
+    internalRate.addItem ("Session Rate", true, settings.internalRate == tonix::InternalRate::Host, [change]
+                          { change ([] (auto& s) { s.internalRate = tonix::InternalRate::Host; }); });
+    internalRate.addItem ("44.1 / 48 kHz (lower CPU)", true, settings.internalRate == tonix::InternalRate::Single, [change]
+                          { change ([] (auto& s) { s.internalRate = tonix::InternalRate::Single; }); });
+    internalRate.addItem ("88.2 / 96 kHz", true, settings.internalRate == tonix::InternalRate::Double, [change]
+                          { change ([] (auto& s) { s.internalRate = tonix::InternalRate::Double; }); });
+
+    PopupMenu menu;
+    menu.addSubMenu ("Processing Precision", precision);
+    menu.addSubMenu ("Internal Sample Rate", internalRate);
+    menu.addSubMenu ("Saturator", saturator);
+    menu.addSeparator();
+    menu.addSubMenu ("Anti-aliasing", antialiasing);
+    menu.addSubMenu ("Oversampling", realtime);
+    menu.addSubMenu ("Oversampling (Offline Render)", offline);
+    menu.addSubMenu ("Oversampling Filter", filter);
+    menu.addSeparator();
+    menu.addItem ("Reduce Quality Under CPU Load", true, settings.cpuGovernor, [change, enabled = settings.cpuGovernor]
+                  { change ([enabled] (auto& s) { s.cpuGovernor = ! enabled; }); });
+    menu.addItem ("Spread Channels Across CPU Cores", true, settings.multicore, [change, enabled = settings.multicore]
+                  { change ([enabled] (auto& s) { s.multicore = ! enabled; }); });
+    menu.addSeparator();
+    menu.addItem ("Reset CPU Load Statistics", [&p = processorRef]
+                  { p.resetLoadMeter(); });
+    menu.addItem ("Save CPU Load Report...", [this]
+                  {
+                      // every instance in the process, to find the one behind dropouts
+                      m_reportChooser = std::make_unique<FileChooser> ("Save CPU Load Report", File::getSpecialLocation (File::userDesktopDirectory).getChildFile ("Tonix CPU Load.txt"), "*.txt");
+                      m_reportChooser->launchAsync (FileBrowserComponent::saveMode | FileBrowserComponent::canSelectFiles | FileBrowserComponent::warnAboutOverwriting, [] (const FileChooser& chooser)
+                                                    {
+                                                        const auto file = chooser.getResult();
+                                                        if (file != File())
+                                                            file.replaceWithText (TonixProcessor::getLoadReport());
+                                                    });
+                  });
+    menu.showMenuAsync (PopupMenu::Options().withTargetComponent (m_optionsButton));
+}
+
 void TonixEditor::paint (juce::Graphics& g)
 {
+    TONIX_TRACE_SCOPE ("editor paint");
     const auto gf = ColourGradient::vertical (Colours::darkgrey, 0, Colours::grey, static_cast<float> (getHeight()));
     g.setGradientFill (gf);
     g.fillAll();
@@ -156,6 +291,8 @@ void TonixEditor::resized()
         m_pluginDesc.setBounds (topArea.removeFromLeft (100));
         m_redoButton.setBounds (topArea.removeFromRight (40).reduced (0, pad));
         m_undoButton.setBounds (topArea.removeFromRight (40).reduced (0, pad));
+        m_optionsButton.setBounds (topArea.removeFromRight (60).reduced (0, pad));
+        m_loadMeter.setBounds (topArea.removeFromRight (170).reduced (pad, pad + 2));
     }
     {
         auto labelsArea = bounds.removeFromTop (40);
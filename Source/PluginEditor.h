@@ -29,6 +29,22 @@ public:
     }
 };
 
+// the instance's recent CPU load against the block deadline; a click resets its statistics
+class TonixLoadMeter final : public juce::Component,
+                             private juce::Timer
+{
+public:
+    explicit TonixLoadMeter (TonixProcessor&);
+    void paint (juce::Graphics&) override;
+    void mouseDown (const juce::MouseEvent&) override;
+
+private:
+    void timerCallback() override;
+
+    TonixProcessor& m_processor;
+    tonix::LoadMeter::Stats m_recent {}, m_total {};
+};
+
 class TonixEditor final : public juce::AudioProcessorEditor
 {
 public:
@@ -38,7 +54,9 @@ public:
     void resized() override;
 
 private:
-    juce::TextButton m_bypassButton, m_autoGainButton, m_undoButton, m_redoButton;
+    void showOptionsMenu();
+
+    juce::TextButton m_bypassButton, m_autoGainButton, m_undoButton, m_redoButton, m_optionsButton;
     juce::Label m_pluginName, m_pluginDesc, m_buildDetails;
 
     struct SliderLabels
@@ -60,6 +78,8 @@ private:
     TonixTextButtonStyle m_textButtonStyle;
     TonixKnobStyle m_knobStyle;
     TonixProcessor& processorRef;
+    TonixLoadMeter m_loadMeter;
+    std::unique_ptr<juce::FileChooser> m_reportChooser;
     std::unique_ptr<GenericListener> m_bypassNotifier, m_undoNotifier;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TonixEditor)
@@ -4,6 +4,39 @@
 using namespace juce;
 
 constexpr auto kParamVersion = 1;
+constexpr const char* kParameterIDs[] = { "inputTrim", "process", "outputTrim", "brightness", "type", "bypass", "autoGain" };
+// engine settings, stored on apvts.state
+constexpr const char* kPrecisionProperty = "precision";
+constexpr const char* kAntialiasingProperty = "antialiasing";
+constexpr const char* kSaturatorTierProperty = "saturator";
+constexpr const char* kOversamplingProperty = "oversampling";
+constexpr const char* kOfflineOversamplingProperty = "offlineOversampling";
+constexpr const char* kOversamplingPhaseProperty = "oversamplingPhase";
+constexpr const char* kInternalRateProperty = "internalRate";
+constexpr const char* kCpuGovernorProperty = "cpuGovernor";
+constexpr const char* kMulticoreProperty = "multicore";
+
+// a float parameter CLAP hosts can modulate, see handleDirectEvent()
+class ModulatableParameter final : public AudioParameterFloat,
+                                   public clap_juce_extensions::clap_juce_parameter_capabilities
+{
+public:
+    using AudioParameterFloat::AudioParameterFloat;
+
+    bool supportsMonophonicModulation() override { return true; }
+};
+
+// every instance in the process, for the load report
+static CriticalSection instancesLock;
+static Array<TonixProcessor*> instances;
+static std::atomic<int> numInstancesCreated { 0 };
+
+static int getOversamplingFactor (const var& value)
+{
+    // anything that isn't a supported power of two means off
+    const int factor = value;
+    return factor >= 1 && isPowerOfTwo (factor) && factor <= 1 << tonix::Oversampler::kMaxFactorLog2 ? factor : 1;
+}
 
 TonixProcessor::TonixProcessor()
     : AudioProcessor (BusesProperties()
@@ -14,20 +47,47 @@ TonixProcessor::TonixProcessor()
                           .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
 #endif
                           ),
-      apvts (*this, &undoManager, "parameters", { std::make_unique<AudioParameterFloat> (ParameterID { "inputTrim", kParamVersion }, "Input Trim", NormalisableRange<float> (-10.0f, 10.0f, 0.1f), 0.0f, AudioParameterFloatAttributes().withLabel ("dB")), std::make_unique<AudioParameterFloat> (ParameterID { "process", kParamVersion }, "Process", NormalisableRange<float> (0.0f, 100.0f, 0.1f), 0.0f, AudioParameterFloatAttributes().withLabel ("%")), std::make_unique<AudioParameterFloat> (ParameterID { "outputTrim", kParamVersion }, "Output Trim Trim", NormalisableRange<float> (-6.0f, 6.0f, 0.01f), 0.0f, AudioParameterFloatAttributes().withLabel ("dB")), std::make_unique<AudioParameterChoice> (ParameterID { "brightness", kParamVersion }, "Brightness", StringArray { "Opal", "Gold", "Sapphire" }, 1), std::make_unique<AudioParameterChoice> (ParameterID { "type", kParamVersion }, "Type", StringArray { "Luminiscent", "Iridescent", "Radiant", "Luster", "Dark Essence" }, 1), std::make_unique<AudioParameterBool> (ParameterID { "bypass", kParamVersion }, "Bypass", false), std::make_unique<AudioParameterBool> (ParameterID { "autoGain", kParamVersion }, "Auto-Gain", true) })
+      apvts (*this, &undoManager, "parameters", { std::make_unique<ModulatableParameter> (ParameterID { "inputTrim", kParamVersion }, "Input Trim", NormalisableRange<float> (-10.0f, 10.0f, 0.1f), 0.0f, AudioParameterFloatAttributes().withLabel ("dB")), std::make_unique<ModulatableParameter> (ParameterID { "process", kParamVersion }, "Process", NormalisableRange<float> (0.0f, 100.0f, 0.1f), 0.0f, AudioParameterFloatAttributes().withLabel ("%")), std::make_unique<ModulatableParameter> (ParameterID { "outputTrim", kParamVersion }, "Output Trim Trim", NormalisableRange<float> (-6.0f, 6.0f, 0.01f), 0.0f, AudioParameterFloatAttributes().withLabel ("dB")), std::make_unique<AudioParameterChoice> (ParameterID { "brightness", kParamVersion }, "Brightness", StringArray { "Opal", "Gold", "Sapphire" }, 1), std::make_unique<AudioParameterChoice> (ParameterID { "type", kParamVersion }, "Type", StringArray { "Luminiscent", "Iridescent", "Radiant", "Luster", "Dark Essence" }, 1), std::make_unique<AudioParameterBool> (ParameterID { "bypass", kParamVersion }, "Bypass", false), std::make_unique<AudioParameterBool> (ParameterID { "autoGain", kParamVersion }, "Auto-Gain", true) }),
+      m_instanceNumber (++numInstancesCreated)
 {
     reset();
     m_params.inputTrim = apvts.getRawParameterValue ("inputTrim");
     m_params.process = apvts.getRawParameterValue ("process");
     m_params.outputTrim = apvts.getRawParameterValue ("outputTrim");
-    m_params.brightness = apvts.getParameterAsValue ("brightness");
+    m_params.brightness = apvts.getRawParameterValue ("brightness");
     m_params.autoGain = apvts.getRawParameterValue ("autoGain");
-    m_params.type = apvts.getParameterAsValue ("type");
+    m_params.type = apvts.getRawParameterValue ("type");
     m_params.bypass = apvts.getRawParameterValue ("bypass");
+
+    static_assert (std::size (kParameterIDs) == kNumParameters);
+    for (size_t i = 0; i < kNumParameters; ++i)
+    {
+        m_parameters[i] = apvts.getParameter (kParameterIDs[i]);
+        // clap-juce-extensions derives the CLAP id from the JUCE one like the VST3 wrapper
+        m_clapIds[i] = static_cast<clap_id> (String (kParameterIDs[i]).hashCode());
+    }
+
+    for (auto* id : kParameterIDs)
+        apvts.addParameterListener (id, this);
+    loadEngineSettings();
+    startTimerHz (4);
+    // the trace covers the instances alive at any time, see DSP/Trace.h
+    TONIX_TRACE_START();
+
+    const ScopedLock lock (instancesLock);
+    instances.add (this);
 }
 
 TonixProcessor::~TonixProcessor()
 {
+    {
+        const ScopedLock lock (instancesLock);
+        instances.removeFirstMatchingValue (this);
+    }
+    stopTimer();
+    for (auto* id : kParameterIDs)
+        apvts.removeParameterListener (id, this);
+    TONIX_TRACE_STOP();
 }
 
 const juce::String TonixProcessor::getName() const
@@ -64,7 +124,8 @@ bool TonixProcessor::isMidiEffect() const
 
 double TonixProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    // set by prepareEngine(), which hosts call again after the settings change it
+    return m_prepared ? m_engine.getTailLength() / getSampleRate() : 0.0;
 }
 
 int TonixProcessor::getNumPrograms()
@@ -96,305 +157,338 @@ void TonixProcessor::changeProgramName (int index, const juce::String& newName)
 
 void TonixProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    juce::ignoreUnused (samplesPerBlock);
+    TONIX_TRACE_SCOPE ("prepareToPlay");
     jassert (getTotalNumInputChannels() == getTotalNumOutputChannels());
-    const auto maxChannels = static_cast<size_t> (std::max (getTotalNumInputChannels(), getTotalNumOutputChannels()));
-    m_processors.clear();
-    m_processors = std::vector<Channel> (maxChannels);
+    prepareEngine (getEngineSettings(), sampleRate, samplesPerBlock);
+    m_prepared = true;
+    DBG ("DSP kernels: " << tonix::getIsaName (m_engine.getEngine().getChannels().getIsa()));
+}
 
-    for (auto& p : m_processors)
-    {
-        p.reset();
-        // original has fixed scaling depending on sample rate: {1.0, 0.5, 0.25}
-        p.srScale = 1.0 / floor (sampleRate / 44100.0);
-    }
+void TonixProcessor::prepareEngine (const EngineSettings& settings, double sampleRate, int maxBlockSize)
+{
+    const auto maxChannels = std::max (getTotalNumInputChannels(), getTotalNumOutputChannels());
+    // hosts switch to non-realtime before preparing a bounce
+    const auto factor = isNonRealtime() ? settings.offlineOversampling : settings.oversampling;
+    // offline renders have no deadline
+    m_useGovernor = settings.cpuGovernor && ! isNonRealtime();
+    // the pool's threads start with the first instance that asks for them
+    m_multicore = settings.multicore;
+    auto* pool = m_multicore ? &tonix::getWorkerPool() : nullptr;
+    const auto numSlices = tonix::ParallelEngine::getNumSlices (maxChannels, pool);
+    // so playback starts at the current values instead of gliding to them
+    updateParameterSnapshot();
+    m_engine.prepare (maxChannels, sampleRate, maxBlockSize, roundToInt (std::log2 (factor)), settings.oversamplingPhase, settings.internalRate, m_useGovernor, numSlices, pool);
+    m_engine.reset();
+    m_governor.prepare ({});
+    // the old configuration's blocks would skew the new one's statistics
+    m_loadMeter.reset();
+    // minimum phase has no whole-sample delay, its DC delay is the closest match
+    setLatencySamples (roundToInt (m_engine.getLatency()));
+    // new channels need their coefficients
+    m_paramsDirty.store (true, std::memory_order_release);
 }
 
 void TonixProcessor::reset()
 {
-    for (auto& ch : m_processors)
-        ch.reset();
+    m_engine.reset();
 }
 
-void TonixProcessor::Channel::reset()
+void TonixProcessor::releaseResources()
 {
-    processing = 0.0;
-    curProcessing = 0.0;
-    y = 0.0;
-    s = 0.0;
-    prev_x = 0.0;
-    autoGainComp = 1.0f;
-
-    saturator.reset();
+    m_prepared = false;
 }
 
-double TonixProcessor::Channel::process (double x)
+bool TonixProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
 {
-    curProcessing = processing * a3;
-    x1 = hpf_k * x + (x - prev_x);
-    x2 = x1 * f1 + x1;
-    x3 = (! g0) ? x : x2;
-    x4 = (type == Type::Luster) ? saturator.process (x2 * curProcessing) : saturator.process (x2);
-    x5 = saturator.process (x4 * curProcessing * p20 + x3);
+    if (layouts.inputBuses.size() != 1 || layouts.outputBuses.size() != 1)
+        return false;
+    if (layouts.getNumChannels (true, 0) != layouts.getNumChannels (false, 0))
+        return false;
+    // only allow symmetrical I/Os
+    return true;
+}
 
-    prev_x = x;
+void TonixProcessor::parameterChanged (const juce::String&, float)
+{
+    m_paramsDirty.store (true, std::memory_order_release);
+}
 
-    s += (x5 - s) * lpf_k;
+void TonixProcessor::updateParameterSnapshot()
+{
+    TONIX_TRACE_SCOPE ("parameters");
+    // CLAP modulation moves the value without touching the parameter
+    const auto modulated = [this] (size_t index, const std::atomic<float>& value)
+    {
+        const auto modulation = m_modulation[index];
+        if (modulation == 0.0f)
+            return value.load();
+        const auto& range = m_parameters[index]->getNormalisableRange();
+        return range.convertFrom0to1 (jlimit (0.0f, 1.0f, range.convertTo0to1 (value.load()) + modulation));
+    };
+    m_snapshot.inputTrim = modulated (0, *m_params.inputTrim);
+    m_snapshot.process = modulated (1, *m_params.process);
+    m_snapshot.outputTrim = modulated (2, *m_params.outputTrim);
+    m_snapshot.type = static_cast<tonix::Type> (juce::jlimit (0, (int) tonix::kNumTypes - 1, juce::roundToInt (m_params.type->load())));
+    m_snapshot.brightness = static_cast<tonix::Brightness> (juce::jlimit (0, (int) tonix::kNumBrightness - 1, juce::roundToInt (m_params.brightness->load())));
+    m_snapshot.autoGain = m_params.autoGain->load() > 0.5f;
+    m_snapshot.bypass = m_params.bypass->load() > 0.5f;
+
+    inputGain = Decibels::decibelsToGain (m_snapshot.inputTrim);
+    outputGain = Decibels::decibelsToGain (m_snapshot.outputTrim);
+
+    m_engine.setBypassed (m_snapshot.bypass || m_hostBypassed);
+    m_engine.setMode (m_snapshot.type, m_snapshot.brightness);
+    m_engine.setProcessing (m_snapshot.process / 100.0);
+    m_engine.setAutoGain (m_snapshot.autoGain);
+
+    // the configured quality, the governor's level applies on top
+    m_snapshot.precision = m_precision.load (std::memory_order_relaxed);
+    m_engine.setPrecision (m_snapshot.precision);
+    m_snapshot.antialiasing = m_antialiasing.load (std::memory_order_relaxed);
+    m_engine.setAntialiasing (m_snapshot.antialiasing);
+    m_snapshot.saturatorTier = m_saturatorTier.load (std::memory_order_relaxed);
+    m_engine.setSaturatorTier (m_snapshot.saturatorTier);
+}
 
-    y = curProcessing * (s - x * p24);
+TonixProcessor::EngineSettings TonixProcessor::getEngineSettings() const
+{
+    EngineSettings settings;
+    settings.precision = apvts.state.getProperty (kPrecisionProperty).toString() == "float" ? tonix::Precision::Float : tonix::Precision::Double;
+    settings.antialiasing = apvts.state.getProperty (kAntialiasingProperty).toString() == "adaa" ? tonix::Antialiasing::Adaa : tonix::Antialiasing::Off;
+    settings.saturatorTier = apvts.state.getProperty (kSaturatorTierProperty).toString() == "table" ? tonix::SaturatorTier::Table : tonix::SaturatorTier::Polynomial;
+    settings.oversampling = getOversamplingFactor (apvts.state.getProperty (kOversamplingProperty, 1));
+    settings.offlineOversampling = getOversamplingFactor (apvts.state.getProperty (kOfflineOversamplingProperty, 1));
+    settings.oversamplingPhase = apvts.state.getProperty (kOversamplingPhaseProperty).toString() == "minimum" ? tonix::OversamplingPhase::Minimum : tonix::OversamplingPhase::Linear;
+    const auto internalRate = apvts.state.getProperty (kInternalRateProperty).toString();
+    settings.internalRate = internalRate == "single" ? tonix::InternalRate::Single : internalRate == "double" ? tonix::InternalRate::Double : tonix::InternalRate::Host;
+    settings.cpuGovernor = apvts.state.getProperty (kCpuGovernorProperty, false);
+    settings.multicore = apvts.state.getProperty (kMulticoreProperty, false);
+    return settings;
+}
 
-    if (type == Type::Luster)
-        y *= 0.5;
+void TonixProcessor::setEngineSettings (const EngineSettings& settings)
+{
+    // not undoable, like a host preference
+    apvts.state.setProperty (kPrecisionProperty, settings.precision == tonix::Precision::Float ? "float" : "double", nullptr);
+    apvts.state.setProperty (kAntialiasingProperty, settings.antialiasing == tonix::Antialiasing::Adaa ? "adaa" : "off", nullptr);
+    apvts.state.setProperty (kSaturatorTierProperty, settings.saturatorTier == tonix::SaturatorTier::Table ? "table" : "polynomial", nullptr);
+    apvts.state.setProperty (kOversamplingProperty, settings.oversampling, nullptr);
+    apvts.state.setProperty (kOfflineOversamplingProperty, settings.offlineOversampling, nullptr);
+    apvts.state.setProperty (kOversamplingPhaseProperty, settings.oversamplingPhase == tonix::OversamplingPhase::Minimum ? "minimum" : "linear", nullptr);
+    apvts.state.setProperty (kInternalRateProperty, settings.internalRate == tonix::InternalRate::Single ? "single" : settings.internalRate == tonix::InternalRate::Double ? "double" : "host", nullptr);
+    apvts.state.setProperty (kCpuGovernorProperty, settings.cpuGovernor, nullptr);
+    apvts.state.setProperty (kMulticoreProperty, settings.multicore, nullptr);
+    loadEngineSettings();
+}
 
-    y += x;
-    if (useAutoGain)
-        y *= autoGain;
+void TonixProcessor::loadEngineSettings()
+{
+    const auto settings = getEngineSettings();
+    m_precision.store (settings.precision, std::memory_order_relaxed);
+    m_antialiasing.store (settings.antialiasing, std::memory_order_relaxed);
+    m_saturatorTier.store (settings.saturatorTier, std::memory_order_relaxed);
+    m_paramsDirty.store (true, std::memory_order_release);
+
+    // a different oversampler, core rate or set of fallbacks means new buffers and
+    // latency, so the audio thread waits
+    if (! m_prepared)
+        return;
+    const auto factor = isNonRealtime() ? settings.offlineOversampling : settings.oversampling;
+    const auto useGovernor = settings.cpuGovernor && ! isNonRealtime();
+    if (1 << m_engine.getOversamplingLog2() == factor && (factor == 1 || m_engine.getOversamplingPhase() == settings.oversamplingPhase) && m_engine.getInternalRate() == settings.internalRate && m_useGovernor == useGovernor && m_multicore == settings.multicore)
+        return;
+    const ScopedLock lock (getCallbackLock());
+    prepareEngine (settings, getSampleRate(), getBlockSize());
+}
 
-    return y;
+bool TonixProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
 }
 
-void TonixProcessor::Saturator::reset()
+void TonixProcessor::processBlock (AudioBuffer<float>& buffer,
+                                   MidiBuffer&)
 {
-    x2 = x4 = x6 = x8 = 0.0;
+    setHostBypassed (false);
+    processSamples (buffer);
 }
 
-double TonixProcessor::Saturator::process (double x)
+void TonixProcessor::processBlock (AudioBuffer<double>& buffer,
+                                   MidiBuffer&)
 {
-    double y = 0.0;
-    // polynomial approximation instead of table lookup
-    switch (type)
-    {
-        case 0:
-        {
-            // hard clip
-            x = std::max (-1.0, std::min (x, 1.0));
-            x2 = x * x;
-            x4 = x2 * x2;
-            x6 = x4 * x2;
-            x8 = x4 * x4;
-
-            y = x * 2.827568855 + x2 * 0.0003903798913 + x2 * x * -4.17220229 + x4 * -0.0001107320401 + x4 * x * 0.523459874 + x6 * 0.0002768079893 + x6 * x * -0.423546883 + x8 * -0.001448632 + x8 * x * 3.224580615 + x8 * x2 * 0.002728704 + x8 * x2 * x * -5.495344862 + x8 * x4 * -0.002846356 + x8 * x4 * x * 5.449768693 + x8 * x6 * 0.001310366 + x8 * x6 * x * -2.414078731;
-        }
-        break;
-        case 1:
-        {
-            // hard clip
-            x = std::max (-0.991184403, std::min (x, 0.990821248));
-            x2 = x * x;
-            x4 = x2 * x2;
-            x6 = x4 * x2;
-            x8 = x4 * x4;
-
-            y = x * 1.501040337 + x2 * -0.0002757478168 + x2 * x * -0.301802438 + x4 * 0.003273802 + x4 * x * 1.786333688 + x6 * -0.046104732 + x6 * x * -24.582679252 + x8 * 0.110553367 + x8 * x * 41.112226106 + x8 * x2 * -0.092987632 + x8 * x2 * x * -16.724196818 + x8 * x4 * 0.01857341 + x8 * x4 * x * -9.331919223 + x8 * x6 * 0.006696015 + x8 * x6 * x * 6.543207186;
-        }
-        break;
-        case 2:
-        {
-            // hard clip
-            x = std::max (-0.991022224, std::min (x, 0.990984424));
-            x2 = x * x;
-            x4 = x2 * x2;
-            x6 = x4 * x2;
-            x8 = x4 * x4;
-
-            y = x * 2.063930806 + x2 * 0.0002008141989 + x2 * x * -0.414990906 + x4 * -0.003741183 + x4 * x * 2.456380956 + x6 * 0.03108163 + x6 * x * -33.802027499 + x8 * -0.092816819 + x8 * x * 56.531406839 + x8 * x2 * 0.134928028 + x8 * x2 * x * -22.998647073 + x8 * x4 * -0.098216457 + x8 * x4 * x * -12.829323005 + x8 * x6 * 0.028676158 + x8 * x6 * x * 8.996306767;
-        }
-        break;
-        default:
-            jassertfalse;
-    }
-    return y;
+    setHostBypassed (false);
+    processSamples (buffer);
 }
 
-void TonixProcessor::releaseResources()
+void TonixProcessor::processBlockBypassed (AudioBuffer<float>& buffer,
+                                           MidiBuffer&)
 {
+    setHostBypassed (true);
+    processSamples (buffer);
 }
 
-bool TonixProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
+void TonixProcessor::processBlockBypassed (AudioBuffer<double>& buffer,
+                                           MidiBuffer&)
 {
-    if (layouts.inputBuses.size() != 1 || layouts.outputBuses.size() != 1)
-        return false;
-    if (layouts.getNumChannels (true, 0) != layouts.getNumChannels (false, 0))
-        return false;
-    // only allow symmetrical I/Os
-    return true;
+    setHostBypassed (true);
+    processSamples (buffer);
 }
 
-void TonixProcessor::Channel::setProcessing (const double amount)
+void TonixProcessor::setHostBypassed (bool shouldBeBypassed)
 {
-    processing = amount;
-    // simple auto-gain compensation
-    autoGain = 1.0 + processing * autoGain_a1 + processing * processing * autoGain_a2;
+    if (shouldBeBypassed == m_hostBypassed)
+        return;
+    m_hostBypassed = shouldBeBypassed;
+    m_engine.setBypassed (m_snapshot.bypass || m_hostBypassed);
 }
 
-void TonixProcessor::Channel::setMode (Type t, Brightness b)
+template <typename SampleType>
+void TonixProcessor::processSamples (AudioBuffer<SampleType>& buffer)
 {
-    brightness = b;
-    type = t;
-    switch (type)
+    juce::ScopedNoDenormals noDenormals;
+    TONIX_TRACE_SCOPE_VALUE ("processBlock", buffer.getNumSamples());
+
+    const auto start = Time::getHighResolutionTicks();
+    // CLAP events split the block where they land; other formats only change parameters
+    // between blocks, which the engine's smoothing spreads out
+    const auto numSamples = buffer.getNumSamples();
+    const auto eventOffset = [this, numSamples] (int e)
     {
-        case Type::Luminiscent:
-        {
-            switch (brightness)
-            {
-                case Brightness::Opal:
-                    hpf_k = 0.625;
-                    lpf_k = 0.1875;
-                    break;
-                case Brightness::Gold:
-                    hpf_k = 0.4375;
-                    lpf_k = 0.3125;
-                    break;
-                case Brightness::Sapphire:
-                    hpf_k = 0.1875;
-                    lpf_k = 0.375;
-                    break;
-            }
-            a3 = 0.25;
-            f1 = 0.75;
-            p20 = 0.3125;
-            p24 = 0.0625;
-            g0 = 1;
-            saturator.type = 0;
-            autoGain_a1 = -0.416;
-            autoGain_a2 = 0.092;
-        }
-        break;
-        case Type::Iridescent:
-        {
-            switch (brightness)
-            {
-                case Brightness::Opal:
-                    hpf_k = 0.625;
-                    lpf_k = 0.1875;
-                    break;
-                case Brightness::Gold:
-                    hpf_k = 0.375;
-                    lpf_k = 0.3125;
-                    break;
-                case Brightness::Sapphire:
-                    hpf_k = 0.3125;
-                    lpf_k = 0.5;
-                    break;
-            }
-            a3 = 0.25;
-            f1 = 0.875;
-            p20 = 0.3125;
-            p24 = 0.0625;
-            g0 = 1;
-            saturator.type = 0;
-            autoGain_a1 = -0.393;
-            autoGain_a2 = 0.082;
-        }
-        break;
-        case Type::Radiant:
-        {
-            switch (brightness)
-            {
-                case Brightness::Opal:
-                    hpf_k = 0.75;
-                    lpf_k = 0.125;
-                    break;
-                case Brightness::Gold:
-                    hpf_k = 0.45629901;
-                    lpf_k = 0.375;
-                    break;
-                case Brightness::Sapphire:
-                    hpf_k = 0.375;
-                    lpf_k = 0.5;
-                    break;
-            }
-            a3 = 0.375;
-            f1 = 0.75;
-            p20 = 0.1875;
-            p24 = 0.0125;
-            g0 = 0;
-            saturator.type = 1;
-            autoGain_a1 = -0.441;
-            autoGain_a2 = 0.103;
-        }
-        case Type::Luster:
+        return std::min (m_parameterEvents[static_cast<size_t> (e)].sampleOffset, numSamples);
+    };
+    int offset = 0;
+    for (int e = 0; offset < numSamples || e < m_numParameterEvents;)
+    {
+        for (; e < m_numParameterEvents && eventOffset (e) <= offset; ++e)
+            applyParameterEvent (m_parameterEvents[static_cast<size_t> (e)]);
+        const auto end = e < m_numParameterEvents ? eventOffset (e) : numSamples;
+        if (end - offset == numSamples && numSamples > 0)
         {
-            switch (brightness)
-            {
-                case Brightness::Opal:
-                    hpf_k = 0.75;
-                    lpf_k = 0.125;
-                    break;
-                case Brightness::Gold:
-                    hpf_k = 0.45629901;
-                    lpf_k = 0.375;
-                    break;
-                case Brightness::Sapphire:
-                    hpf_k = 0.375;
-                    lpf_k = 0.5625;
-                    break;
-            }
-            a3 = 1.0;
-            f1 = 0.6875;
-            p20 = 0.27343899;
-            p24 = 0.1171875;
-            g0 = 0;
-            saturator.type = 2;
-            autoGain_a1 = -0.712;
-            autoGain_a2 = 0.172;
+            // no events inside the block
+            processPart (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), numSamples);
         }
-        case Type::DarkEssence:
+        else if (end > offset)
         {
-            switch (brightness)
-            {
-                case Brightness::Opal:
-                    hpf_k = 0.75;
-                    lpf_k = 0.125;
-                    break;
-                case Brightness::Gold:
-                    hpf_k = 0.45629901;
-                    lpf_k = 0.375;
-                    break;
-                case Brightness::Sapphire:
-                    hpf_k = 0.375;
-                    lpf_k = 0.5625;
-                    break;
-            }
-            a3 = 0.375;
-            f1 = 0.75;
-            p20 = 0.5625;
-            p24 = 0.0125;
-            g0 = 0;
-            saturator.type = 2;
-            autoGain_a1 = -0.636;
-            autoGain_a2 = 0.17;
+            // refers to the block's channels, preallocated up to 32 of them
+            AudioBuffer<SampleType> part (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), offset, end - offset);
+            processPart (part.getArrayOfWritePointers(), part.getNumChannels(), part.getNumSamples());
         }
+        offset = end;
     }
-    // sample-rate scale
-    hpf_k *= srScale;
-    lpf_k *= srScale;
+    m_numParameterEvents = 0;
+    if (numSamples == 0)
+        return;
+
+    TONIX_TRACE_SCOPE ("load statistics");
+    // the meter takes every block, it answers what the instance costs whatever it does
+    const auto processingSeconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - start);
+    const auto blockSeconds = numSamples / getSampleRate();
+    m_loadMeter.record (processingSeconds, blockSeconds);
+
+    // bypassed blocks say nothing about the load; both paths run during a crossfade,
+    // that cost passes; nothing runs while asleep
+    if (! m_useGovernor || m_engine.isBypassed() || m_engine.isChangingQuality() || m_engine.isAsleep())
+        return;
+
+    const auto from = m_engine.getQualityLevel();
+    const auto to = m_governor.update (processingSeconds, blockSeconds, m_engine.getNumQualityLevels());
+    if (to == from)
+        return;
+    m_engine.setQualityLevel (to);
+
+    // dropped if the message thread falls that far behind
+    const auto scope = m_qualityChangeFifo.write (1);
+    if (scope.blockSize1 > 0)
+        m_qualityChanges[static_cast<size_t> (scope.startIndex1)] = { from, to, processingSeconds / blockSeconds, m_engine.getQuality (to) };
 }
 
-void TonixProcessor::processBlock (AudioBuffer<float>& buffer,
-                                   MidiBuffer&)
+template <typename SampleType>
+void TonixProcessor::processPart (SampleType* const* channels, int numChannels, int numSamples)
 {
-    juce::ScopedNoDenormals noDenormals;
+    // coefficients are only recomputed when a parameter changed since the last part; the
+    // plain load keeps the usual case from writing the flag's cache line
+    if (m_paramsDirty.load (std::memory_order_relaxed) && m_paramsDirty.exchange (false, std::memory_order_acquire))
+        updateParameterSnapshot();
+    m_engine.process (channels, numChannels, numSamples, inputGain, outputGain);
+}
 
-    // bypass
-    if (m_params.bypass->load() > 0.5)
+bool TonixProcessor::supportsDirectEvent (uint16_t spaceId, uint16_t type)
+{
+    return spaceId == CLAP_CORE_EVENT_SPACE_ID && (type == CLAP_EVENT_PARAM_VALUE || type == CLAP_EVENT_PARAM_MOD);
+}
+
+void TonixProcessor::handleDirectEvent (const clap_event_header_t* event, int sampleOffset)
+{
+    clap_id id;
+    ParameterEvent parameterEvent { std::max (0, sampleOffset), 0, false, 0.0f };
+    if (event->type == CLAP_EVENT_PARAM_VALUE)
+    {
+        const auto* value = reinterpret_cast<const clap_event_param_value*> (event);
+        id = value->param_id;
+        parameterEvent.value = static_cast<float> (value->value);
+    }
+    else if (event->type == CLAP_EVENT_PARAM_MOD)
+    {
+        const auto* mod = reinterpret_cast<const clap_event_param_mod*> (event);
+        // the chain has no voices, only modulation of the whole instance applies
+        if (mod->note_id != -1 || mod->port_index != -1 || mod->channel != -1 || mod->key != -1)
+            return;
+        id = mod->param_id;
+        parameterEvent.modulation = true;
+        parameterEvent.value = static_cast<float> (mod->amount);
+    }
+    else
+    {
         return;
+    }
 
-    inputGain = Decibels::decibelsToGain (m_params.inputTrim->load());
-    outputGain = Decibels::decibelsToGain (m_params.outputTrim->load());
+    const auto found = std::find (m_clapIds.begin(), m_clapIds.end(), id);
+    if (found == m_clapIds.end())
+        return;
+    parameterEvent.parameter = static_cast<size_t> (found - m_clapIds.begin());
 
-    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+    // past that many, events apply from the start of the block
+    if (m_numParameterEvents == kMaxParameterEvents)
     {
-        auto& processor = m_processors[(size_t) channel];
-        processor.setMode ((Channel::Type) static_cast<int> (m_params.type.getValue()), (Channel::Brightness) static_cast<int> (m_params.brightness.getValue()));
-        processor.setProcessing (m_params.process->load() / 100.0);
-        processor.useAutoGain = (m_params.process->load() > 0.5f);
+        applyParameterEvent (parameterEvent);
+        return;
+    }
+    m_parameterEvents[static_cast<size_t> (m_numParameterEvents++)] = parameterEvent;
+}
+
+void TonixProcessor::applyParameterEvent (const ParameterEvent& event)
+{
+    if (event.modulation)
+    {
+        m_modulation[event.parameter] = event.value;
+        m_paramsDirty.store (true, std::memory_order_release);
+        return;
+    }
 
-        auto chData = buffer.getWritePointer (channel);
-        for (auto i = 0; i < buffer.getNumSamples(); ++i)
+    // as a host sets it: the listeners, including parameterChanged(), hear about it
+    auto& parameter = static_cast<AudioProcessorParameter&> (*m_parameters[event.parameter]);
+    if (parameter.getValue() == event.value)
+        return;
+    TONIX_TRACE_SCOPE ("parameter event");
+    parameter.setValue (event.value);
+    parameter.sendValueChangedMessageToListeners (event.value);
+}
+
+void TonixProcessor::timerCallback()
+{
+    while (m_qualityChangeFifo.getNumReady() > 0)
+    {
+        QualityChange change;
         {
-            chData[i] = static_cast<float> (m_processors[(size_t) channel].process (chData[i] * inputGain) * outputGain);
+            const auto scope = m_qualityChangeFifo.read (1);
+            change = m_qualityChanges[static_cast<size_t> (scope.startIndex1)];
         }
+        String description;
+        description << (change.quality.precision == tonix::Precision::Float ? "32-bit" : "64-bit")
+                    << (change.quality.saturatorTier == tonix::SaturatorTier::Table && change.quality.antialiasing == tonix::Antialiasing::Off ? ", table saturators" : ", polynomial saturators")
+                    << (change.quality.antialiasing == tonix::Antialiasing::Adaa ? ", ADAA" : "")
+                    << ", " << (change.quality.oversamplingLog2 > 0 ? String (1 << change.quality.oversamplingLog2) + "x oversampling" : String ("no oversampling"));
+        Logger::writeToLog ("CPU governor: quality " + String (change.from) + " -> " + String (change.to) + " (load " + String (roundToInt (change.load * 100.0)) + "%): " + description);
     }
 }
 
@@ -413,8 +507,69 @@ juce::AudioProcessorEditor* TonixProcessor::createEditor()
     return new TonixEditor (*this);
 }
 
+void TonixProcessor::updateTrackProperties (const TrackProperties& properties)
+{
+    const ScopedLock lock (m_trackNameLock);
+    m_trackName = properties.name.value_or (String());
+}
+
+String TonixProcessor::getInstanceName() const
+{
+    const ScopedLock lock (m_trackNameLock);
+    return "#" + String (m_instanceNumber) + (m_trackName.isNotEmpty() ? " " + m_trackName : String());
+}
+
+String TonixProcessor::getLoadReport()
+{
+    struct Entry
+    {
+        String name;
+        tonix::LoadMeter::Stats stats;
+        std::array<tonix::LoadMeter::Overrun, tonix::LoadMeter::kNumOverruns> overruns;
+        int numOverruns;
+    };
+    std::vector<Entry> entries;
+    {
+        const ScopedLock lock (instancesLock);
+        for (auto* instance : instances)
+        {
+            auto& entry = entries.emplace_back();
+            entry.name = instance->getInstanceName();
+            entry.stats = instance->m_loadMeter.getStats();
+            entry.numOverruns = instance->m_loadMeter.getOverruns (entry.overruns.data());
+        }
+    }
+    std::sort (entries.begin(), entries.end(), [] (const Entry& a, const Entry& b)
+               { return a.stats.p99 > b.stats.p99; });
+
+    String report;
+    report << "Tonix CPU load, " << Time::getCurrentTime().toString (true, true) << ", " << static_cast<int> (entries.size()) << " instances\n"
+           << "percentages of each block's duration, since the instance was last prepared or reset\n\n"
+           << String::formatted ("%-32s %10s %8s %8s %8s %8s %8s\n", "instance", "blocks", "mean", "p50", "p99", "max", "overruns");
+    for (const auto& entry : entries)
+    {
+        const auto& stats = entry.stats;
+        report << String::formatted ("%-32s %10llu %7.2f%% %7.2f%% %7.2f%% %7.1f%% %8llu\n", entry.name.substring (0, 32).toRawUTF8(), static_cast<unsigned long long> (stats.blocks),
+                                     stats.mean * 100.0, stats.p50 * 100.0, stats.p99 * 100.0, stats.max * 100.0, static_cast<unsigned long long> (stats.overruns));
+    }
+
+    // to line up with the host's dropout log, newest first
+    std::vector<std::pair<tonix::LoadMeter::Overrun, const String*>> overruns;
+    for (const auto& entry : entries)
+        for (int i = 0; i < entry.numOverruns; ++i)
+            overruns.emplace_back (entry.overruns[static_cast<size_t> (i)], &entry.name);
+    std::sort (overruns.begin(), overruns.end(), [] (const auto& a, const auto& b)
+               { return a.first.time > b.first.time; });
+    report << "\nlatest blocks past their deadline\n";
+    for (const auto& [overrun, name] : overruns)
+        report << Time (overrun.time).formatted ("%Y-%m-%d %H:%M:%S.") << String (overrun.time % 1000).paddedLeft ('0', 3) << "  "
+               << String::formatted ("%-32s %7.1f%%\n", name->substring (0, 32).toRawUTF8(), overrun.load * 100.0);
+    return report;
+}
+
 void TonixProcessor::getStateInformation (MemoryBlock& destData)
 {
+    TONIX_TRACE_SCOPE ("getStateInformation");
     // store
     MemoryOutputStream out (destData, false);
     apvts.state.writeToStream (out);
@@ -422,9 +577,11 @@ void TonixProcessor::getStateInformation (MemoryBlock& destData)
 
 void TonixProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
+    TONIX_TRACE_SCOPE ("setStateInformation");
     jassert (sizeInBytes >= 0);
     // restore
     apvts.state = ValueTree::readFromData (data, static_cast<size_t> (sizeInBytes));
+    loadEngineSettings();
 }
 
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
@@ -1,10 +1,19 @@
 #pragma once
 
+#include <clap-juce-extensions/clap-juce-extensions.h>
 #include <juce_audio_processors/juce_audio_processors.h>
 
+#include "DSP/Governor.h"
+#include "DSP/LoadMeter.h"
+#include "DSP/ParallelEngine.h"
+#include "DSP/Trace.h"
+
 #include <span>
 
-class TonixProcessor final : public juce::AudioProcessor
+class TonixProcessor final : public juce::AudioProcessor,
+                             public clap_juce_extensions::clap_juce_audio_processor_capabilities,
+                             private juce::AudioProcessorValueTreeState::Listener,
+                             private juce::Timer
 {
 public:
     TonixProcessor();
@@ -16,10 +25,14 @@ public:
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    // the engine's dry path, delayed by the reported latency, instead of JUCE's untouched buffer
+    void processBlockBypassed (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlockBypassed (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
 
     juce::AudioProcessorParameter* getBypassParameter() const override;
 
-    using AudioProcessor::processBlock;
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override;
 
@@ -41,74 +54,131 @@ public:
 
     void reset() override;
 
+    // CLAP parameter values and modulation, taken over from the wrapper so they land
+    // on their sample instead of the block start
+    bool supportsDirectEvent (uint16_t spaceId, uint16_t type) override;
+    void handleDirectEvent (const clap_event_header_t*, int sampleOffset) override;
+
     juce::AudioProcessorValueTreeState apvts;
     juce::UndoManager undoManager;
 
-private:
-    struct Saturator
+    // Engine options. Not automatable; stored as properties of apvts.state so they are
+    // saved with the session. Set from the message thread.
+    struct EngineSettings
     {
-        double process (double sample);
-        void reset();
-        int type;
-        double x2, x4, x6, x8;
+        tonix::Precision precision { tonix::Precision::Double };
+        tonix::Antialiasing antialiasing { tonix::Antialiasing::Off };
+        tonix::SaturatorTier saturatorTier { tonix::SaturatorTier::Polynomial };
+        // 1, 2, 4 or 8; offline renders (isNonRealtime()) use their own factor
+        int oversampling { 1 }, offlineOversampling { 1 };
+        tonix::OversamplingPhase oversamplingPhase { tonix::OversamplingPhase::Linear };
+        // run the core at 44.1/48 or 88.2/96 kHz whatever the session rate
+        tonix::InternalRate internalRate { tonix::InternalRate::Host };
+        // step down to cheaper quality levels when blocks get close to their deadline,
+        // realtime only
+        bool cpuGovernor { false };
+        // spread the channels of wide layouts over the CPU cores
+        bool multicore { false };
     };
+    EngineSettings getEngineSettings() const;
+    void setEngineSettings (const EngineSettings&);
 
-    struct Channel
-    {
-        enum class Brightness
-        {
-            Opal = 0,
-            Gold,
-            Sapphire
-        };
-
-        enum class Type
-        {
-            Luminiscent = 0,
-            Iridescent,
-            Radiant,
-            Luster,
-            DarkEssence
-        };
-
-        void setProcessing (double amount);
-
-        void setMode (Type, Brightness);
-        void reset();
-        double process (double sample);
-
-        double processing;
-        double curProcessing;
-
-        // memory
-        double x1, x2, x3, x4, x5, y;
-
-        // coeffs
-        double hpf_k, lpf_k;
-        double a3, f1, p20, p24;
-        int g0;
-        double autoGain_a1, autoGain_a2;
-        double autoGain;
-        bool useAutoGain;
-
-        Saturator saturator;
-        Type type;
-        Brightness brightness;
-
-        float autoGainComp;
-
-        double s, prev_x;
-        double srScale { 1.0 };
-    };
+    // what each block cost against its deadline, recorded by the audio thread
+    const tonix::LoadMeter& getLoadMeter() const { return m_loadMeter; }
+    void resetLoadMeter() { m_loadMeter.reset(); }
+    // a number for the instance, with the host's track name if it gave one
+    juce::String getInstanceName() const;
+    // the load of every instance in this process, the worst p99 first
+    static juce::String getLoadReport();
+
+    void updateTrackProperties (const TrackProperties&) override;
+
+private:
+    // apvts.state -> audio thread
+    void loadEngineSettings();
+    // allocates and reports the latency, the audio thread must not be running
+    void prepareEngine (const EngineSettings&, double sampleRate, int maxBlockSize);
+
+    void parameterChanged (const juce::String& parameterID, float newValue) override;
+    void updateParameterSnapshot();
+    // audio thread; either bypass crossfades the engine to its dry path
+    void setHostBypassed (bool);
+    // both host sample types run the same engine, without converting the buffer
+    template <typename SampleType>
+    void processSamples (juce::AudioBuffer<SampleType>&);
+    // one part of a block between parameter events
+    template <typename SampleType>
+    void processPart (SampleType* const* channels, int numChannels, int numSamples);
+    struct ParameterEvent;
+    void applyParameterEvent (const ParameterEvent&);
+    // logs the governor's quality changes
+    void timerCallback() override;
 
     float inputGain, outputGain;
-    std::vector<Channel> m_processors;
+    tonix::ParallelEngine m_engine;
+    bool m_multicore { false };
+    bool m_prepared { false };
+    // the host calls processBlockBypassed(), the bypass parameter may still be off
+    bool m_hostBypassed { false };
 
     struct Params
     {
-        std::atomic<float>*inputTrim, *process, *outputTrim, *autoGain, *bypass;
-        juce::Value brightness, type;
+        std::atomic<float>*inputTrim, *process, *outputTrim, *autoGain, *bypass, *brightness, *type;
     } m_params;
 
+    // parameter values as seen by the audio thread, refreshed only when m_paramsDirty is set
+    struct ParameterSnapshot
+    {
+        float inputTrim, process, outputTrim;
+        tonix::Type type;
+        tonix::Brightness brightness;
+        bool autoGain, bypass;
+        tonix::Precision precision;
+        tonix::Antialiasing antialiasing;
+        tonix::SaturatorTier saturatorTier;
+    } m_snapshot {};
+    std::atomic<bool> m_paramsDirty { true };
+
+    static constexpr size_t kNumParameters = 7;
+    // in the order of kParameterIDs
+    std::array<juce::RangedAudioParameter*, kNumParameters> m_parameters {};
+    std::array<clap_id, kNumParameters> m_clapIds {};
+    // normalised offsets from CLAP modulation, on top of the parameters' values
+    std::array<float, kNumParameters> m_modulation {};
+
+    // events of the next block in time order, from handleDirectEvent(), which the
+    // wrapper calls on the audio thread right before processBlock()
+    struct ParameterEvent
+    {
+        int sampleOffset;
+        size_t parameter;
+        bool modulation;
+        // normalised, or a normalised offset for modulation
+        float value;
+    };
+    static constexpr int kMaxParameterEvents = 512;
+    std::array<ParameterEvent, kMaxParameterEvents> m_parameterEvents {};
+    int m_numParameterEvents { 0 };
+    std::atomic<tonix::Precision> m_precision { tonix::Precision::Double };
+    std::atomic<tonix::Antialiasing> m_antialiasing { tonix::Antialiasing::Off };
+    std::atomic<tonix::SaturatorTier> m_saturatorTier { tonix::SaturatorTier::Polynomial };
+
+    tonix::LoadMeter m_loadMeter;
+    const int m_instanceNumber;
+    juce::String m_trackName;
+    juce::CriticalSection m_trackNameLock;
+
+    tonix::CpuGovernor m_governor;
+    bool m_useGovernor { false };
+    // audio thread -> timerCallback()
+    struct QualityChange
+    {
+        int from, to;
+        double load;
+        tonix::Engine::Quality quality;
+    };
+    std::array<QualityChange, 16> m_qualityChanges {};
+    juce::AbstractFifo m_qualityChangeFifo { 16 };
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TonixProcessor)
 };
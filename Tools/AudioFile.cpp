@@ -0,0 +1,520 @@
+#include "AudioFile.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace tonix::tools
+{
+    namespace
+    {
+        uint32_t readLE (const uint8_t* p, int numBytes)
+        {
+            uint32_t value = 0;
+            for (int i = numBytes; --i >= 0;)
+                value = (value << 8) | p[i];
+            return value;
+        }
+
+        uint32_t readBE (const uint8_t* p, int numBytes)
+        {
+            uint32_t value = 0;
+            for (int i = 0; i < numBytes; ++i)
+                value = (value << 8) | p[i];
+            return value;
+        }
+
+        uint64_t readLE64 (const uint8_t* p)
+        {
+            return static_cast<uint64_t> (readLE (p, 4)) | static_cast<uint64_t> (readLE (p + 4, 4)) << 32;
+        }
+
+        bool isId (const uint8_t* p, const char* id)
+        {
+            return std::memcmp (p, id, 4) == 0;
+        }
+
+        // AIFF's 80-bit extended sample rate
+        double readExtended (const uint8_t* p)
+        {
+            const auto exponent = static_cast<int> (readBE (p, 2) & 0x7fff);
+            const auto mantissa = static_cast<uint64_t> (readBE (p + 2, 4)) << 32 | readBE (p + 6, 4);
+            const auto value = std::ldexp (static_cast<double> (mantissa), exponent - 16383 - 63);
+            return (p[0] & 0x80) != 0 ? -value : value;
+        }
+
+        constexpr int getBytesPerSample (SampleFormat format)
+        {
+            switch (format)
+            {
+                case SampleFormat::UInt8:
+                case SampleFormat::Int8:
+                    return 1;
+                case SampleFormat::Int16:
+                    return 2;
+                case SampleFormat::Int24:
+                    return 3;
+                case SampleFormat::Int32:
+                case SampleFormat::Float32:
+                    return 4;
+                case SampleFormat::Float64:
+                    return 8;
+            }
+            return 4;
+        }
+
+        bool getIntFormat (int bitsPerSample, bool isAiff, SampleFormat& format)
+        {
+            // containers round odd sizes up to whole bytes
+            switch ((bitsPerSample + 7) / 8)
+            {
+                case 1:
+                    // WAV's 8-bit is unsigned, AIFF's signed
+                    format = isAiff ? SampleFormat::Int8 : SampleFormat::UInt8;
+                    return true;
+                case 2:
+                    format = SampleFormat::Int16;
+                    return true;
+                case 3:
+                    format = SampleFormat::Int24;
+                    return true;
+                case 4:
+                    format = SampleFormat::Int32;
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        // converts like juce::AudioData, the scale in double
+        template <SampleFormat Format, bool BigEndian>
+        void convert (const uint8_t* frames, size_t bytesPerFrame, int numFrames, int numChannels, float* const* channels)
+        {
+            constexpr auto bytes = static_cast<size_t> (getBytesPerSample (Format));
+            const auto load = [] (const uint8_t* p) -> float
+            {
+                if constexpr (Format == SampleFormat::UInt8)
+                    return static_cast<float> ((1.0 / 128.0) * (static_cast<int> (p[0]) - 128));
+                else if constexpr (Format == SampleFormat::Int8)
+                    return static_cast<float> ((1.0 / 128.0) * static_cast<int8_t> (p[0]));
+                else if constexpr (Format == SampleFormat::Int16)
+                    return static_cast<float> ((1.0 / 32768.0) * static_cast<int16_t> (BigEndian ? readBE (p, 2) : readLE (p, 2)));
+                else if constexpr (Format == SampleFormat::Int24)
+                    return static_cast<float> ((1.0 / 8388608.0) * (static_cast<int32_t> ((BigEndian ? readBE (p, 3) : readLE (p, 3)) << 8) >> 8));
+                else if constexpr (Format == SampleFormat::Int32)
+                    return static_cast<float> ((1.0 / 2147483648.0) * static_cast<int32_t> (BigEndian ? readBE (p, 4) : readLE (p, 4)));
+                else if constexpr (Format == SampleFormat::Float32)
+                    return std::bit_cast<float> (BigEndian ? readBE (p, 4) : readLE (p, 4));
+                else
+                    return static_cast<float> (std::bit_cast<double> (BigEndian ? static_cast<uint64_t> (readBE (p, 4)) << 32 | readBE (p + 4, 4) : readLE64 (p)));
+            };
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                const auto* sample = frames + static_cast<size_t> (ch) * bytes;
+                auto* out = channels[ch];
+                for (int i = 0; i < numFrames; ++i, sample += bytesPerFrame)
+                    out[i] = load (sample);
+            }
+        }
+
+        template <bool BigEndian>
+        void convert (SampleFormat format, const uint8_t* frames, size_t bytesPerFrame, int numFrames, int numChannels, float* const* channels)
+        {
+            switch (format)
+            {
+                case SampleFormat::UInt8:
+                    return convert<SampleFormat::UInt8, BigEndian> (frames, bytesPerFrame, numFrames, numChannels, channels);
+                case SampleFormat::Int8:
+                    return convert<SampleFormat::Int8, BigEndian> (frames, bytesPerFrame, numFrames, numChannels, channels);
+                case SampleFormat::Int16:
+                    return convert<SampleFormat::Int16, BigEndian> (frames, bytesPerFrame, numFrames, numChannels, channels);
+                case SampleFormat::Int24:
+                    return convert<SampleFormat::Int24, BigEndian> (frames, bytesPerFrame, numFrames, numChannels, channels);
+                case SampleFormat::Int32:
+                    return convert<SampleFormat::Int32, BigEndian> (frames, bytesPerFrame, numFrames, numChannels, channels);
+                case SampleFormat::Float32:
+                    return convert<SampleFormat::Float32, BigEndian> (frames, bytesPerFrame, numFrames, numChannels, channels);
+                case SampleFormat::Float64:
+                    return convert<SampleFormat::Float64, BigEndian> (frames, bytesPerFrame, numFrames, numChannels, channels);
+            }
+        }
+
+        void writeLE (char* p, uint64_t value, int numBytes)
+        {
+            for (int i = 0; i < numBytes; ++i, value >>= 8)
+                p[i] = static_cast<char> (value & 0xff);
+        }
+    } // namespace
+
+    MappedFile::~MappedFile()
+    {
+        close();
+    }
+
+#if defined(_WIN32)
+    bool MappedFile::open (const std::string& path, std::string& error)
+    {
+        close();
+        m_file = CreateFileA (path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE)
+        {
+            m_file = nullptr;
+            error = "can't open " + path;
+            return false;
+        }
+        LARGE_INTEGER size;
+        if (! GetFileSizeEx (m_file, &size))
+        {
+            error = "can't read the size of " + path;
+            close();
+            return false;
+        }
+        m_size = static_cast<size_t> (size.QuadPart);
+        // nothing to map
+        if (m_size == 0)
+            return true;
+        m_mapping = CreateFileMappingA (m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        m_data = m_mapping != nullptr ? static_cast<const uint8_t*> (MapViewOfFile (m_mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+        if (m_data == nullptr)
+        {
+            error = "can't map " + path;
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void MappedFile::close()
+    {
+        if (m_data != nullptr)
+            UnmapViewOfFile (m_data);
+        if (m_mapping != nullptr)
+            CloseHandle (m_mapping);
+        if (m_file != nullptr)
+            CloseHandle (m_file);
+        m_data = nullptr;
+        m_mapping = m_file = nullptr;
+        m_size = 0;
+    }
+#else
+    bool MappedFile::open (const std::string& path, std::string& error)
+    {
+        close();
+        const auto fd = ::open (path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            error = "can't open " + path;
+            return false;
+        }
+        struct stat info;
+        if (fstat (fd, &info) != 0)
+        {
+            ::close (fd);
+            error = "can't read the size of " + path;
+            return false;
+        }
+        m_size = static_cast<size_t> (info.st_size);
+        if (m_size > 0)
+        {
+            auto* data = mmap (nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED)
+            {
+                ::close (fd);
+                m_size = 0;
+                error = "can't map " + path;
+                return false;
+            }
+            // read front to back, once
+            madvise (data, m_size, MADV_SEQUENTIAL);
+            m_data = static_cast<const uint8_t*> (data);
+        }
+        // the mapping keeps the file
+        ::close (fd);
+        return true;
+    }
+
+    void MappedFile::close()
+    {
+        if (m_data != nullptr)
+            munmap (const_cast<uint8_t*> (m_data), m_size);
+        m_data = nullptr;
+        m_size = 0;
+    }
+#endif
+
+    bool AudioFileReader::open (const std::string& path, const AudioFormat* rawFormat, std::string& error)
+    {
+        m_samples = nullptr;
+        m_numFrames = 0;
+        if (! m_file.open (path, error))
+            return false;
+
+        const auto* data = m_file.getData();
+        const auto size = m_file.getSize();
+        bool parsed;
+        if (size >= 12 && (isId (data, "RIFF") || isId (data, "RF64")) && isId (data + 8, "WAVE"))
+            parsed = parseWav (error);
+        else if (size >= 12 && isId (data, "FORM") && (isId (data + 8, "AIFF") || isId (data + 8, "AIFC")))
+            parsed = parseAiff (error);
+        else if (rawFormat != nullptr)
+        {
+            m_format = *rawFormat;
+            parsed = setSamples (0, size, error);
+        }
+        else
+        {
+            error = "not a WAV or AIFF file";
+            parsed = false;
+        }
+
+        if (parsed && (m_format.numChannels <= 0 || ! (m_format.sampleRate > 0.0)))
+        {
+            error = "no channels or no sample rate";
+            parsed = false;
+        }
+        if (! parsed)
+            error = path + ": " + error;
+        return parsed;
+    }
+
+    bool AudioFileReader::setSamples (size_t offset, uint64_t size, std::string& error)
+    {
+        if (m_format.numChannels <= 0)
+        {
+            error = "no channels";
+            return false;
+        }
+        // a truncated file still reads up to where it ends
+        const auto available = offset <= m_file.getSize() ? m_file.getSize() - offset : 0;
+        size = std::min<uint64_t> (size, available);
+        m_bytesPerFrame = static_cast<size_t> (getBytesPerSample (m_format.sampleFormat) * m_format.numChannels);
+        m_samples = m_file.getData() + offset;
+        m_numFrames = static_cast<int64_t> (size / m_bytesPerFrame);
+        return true;
+    }
+
+    bool AudioFileReader::parseWav (std::string& error)
+    {
+        const auto* data = m_file.getData();
+        const auto size = m_file.getSize();
+        const auto isRf64 = isId (data, "RF64");
+        uint64_t dataSize64 = 0;
+        bool haveFormat = false;
+
+        for (size_t offset = 12; offset + 8 <= size;)
+        {
+            const auto* chunk = data + offset;
+            const auto chunkSize = readLE (chunk + 4, 4);
+            const auto* body = chunk + 8;
+            const auto bodySize = std::min<uint64_t> (chunkSize, size - offset - 8);
+
+            if (isId (chunk, "ds64") && bodySize >= 16)
+            {
+                dataSize64 = readLE64 (body + 8);
+            }
+            else if (isId (chunk, "fmt ") && bodySize >= 16)
+            {
+                auto tag = readLE (body, 2);
+                m_format.numChannels = static_cast<int> (readLE (body + 2, 2));
+                m_format.sampleRate = readLE (body + 4, 4);
+                const auto bits = static_cast<int> (readLE (body + 14, 2));
+                // WAVE_FORMAT_EXTENSIBLE: the subformat GUID starts with the tag
+                if (tag == 0xfffe && bodySize >= 26)
+                    tag = readLE (body + 24, 2);
+                m_format.bigEndian = false;
+                if (tag == 3 && (bits == 32 || bits == 64))
+                    m_format.sampleFormat = bits == 32 ? SampleFormat::Float32 : SampleFormat::Float64;
+                else if (tag != 1 || ! getIntFormat (bits, false, m_format.sampleFormat))
+                {
+                    error = "unsupported WAV encoding";
+                    return false;
+                }
+                haveFormat = true;
+            }
+            else if (isId (chunk, "data"))
+            {
+                if (! haveFormat)
+                {
+                    error = "WAV data before its format";
+                    return false;
+                }
+                return setSamples (offset + 8, isRf64 && chunkSize == 0xffffffff ? dataSize64 : chunkSize, error);
+            }
+            // chunks are padded to an even size
+            offset += 8 + static_cast<size_t> (chunkSize) + (chunkSize & 1);
+        }
+        error = "no WAV data";
+        return false;
+    }
+
+    bool AudioFileReader::parseAiff (std::string& error)
+    {
+        const auto* data = m_file.getData();
+        const auto size = m_file.getSize();
+        const auto isAifc = isId (data + 8, "AIFC");
+        bool haveFormat = false;
+
+        for (size_t offset = 12; offset + 8 <= size;)
+        {
+            const auto* chunk = data + offset;
+            const auto chunkSize = readBE (chunk + 4, 4);
+            const auto* body = chunk + 8;
+            const auto bodySize = std::min<uint64_t> (chunkSize, size - offset - 8);
+
+            if (isId (chunk, "COMM") && bodySize >= 18)
+            {
+                m_format.numChannels = static_cast<int> (readBE (body, 2));
+                const auto bits = static_cast<int> (readBE (body + 6, 2));
+                m_format.sampleRate = readExtended (body + 8);
+                m_format.bigEndian = true;
+                const char* compression = isAifc && bodySize >= 22 ? reinterpret_cast<const char*> (body + 18) : "NONE";
+                if (std::memcmp (compression, "fl32", 4) == 0 || std::memcmp (compression, "FL32", 4) == 0)
+                    m_format.sampleFormat = SampleFormat::Float32;
+                else if (std::memcmp (compression, "fl64", 4) == 0 || std::memcmp (compression, "FL64", 4) == 0)
+                    m_format.sampleFormat = SampleFormat::Float64;
+                else if ((std::memcmp (compression, "NONE", 4) == 0 || std::memcmp (compression, "twos", 4) == 0 || std::memcmp (compression, "sowt", 4) == 0)
+                         && getIntFormat (bits, true, m_format.sampleFormat))
+                    m_format.bigEndian = std::memcmp (compression, "sowt", 4) != 0;
+                else
+                {
+                    error = "unsupported AIFF encoding";
+                    return false;
+                }
+                haveFormat = true;
+            }
+            else if (isId (chunk, "SSND") && bodySize >= 8)
+            {
+                if (! haveFormat)
+                {
+                    error = "AIFF data before its format";
+                    return false;
+                }
+                const auto dataOffset = readBE (body, 4);
+                return setSamples (offset + 16 + dataOffset, chunkSize >= 8 + dataOffset ? chunkSize - 8 - dataOffset : 0, error);
+            }
+            offset += 8 + static_cast<size_t> (chunkSize) + (chunkSize & 1);
+        }
+        error = "no AIFF data";
+        return false;
+    }
+
+    void AudioFileReader::read (int64_t startFrame, int numFrames, float* const* channels) const
+    {
+        const auto* frames = m_samples + static_cast<size_t> (startFrame) * m_bytesPerFrame;
+        if (m_format.bigEndian)
+            convert<true> (m_format.sampleFormat, frames, m_bytesPerFrame, numFrames, m_format.numChannels, channels);
+        else
+            convert<false> (m_format.sampleFormat, frames, m_bytesPerFrame, numFrames, m_format.numChannels, channels);
+    }
+
+    AudioFileWriter::~AudioFileWriter()
+    {
+        close();
+    }
+
+    bool AudioFileWriter::open (const std::string& path, int numChannels, double sampleRate, bool raw, std::string& error)
+    {
+        close();
+        m_file = std::fopen (path.c_str(), "wb");
+        if (m_file == nullptr)
+        {
+            error = "can't create " + path;
+            return false;
+        }
+        // sequential writes a few MB at a time
+        m_buffer.resize (size_t (4) << 20);
+        std::setvbuf (m_file, m_buffer.data(), _IOFBF, m_buffer.size());
+        m_numChannels = numChannels;
+        m_sampleRate = sampleRate;
+        m_raw = raw;
+        m_failed = false;
+        m_numFrames = 0;
+        if (! writeHeader (0))
+        {
+            error = "can't write " + path;
+            return false;
+        }
+        return true;
+    }
+
+    bool AudioFileWriter::writeHeader (uint64_t numFrames)
+    {
+        if (m_raw)
+            return true;
+
+        // RIFF, then a JUNK chunk the size of ds64 that RF64 takes over, fmt and data
+        constexpr uint64_t kHeaderSize = 80;
+        char header[kHeaderSize] {};
+        const auto dataSize = numFrames * static_cast<uint64_t> (m_numChannels) * sizeof (float);
+        const auto riffSize = kHeaderSize - 8 + dataSize;
+        const auto isRf64 = riffSize > 0xffffffff;
+
+        std::memcpy (header, isRf64 ? "RF64" : "RIFF", 4);
+        writeLE (header + 4, isRf64 ? 0xffffffff : riffSize, 4);
+        std::memcpy (header + 8, "WAVE", 4);
+        std::memcpy (header + 12, isRf64 ? "ds64" : "JUNK", 4);
+        writeLE (header + 16, 28, 4);
+        if (isRf64)
+        {
+            writeLE (header + 20, riffSize, 8);
+            writeLE (header + 28, dataSize, 8);
+            writeLE (header + 36, numFrames, 8);
+        }
+        std::memcpy (header + 48, "fmt ", 4);
+        writeLE (header + 52, 16, 4);
+        // WAVE_FORMAT_IEEE_FLOAT
+        writeLE (header + 56, 3, 2);
+        writeLE (header + 58, static_cast<uint64_t> (m_numChannels), 2);
+        writeLE (header + 60, static_cast<uint64_t> (std::lround (m_sampleRate)), 4);
+        writeLE (header + 64, static_cast<uint64_t> (std::lround (m_sampleRate)) * static_cast<uint64_t> (m_numChannels) * sizeof (float), 4);
+        writeLE (header + 68, static_cast<uint64_t> (m_numChannels) * sizeof (float), 2);
+        writeLE (header + 70, 32, 2);
+        std::memcpy (header + 72, "data", 4);
+        writeLE (header + 76, isRf64 ? 0xffffffff : dataSize, 4);
+
+        return std::fseek (m_file, 0, SEEK_SET) == 0 && std::fwrite (header, 1, sizeof (header), m_file) == sizeof (header);
+    }
+
+    bool AudioFileWriter::write (const float* const* channels, int numFrames)
+    {
+        if (m_file == nullptr || m_failed)
+            return false;
+        const auto numSamples = static_cast<size_t> (numFrames) * static_cast<size_t> (m_numChannels);
+        m_interleaved.resize (numSamples);
+        for (int ch = 0; ch < m_numChannels; ++ch)
+            for (int i = 0; i < numFrames; ++i)
+                m_interleaved[static_cast<size_t> (i * m_numChannels + ch)] = channels[ch][i];
+        if constexpr (std::endian::native == std::endian::big)
+            for (auto& sample : m_interleaved)
+            {
+                const auto bits = std::bit_cast<uint32_t> (sample);
+                sample = std::bit_cast<float> ((bits >> 24) | ((bits >> 8) & 0xff00) | ((bits << 8) & 0xff0000) | (bits << 24));
+            }
+        m_failed = std::fwrite (m_interleaved.data(), sizeof (float), numSamples, m_file) != numSamples;
+        m_numFrames += static_cast<uint64_t> (numFrames);
+        return ! m_failed;
+    }
+
+    bool AudioFileWriter::close()
+    {
+        if (m_file == nullptr)
+            return false;
+        auto ok = ! m_failed && std::fflush (m_file) == 0 && writeHeader (m_numFrames);
+        ok = std::fclose (m_file) == 0 && ok;
+        m_file = nullptr;
+        return ok;
+    }
+} // namespace tonix::tools
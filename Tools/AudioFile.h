@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace tonix::tools
+{
+    // A whole file mapped read-only, so reading it is the kernel paging it in sequentially.
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile (const MappedFile&) = delete;
+        MappedFile& operator= (const MappedFile&) = delete;
+
+        // false with a message if it can't be opened or mapped
+        bool open (const std::string& path, std::string& error);
+        void close();
+
+        const uint8_t* getData() const { return m_data; }
+        size_t getSize() const { return m_size; }
+
+    private:
+        const uint8_t* m_data { nullptr };
+        size_t m_size { 0 };
+#if defined(_WIN32)
+        void* m_file { nullptr };
+        void* m_mapping { nullptr };
+#endif
+    };
+
+    enum class SampleFormat
+    {
+        UInt8,
+        Int8,
+        Int16,
+        Int24,
+        Int32,
+        Float32,
+        Float64
+    };
+
+    struct AudioFormat
+    {
+        int numChannels { 2 };
+        double sampleRate { 48000.0 };
+        SampleFormat sampleFormat { SampleFormat::Float32 };
+        bool bigEndian { false };
+    };
+
+    // WAV, RF64 and AIFF/AIFC files, or raw interleaved samples, converted to float
+    // straight from the mapping. Integers scale like JUCE's readers, so the engine sees
+    // what a host would give it.
+    class AudioFileReader
+    {
+    public:
+        // rawFormat describes the file if it's neither WAV nor AIFF; nullptr makes that
+        // an error
+        bool open (const std::string& path, const AudioFormat* rawFormat, std::string& error);
+
+        const AudioFormat& getFormat() const { return m_format; }
+        int64_t getNumFrames() const { return m_numFrames; }
+        double getLengthSeconds() const { return static_cast<double> (m_numFrames) / m_format.sampleRate; }
+
+        // frames startFrame to startFrame + numFrames, which must be in the file, one
+        // array per channel
+        void read (int64_t startFrame, int numFrames, float* const* channels) const;
+
+    private:
+        bool parseWav (std::string& error);
+        bool parseAiff (std::string& error);
+        bool setSamples (size_t offset, uint64_t size, std::string& error);
+
+        MappedFile m_file;
+        AudioFormat m_format;
+        const uint8_t* m_samples { nullptr };
+        int64_t m_numFrames { 0 };
+        size_t m_bytesPerFrame { 0 };
+    };
+
+    // 32-bit float WAV, which turns into RF64 when it outgrows 4 GB, or raw interleaved
+    // 32-bit float. Writes through a large buffer.
+    class AudioFileWriter
+    {
+    public:
+        AudioFileWriter() = default;
+        // closes without reporting errors
+        ~AudioFileWriter();
+
+        AudioFileWriter (const AudioFileWriter&) = delete;
+        AudioFileWriter& operator= (const AudioFileWriter&) = delete;
+
+        bool open (const std::string& path, int numChannels, double sampleRate, bool raw, std::string& error);
+        // one array per channel
+        bool write (const float* const* channels, int numFrames);
+        // completes the header, false if anything failed to write
+        bool close();
+
+    private:
+        bool writeHeader (uint64_t numFrames);
+
+        std::FILE* m_file { nullptr };
+        int m_numChannels { 0 };
+        double m_sampleRate { 0.0 };
+        bool m_raw { false };
+        bool m_failed { false };
+        uint64_t m_numFrames { 0 };
+        std::vector<float> m_interleaved;
+        std::vector<char> m_buffer;
+    };
+} // namespace tonix::tools
@@ -0,0 +1,230 @@
+#include "DaemonClient.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <new>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace tonix::daemon
+{
+    namespace
+    {
+        // between checks that the daemon is still there
+        constexpr int kWaitMs = 100;
+        // for the daemon to prepare the engine
+        constexpr auto kOpenTimeout = std::chrono::seconds (10);
+
+        void* mapSegment (const char* name, int flags, size_t size)
+        {
+            const auto fd = shm_open (name, flags, 0600);
+            if (fd < 0)
+                return nullptr;
+            if ((flags & O_CREAT) != 0 && ftruncate (fd, static_cast<off_t> (size)) != 0)
+            {
+                ::close (fd);
+                return nullptr;
+            }
+            auto* data = mmap (nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            ::close (fd);
+            return data != MAP_FAILED ? data : nullptr;
+        }
+    } // namespace
+
+    RemoteProcessor::RemoteProcessor()
+    {
+        // NaN leaves the daemon's default, tonix_set_param() rejects it
+        m_params.fill (std::numeric_limits<double>::quiet_NaN());
+    }
+
+    RemoteProcessor::~RemoteProcessor()
+    {
+        close();
+    }
+
+    void RemoteProcessor::setParameter (tonix_param param, double value)
+    {
+        if (param < 0 || param >= TONIX_NUM_PARAMS)
+            return;
+        m_params[static_cast<size_t> (param)] = value;
+        if (m_header == nullptr)
+            return;
+        m_header->params[param].store (value, std::memory_order_relaxed);
+        m_header->paramsVersion.fetch_add (1, std::memory_order_release);
+    }
+
+    bool RemoteProcessor::open (int numChannels, double sampleRate, int maxBlockSize, std::string& error, int ringSize, const char* daemonName)
+    {
+        close();
+        if (numChannels <= 0 || numChannels > kMaxChannels || maxBlockSize <= 0 || maxBlockSize > kMaxBlockSize || ringSize <= 0 || ringSize > kMaxRingSize || ! (sampleRate > 0.0))
+        {
+            error = "invalid channel count, block size, ring size or sample rate";
+            return false;
+        }
+
+        m_registry = static_cast<Registry*> (mapSegment (daemonName, O_RDWR, sizeof (Registry)));
+        if (m_registry == nullptr || m_registry->magic != kRegistryMagic || m_registry->version != kProtocolVersion || ! isProcessAlive (m_registry->daemonPid))
+        {
+            error = std::string ("no daemon running as ") + daemonName;
+            unmap();
+            return false;
+        }
+
+        // the daemon opens it through /proc while the client holds it open; sealed, the
+        // size the daemon maps is the size it keeps
+        m_segmentSize = getSegmentSize (numChannels, maxBlockSize, ringSize);
+        const auto fd = memfd_create ("tonix-instance", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+        void* memory = MAP_FAILED;
+        if (fd >= 0 && ftruncate (fd, static_cast<off_t> (m_segmentSize)) == 0 && fcntl (fd, F_ADD_SEALS, kSegmentSeals) == 0)
+            memory = mmap (nullptr, m_segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (memory == MAP_FAILED)
+        {
+            if (fd >= 0)
+                ::close (fd);
+            error = "can't create shared memory for the instance";
+            unmap();
+            return false;
+        }
+        m_header = new (memory) InstanceHeader {};
+        m_header->magic = kInstanceMagic;
+        m_header->version = kProtocolVersion;
+        m_header->numChannels = numChannels;
+        m_header->maxBlockSize = maxBlockSize;
+        m_header->ringSize = ringSize;
+        m_header->sampleRate = sampleRate;
+        for (size_t i = 0; i < m_params.size(); ++i)
+            m_header->params[i].store (m_params[i], std::memory_order_relaxed);
+
+        for (int s = 0; s < kMaxInstances && m_slot < 0; ++s)
+        {
+            auto expected = static_cast<uint32_t> (Free);
+            if (m_registry->slots[s].state.compare_exchange_strong (expected, Claimed))
+                m_slot = s;
+        }
+        if (m_slot < 0)
+        {
+            ::close (fd);
+            error = "the daemon has no free instances";
+            unmap();
+            return false;
+        }
+        auto& slot = m_registry->slots[m_slot];
+        slot.pid = static_cast<int32_t> (getpid());
+        slot.fd = fd;
+        slot.state.store (Opening, std::memory_order_release);
+        ring (m_registry->control);
+
+        const auto deadline = std::chrono::steady_clock::now() + kOpenTimeout;
+        while (m_header->status.load (std::memory_order_acquire) == Pending && isProcessAlive (m_registry->daemonPid) && std::chrono::steady_clock::now() < deadline)
+            futexWait (m_header->status, Pending, kWaitMs);
+        ::close (fd);
+
+        const auto status = m_header->status.load (std::memory_order_acquire);
+        if (status != Ready)
+        {
+            error = status == Failed ? "the daemon couldn't prepare the engine (" + std::to_string (m_header->error) + ")" : "the daemon didn't answer";
+            close();
+            return false;
+        }
+        m_submitted = m_received = 0;
+        return true;
+    }
+
+    void RemoteProcessor::close()
+    {
+        if (m_registry != nullptr && m_slot >= 0)
+        {
+            // the daemon unmaps its side when it gets to it, the memory lives until then
+            m_registry->slots[m_slot].state.store (Closing, std::memory_order_release);
+            ring (m_registry->control);
+        }
+        m_slot = -1;
+        unmap();
+    }
+
+    void RemoteProcessor::unmap()
+    {
+        if (m_header != nullptr)
+            munmap (m_header, m_segmentSize);
+        if (m_registry != nullptr)
+            munmap (m_registry, sizeof (Registry));
+        m_header = nullptr;
+        m_registry = nullptr;
+    }
+
+    double RemoteProcessor::getLatency() const
+    {
+        return m_header != nullptr ? m_header->latency : 0.0;
+    }
+
+    double RemoteProcessor::getTailLength() const
+    {
+        return m_header != nullptr ? m_header->tailLength : 0.0;
+    }
+
+    int RemoteProcessor::getNumPending() const
+    {
+        return static_cast<int> (m_submitted - m_received);
+    }
+
+    bool RemoteProcessor::submit (const float* const* channels, int numFrames)
+    {
+        if (m_header == nullptr || numFrames < 0 || numFrames > m_header->maxBlockSize || getNumPending() >= m_header->ringSize)
+            return false;
+        auto& header = *m_header;
+        getBlock (header, m_submitted)->numFrames = numFrames;
+        for (int ch = 0; ch < header.numChannels; ++ch)
+            std::copy (channels[ch], channels[ch] + numFrames, getChannel (header, m_submitted, ch));
+        header.requestHead.store (++m_submitted, std::memory_order_release);
+        ring (m_registry->workers[header.worker]);
+        return true;
+    }
+
+    int RemoteProcessor::receive (float* const* channels)
+    {
+        if (m_header == nullptr || getNumPending() == 0)
+            return -1;
+        auto& header = *m_header;
+        const auto isDone = [&]
+        {
+            return static_cast<int32_t> (header.responseHead.load (std::memory_order_acquire) - m_received) > 0;
+        };
+
+        for (int i = 0; i < getSpinIterations() && ! isDone(); ++i)
+            cpuPause();
+        while (! isDone())
+        {
+            // the worker checks the flag after moving the head on
+            header.clientWaiting.store (1);
+            const auto seen = header.responseHead.load();
+            if (static_cast<int32_t> (seen - m_received) <= 0)
+                futexWait (header.responseHead, seen, kWaitMs);
+            header.clientWaiting.store (0);
+            if (! isDone() && ! isProcessAlive (m_registry->daemonPid))
+            {
+                unmap();
+                m_slot = -1;
+                return -1;
+            }
+        }
+
+        const auto numFrames = getBlock (header, m_received)->numFrames;
+        for (int ch = 0; ch < header.numChannels; ++ch)
+        {
+            const auto* samples = getChannel (header, m_received, ch);
+            std::copy (samples, samples + numFrames, channels[ch]);
+        }
+        ++m_received;
+        return numFrames;
+    }
+
+    bool RemoteProcessor::process (float* const* channels, int numFrames)
+    {
+        return getNumPending() == 0 && submit (channels, numFrames) && receive (channels) == numFrames;
+    }
+} // namespace tonix::daemon
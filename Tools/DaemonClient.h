@@ -0,0 +1,60 @@
+#pragma once
+
+#include "DaemonProtocol.h"
+
+#include <array>
+#include <string>
+
+namespace tonix::daemon
+{
+    // One Tonix engine running in a TonixDaemon, fed through the shared memory ring of
+    // DaemonProtocol.h. submit() writes a block and rings the instance's worker;
+    // receive() waits for the oldest one to come back, polling for a while before it
+    // sleeps on a futex. Up to the ring size of blocks can be in flight, so a client
+    // that can afford the latency keeps the worker busy while it waits.
+    //
+    // Used from one thread at a time. The engine keeps running if the client crashes
+    // until the daemon notices, and a daemon that dies fails the calls instead of
+    // hanging them.
+    class RemoteProcessor
+    {
+    public:
+        RemoteProcessor();
+        ~RemoteProcessor();
+
+        RemoteProcessor (const RemoteProcessor&) = delete;
+        RemoteProcessor& operator= (const RemoteProcessor&) = delete;
+
+        // As tonix_set_param() takes them. Before open() every parameter, the ones
+        // tonix.h applies at the next prepare included; after, the next block picks it up.
+        void setParameter (tonix_param, double value);
+
+        // creates the instance in the daemon registered under daemonName and prepares it
+        bool open (int numChannels, double sampleRate, int maxBlockSize, std::string& error, int ringSize = 2, const char* daemonName = kDefaultName);
+        void close();
+        bool isOpen() const { return m_header != nullptr; }
+
+        double getLatency() const;
+        double getTailLength() const;
+        int getNumPending() const;
+
+        // one array per prepared channel; false if the ring is full or numFrames is past
+        // the prepared block size
+        bool submit (const float* const* channels, int numFrames);
+        // the oldest submitted block, processed; its frame count, or -1 if nothing was
+        // submitted or the daemon is gone
+        int receive (float* const* channels);
+        // both, in place, with nothing else in flight
+        bool process (float* const* channels, int numFrames);
+
+    private:
+        void unmap();
+
+        Registry* m_registry { nullptr };
+        InstanceHeader* m_header { nullptr };
+        size_t m_segmentSize { 0 };
+        int m_slot { -1 };
+        uint32_t m_submitted { 0 }, m_received { 0 };
+        std::array<double, TONIX_NUM_PARAMS> m_params {};
+    };
+} // namespace tonix::daemon
@@ -0,0 +1,111 @@
+#include "DaemonProtocol.h"
+
+#include <cerrno>
+#include <csignal>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace tonix::daemon
+{
+    namespace
+    {
+        size_t roundUp (size_t bytes)
+        {
+            return (bytes + kCacheLineSize - 1) / kCacheLineSize * kCacheLineSize;
+        }
+
+        // shared futexes, the word is in memory mapped by more than one process
+        long futex (std::atomic<uint32_t>& word, int op, uint32_t value, const timespec* timeout)
+        {
+            return syscall (SYS_futex, reinterpret_cast<uint32_t*> (&word), op, value, timeout, nullptr, 0);
+        }
+    } // namespace
+
+    size_t getChannelStride (int maxBlockSize)
+    {
+        return roundUp (static_cast<size_t> (maxBlockSize) * sizeof (float)) / sizeof (float);
+    }
+
+    size_t getBlockBytes (int numChannels, int maxBlockSize)
+    {
+        return sizeof (BlockHeader) + static_cast<size_t> (numChannels) * getChannelStride (maxBlockSize) * sizeof (float);
+    }
+
+    size_t getSegmentSize (int numChannels, int maxBlockSize, int ringSize)
+    {
+        return roundUp (sizeof (InstanceHeader)) + static_cast<size_t> (ringSize) * getBlockBytes (numChannels, maxBlockSize);
+    }
+
+    BlockHeader* getBlock (InstanceHeader& header, uint32_t index)
+    {
+        return getBlock (header, getGeometry (header), index);
+    }
+
+    float* getChannel (InstanceHeader& header, uint32_t index, int channel)
+    {
+        return getChannel (header, getGeometry (header), index, channel);
+    }
+
+    Geometry getGeometry (const InstanceHeader& header)
+    {
+        return { header.numChannels, header.maxBlockSize, header.ringSize };
+    }
+
+    BlockHeader* getBlock (InstanceHeader& header, const Geometry& geometry, uint32_t index)
+    {
+        auto* blocks = reinterpret_cast<char*> (&header) + roundUp (sizeof (InstanceHeader));
+        return reinterpret_cast<BlockHeader*> (blocks + (index % static_cast<uint32_t> (geometry.ringSize)) * getBlockBytes (geometry.numChannels, geometry.maxBlockSize));
+    }
+
+    float* getChannel (InstanceHeader& header, const Geometry& geometry, uint32_t index, int channel)
+    {
+        auto* samples = reinterpret_cast<float*> (getBlock (header, geometry, index) + 1);
+        return samples + static_cast<size_t> (channel) * getChannelStride (geometry.maxBlockSize);
+    }
+
+    void futexWait (std::atomic<uint32_t>& word, uint32_t expected, int timeoutMs)
+    {
+        const timespec timeout { timeoutMs / 1000, (timeoutMs % 1000) * 1000000L };
+        futex (word, FUTEX_WAIT, expected, &timeout);
+    }
+
+    void futexWake (std::atomic<uint32_t>& word)
+    {
+        futex (word, FUTEX_WAKE, 1, nullptr);
+    }
+
+    void ring (Doorbell& doorbell)
+    {
+        // the waiter raises the flag, then checks the count before sleeping
+        doorbell.count.fetch_add (1);
+        if (doorbell.sleeping.load() != 0)
+            futexWake (doorbell.count);
+    }
+
+    int getSpinIterations()
+    {
+        static const int iterations = std::thread::hardware_concurrency() > 1 ? 4096 : 0;
+        return iterations;
+    }
+
+    void cpuPause()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        _mm_pause();
+#elif defined(__aarch64__)
+        __asm__ volatile ("yield");
+#endif
+    }
+
+    bool isProcessAlive (int32_t pid)
+    {
+        return pid > 0 && (kill (pid, 0) == 0 || errno != ESRCH);
+    }
+} // namespace tonix::daemon
@@ -0,0 +1,145 @@
+#pragma once
+
+// The shared memory TonixDaemon and its clients talk through. Linux only: processes wake
+// each other with futexes on words in that memory.
+//
+// The daemon owns a registry segment with a slot per instance and a doorbell per worker
+// thread. A client creates a segment for its instance, InstanceHeader followed by a ring
+// of audio blocks, as a memfd sealed against resizing, so the daemon never touches
+// memory that went away under it. It hands the descriptor over through a registry slot
+// and the daemon opens it through /proc. From then on audio
+// goes through the ring: the client writes a block and advances requestHead, the worker
+// processes it in place and advances responseHead. Nothing on that path takes a lock or
+// makes a system call unless the other side is asleep.
+
+#include "tonix.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+
+namespace tonix::daemon
+{
+    constexpr uint32_t kProtocolVersion = 2;
+    constexpr uint32_t kRegistryMagic = 0x544e5852;
+    constexpr uint32_t kInstanceMagic = 0x544e5849;
+    constexpr const char* kDefaultName = "/tonix-daemon";
+
+    constexpr int kMaxWorkers = 64;
+    constexpr int kMaxInstances = 256;
+    constexpr int kMaxChannels = 64;
+    constexpr int kMaxBlockSize = 1 << 16;
+    constexpr int kMaxRingSize = 64;
+    constexpr size_t kCacheLineSize = 64;
+    // an instance's segment keeps its size for good
+    constexpr int kSegmentSeals = F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL;
+
+    // both processes use the same words, so the atomics must not hide a lock
+    static_assert (std::atomic<uint32_t>::is_always_lock_free && std::atomic<double>::is_always_lock_free);
+
+    // a counter to ring and the flag its one waiter raises before it sleeps on it
+    struct alignas (kCacheLineSize) Doorbell
+    {
+        std::atomic<uint32_t> count;
+        std::atomic<uint32_t> sleeping;
+    };
+
+    enum SlotState : uint32_t
+    {
+        Free,
+        // a client is filling it in
+        Claimed,
+        // waiting for the daemon to attach the segment
+        Opening,
+        Active,
+        // the client is done, the daemon frees it
+        Closing
+    };
+
+    struct Slot
+    {
+        std::atomic<uint32_t> state;
+        int32_t pid;
+        // the instance's memfd in the client, open until the client hears back
+        int32_t fd;
+    };
+
+    struct Registry
+    {
+        uint32_t magic, version;
+        int32_t daemonPid;
+        int32_t numWorkers;
+        // wakes the daemon's control thread for slot changes
+        Doorbell control;
+        Doorbell workers[kMaxWorkers];
+        Slot slots[kMaxInstances];
+    };
+
+    enum InstanceStatus : uint32_t
+    {
+        Pending,
+        Ready,
+        Failed
+    };
+
+    struct InstanceHeader
+    {
+        // written by the client before it opens the slot
+        uint32_t magic, version;
+        int32_t numChannels, maxBlockSize, ringSize;
+        double sampleRate;
+
+        // written by the daemon before status leaves Pending
+        std::atomic<uint32_t> status;
+        int32_t error;
+        int32_t worker;
+        double latency, tailLength;
+
+        // the client's latest values, applied before the next block once the version moves
+        std::atomic<uint32_t> paramsVersion;
+        std::atomic<double> params[TONIX_NUM_PARAMS];
+
+        // blocks written by the client
+        alignas (kCacheLineSize) std::atomic<uint32_t> requestHead;
+        // blocks processed by the daemon; the client sleeps on it with clientWaiting set
+        alignas (kCacheLineSize) std::atomic<uint32_t> responseHead;
+        std::atomic<uint32_t> clientWaiting;
+    };
+
+    // one per ring entry after the header, followed by the block's channels
+    struct alignas (kCacheLineSize) BlockHeader
+    {
+        int32_t numFrames;
+    };
+
+    // floats between channels of a block, whole cache lines
+    size_t getChannelStride (int maxBlockSize);
+    size_t getBlockBytes (int numChannels, int maxBlockSize);
+    size_t getSegmentSize (int numChannels, int maxBlockSize, int ringSize);
+    BlockHeader* getBlock (InstanceHeader&, uint32_t index);
+    float* getChannel (InstanceHeader&, uint32_t index, int channel);
+
+    // the header's layout fields; the client can rewrite them at any time, so the daemon
+    // checks a copy once and lays out the segment from that copy only
+    struct Geometry
+    {
+        int32_t numChannels, maxBlockSize, ringSize;
+    };
+    Geometry getGeometry (const InstanceHeader&);
+    BlockHeader* getBlock (InstanceHeader&, const Geometry&, uint32_t index);
+    float* getChannel (InstanceHeader&, const Geometry&, uint32_t index, int channel);
+
+    // sleeps while the word holds expected, for at most timeoutMs; wakeups can be spurious
+    void futexWait (std::atomic<uint32_t>&, uint32_t expected, int timeoutMs);
+    void futexWake (std::atomic<uint32_t>&);
+    // moves the count on and wakes its waiter if it sleeps
+    void ring (Doorbell&);
+
+    // pause iterations to poll for before sleeping; none with a single core, where
+    // spinning only keeps the other side from running
+    int getSpinIterations();
+    void cpuPause();
+
+    bool isProcessAlive (int32_t pid);
+} // namespace tonix::daemon
@@ -0,0 +1,354 @@
+#include "PluginState.h"
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <optional>
+
+namespace tonix::tools
+{
+    namespace
+    {
+        // as in PluginProcessor.cpp
+        struct ParameterRange
+        {
+            const char* id;
+            float start, end, interval, defaultValue;
+            std::vector<const char*> choices;
+        };
+
+        const ParameterRange kParameters[] = {
+            { "inputTrim", -10.0f, 10.0f, 0.1f, 0.0f, {} },
+            { "process", 0.0f, 100.0f, 0.1f, 0.0f, {} },
+            { "outputTrim", -6.0f, 6.0f, 0.01f, 0.0f, {} },
+            { "brightness", 0.0f, 2.0f, 1.0f, 1.0f, { "Opal", "Gold", "Sapphire" } },
+            { "type", 0.0f, 4.0f, 1.0f, 1.0f, { "Luminiscent", "Iridescent", "Radiant", "Luster", "Dark Essence" } },
+            { "bypass", 0.0f, 1.0f, 1.0f, 0.0f, { "false", "true" } },
+            { "autoGain", 0.0f, 1.0f, 1.0f, 1.0f, { "false", "true" } },
+        };
+        // in the order of kParameters
+        constexpr tonix_param kParameterIndices[] = { TONIX_PARAM_INPUT_TRIM, TONIX_PARAM_PROCESS, TONIX_PARAM_OUTPUT_TRIM, TONIX_PARAM_BRIGHTNESS, TONIX_PARAM_TYPE, TONIX_PARAM_BYPASS, TONIX_PARAM_AUTO_GAIN };
+        static_assert (std::size (kParameters) == std::size (kParameterIndices));
+
+        constexpr const char* kProperties[] = { "precision", "antialiasing", "saturator", "oversampling", "offlineOversampling", "oversamplingPhase", "internalRate", "cpuGovernor", "multicore" };
+
+        bool isKnown (const std::string& name)
+        {
+            return std::any_of (std::begin (kParameters), std::end (kParameters), [&] (const auto& p)
+                                { return name == p.id; })
+                   || std::any_of (std::begin (kProperties), std::end (kProperties), [&] (const auto* p)
+                                   { return name == p; });
+        }
+
+        std::string trim (const std::string& text)
+        {
+            const auto first = text.find_first_not_of (" \t\r\n");
+            if (first == std::string::npos)
+                return {};
+            return text.substr (first, text.find_last_not_of (" \t\r\n") + 1 - first);
+        }
+
+        bool equalsIgnoringCase (const std::string& a, const char* b)
+        {
+            return a.size() == std::strlen (b) && std::equal (a.begin(), a.end(), b, [] (char x, char y)
+                                                              { return std::tolower (static_cast<unsigned char> (x)) == std::tolower (static_cast<unsigned char> (y)); });
+        }
+
+        std::optional<double> toNumber (const std::string& text)
+        {
+            if (text.empty())
+                return std::nullopt;
+            char* end = nullptr;
+            const auto value = std::strtod (text.c_str(), &end);
+            if (end != text.c_str() + text.size())
+                return std::nullopt;
+            return value;
+        }
+
+        std::string toString (double value)
+        {
+            // round-trips through strtod
+            char text[32];
+            std::snprintf (text, sizeof (text), "%.17g", value);
+            return text;
+        }
+
+        // juce::ValueTree::writeToStream()'s format
+        class TreeReader
+        {
+        public:
+            TreeReader (const uint8_t* data, size_t size)
+                : m_data (data), m_end (data + size)
+            {
+            }
+
+            bool isOk() const { return m_ok; }
+
+            uint8_t readByte()
+            {
+                if (m_data >= m_end)
+                {
+                    m_ok = false;
+                    return 0;
+                }
+                return *m_data++;
+            }
+
+            // OutputStream::writeCompressedInt(): a byte count, the sign in its top bit,
+            // then that many little-endian bytes
+            int readCompressedInt()
+            {
+                const auto header = readByte();
+                const auto numBytes = header & 0x7f;
+                if (numBytes > 4)
+                {
+                    m_ok = false;
+                    return 0;
+                }
+                uint32_t value = 0;
+                for (int i = 0; i < numBytes; ++i)
+                    value |= static_cast<uint32_t> (readByte()) << (8 * i);
+                const auto magnitude = static_cast<int> (std::min<uint32_t> (value, 0x7fffffff));
+                return (header & 0x80) != 0 ? -magnitude : magnitude;
+            }
+
+            // UTF-8, null-terminated
+            std::string readString()
+            {
+                const auto* end = static_cast<const uint8_t*> (std::memchr (m_data, 0, static_cast<size_t> (m_end - m_data)));
+                if (end == nullptr)
+                {
+                    m_ok = false;
+                    m_data = m_end;
+                    return {};
+                }
+                std::string text (reinterpret_cast<const char*> (m_data), static_cast<size_t> (end - m_data));
+                m_data = end + 1;
+                return text;
+            }
+
+            // var::writeToStream(): the size, then a type marker and the value; arrays,
+            // binary data and objects are skipped
+            std::string readVar()
+            {
+                const auto size = readCompressedInt();
+                if (size <= 0)
+                    return {};
+                if (static_cast<size_t> (size) > static_cast<size_t> (m_end - m_data))
+                {
+                    m_ok = false;
+                    return {};
+                }
+                const auto* body = m_data + 1;
+                const auto marker = *m_data;
+                m_data += size;
+
+                const auto bodySize = static_cast<size_t> (size - 1);
+                const auto readLE = [body] (int numBytes)
+                {
+                    uint64_t value = 0;
+                    for (int i = numBytes; --i >= 0;)
+                        value = (value << 8) | body[i];
+                    return value;
+                };
+                switch (marker)
+                {
+                    case 1: // int
+                        return bodySize >= 4 ? std::to_string (static_cast<int32_t> (readLE (4))) : std::string();
+                    case 2: // true
+                        return "1";
+                    case 3: // false
+                        return "0";
+                    case 4: // double
+                        return bodySize >= 8 ? toString (std::bit_cast<double> (readLE (8))) : std::string();
+                    case 5: // string
+                        return std::string (reinterpret_cast<const char*> (body), strnlen (reinterpret_cast<const char*> (body), bodySize));
+                    case 6: // int64
+                        return bodySize >= 8 ? std::to_string (static_cast<int64_t> (readLE (8))) : std::string();
+                    default:
+                        return {};
+                }
+            }
+
+        private:
+            const uint8_t* m_data;
+            const uint8_t* m_end;
+            bool m_ok { true };
+        };
+
+        // the APVTS tree: the engine settings as properties of the root, each parameter
+        // a PARAM child with an id and a value
+        void readTree (TreeReader& reader, PluginState& state, int depth)
+        {
+            const auto type = reader.readString();
+            std::string id, value;
+            const auto numProperties = reader.readCompressedInt();
+            for (int i = 0; i < numProperties && reader.isOk(); ++i)
+            {
+                const auto name = reader.readString();
+                auto propertyValue = reader.readVar();
+                if (depth == 0)
+                    state.values[name] = std::move (propertyValue);
+                else if (name == "id")
+                    id = std::move (propertyValue);
+                else if (name == "value")
+                    value = std::move (propertyValue);
+            }
+            if (depth == 1 && type == "PARAM" && ! id.empty() && ! value.empty())
+                state.values[id] = value;
+
+            const auto numChildren = reader.readCompressedInt();
+            for (int i = 0; i < numChildren && reader.isOk(); ++i)
+                readTree (reader, state, depth + 1);
+        }
+
+        // NormalisableRange<float>::snapToLegalValue()
+        float snap (const ParameterRange& range, float value)
+        {
+            value = range.start + range.interval * std::floor ((value - range.start) / range.interval + 0.5f);
+            return value <= range.start ? range.start : value >= range.end ? range.end : value;
+        }
+
+        // RangedAudioParameter's conversions, which snap on the way in and out
+        float to0to1 (const ParameterRange& range, float value)
+        {
+            return std::clamp ((snap (range, value) - range.start) / (range.end - range.start), 0.0f, 1.0f);
+        }
+
+        float from0to1 (const ParameterRange& range, float proportion)
+        {
+            return snap (range, range.start + (range.end - range.start) * std::clamp (proportion, 0.0f, 1.0f));
+        }
+
+        // what the parameter's raw value becomes once AudioProcessorValueTreeState loads
+        // the value: set through its normalised form, then read back through it
+        float toParameterValue (const ParameterRange& range, float value)
+        {
+            const auto stored = from0to1 (range, to0to1 (range, value));
+            return from0to1 (range, to0to1 (range, stored));
+        }
+
+        float getParameterValue (const PluginState& state, const ParameterRange& range)
+        {
+            const auto found = state.values.find (range.id);
+            if (found == state.values.end())
+                return range.defaultValue;
+            if (const auto number = toNumber (found->second))
+                return toParameterValue (range, static_cast<float> (*number));
+            for (size_t i = 0; i < range.choices.size(); ++i)
+                if (equalsIgnoringCase (found->second, range.choices[i]))
+                    return static_cast<float> (i);
+            return range.defaultValue;
+        }
+
+        std::string getProperty (const PluginState& state, const char* name)
+        {
+            const auto found = state.values.find (name);
+            return found != state.values.end() ? found->second : std::string();
+        }
+
+        // getOversamplingFactor() in PluginProcessor.cpp
+        int getOversamplingFactor (const std::string& value)
+        {
+            const auto factor = static_cast<int> (toNumber (value).value_or (1.0));
+            return factor >= 1 && factor <= 8 && (factor & (factor - 1)) == 0 ? factor : 1;
+        }
+    } // namespace
+
+    bool loadPluginState (const std::string& path, PluginState& state, std::string& error)
+    {
+        std::ifstream file (path, std::ios::binary);
+        if (! file)
+        {
+            error = "can't open " + path;
+            return false;
+        }
+        const std::string contents ((std::istreambuf_iterator<char> (file)), std::istreambuf_iterator<char>());
+
+        // the blob starts with the tree's type
+        constexpr char kBlobStart[] = "parameters";
+        const auto ok = contents.compare (0, sizeof (kBlobStart), kBlobStart, sizeof (kBlobStart)) == 0
+                            ? parseStateBlob (reinterpret_cast<const uint8_t*> (contents.data()), contents.size(), state, error)
+                            : parsePreset (contents, state, error);
+        if (! ok)
+            error = path + ": " + error;
+        return ok;
+    }
+
+    bool parseStateBlob (const uint8_t* data, size_t size, PluginState& state, std::string& error)
+    {
+        TreeReader reader (data, size);
+        readTree (reader, state, 0);
+        if (! reader.isOk())
+        {
+            error = "truncated or not a Tonix state";
+            return false;
+        }
+        return true;
+    }
+
+    bool parsePreset (const std::string& text, PluginState& state, std::string& error)
+    {
+        size_t start = 0;
+        for (int line = 1; start < text.size(); ++line)
+        {
+            auto end = text.find ('\n', start);
+            if (end == std::string::npos)
+                end = text.size();
+            auto content = text.substr (start, end - start);
+            start = end + 1;
+
+            content = trim (content.substr (0, content.find ('#')));
+            if (content.empty())
+                continue;
+            if (! setPluginValue (state, content, error))
+            {
+                error = "line " + std::to_string (line) + ": " + error;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool setPluginValue (PluginState& state, const std::string& assignment, std::string& error)
+    {
+        const auto equals = assignment.find ('=');
+        if (equals == std::string::npos)
+        {
+            error = "expected name = value in \"" + assignment + "\"";
+            return false;
+        }
+        const auto name = trim (assignment.substr (0, equals));
+        if (! isKnown (name))
+        {
+            error = "unknown setting \"" + name + "\"";
+            return false;
+        }
+        state.values[name] = trim (assignment.substr (equals + 1));
+        return true;
+    }
+
+    std::vector<std::pair<tonix_param, double>> getRenderParameters (const PluginState& state)
+    {
+        std::vector<std::pair<tonix_param, double>> parameters;
+        for (size_t i = 0; i < std::size (kParameters); ++i)
+            parameters.emplace_back (kParameterIndices[i], getParameterValue (state, kParameters[i]));
+
+        // as TonixProcessor::getEngineSettings() reads them
+        const auto internalRate = getProperty (state, "internalRate");
+        parameters.emplace_back (TONIX_PARAM_PRECISION, getProperty (state, "precision") == "float" ? 1.0 : 0.0);
+        parameters.emplace_back (TONIX_PARAM_ANTIALIASING, getProperty (state, "antialiasing") == "adaa" ? 1.0 : 0.0);
+        parameters.emplace_back (TONIX_PARAM_SATURATOR_TIER, getProperty (state, "saturator") == "table" ? 1.0 : 0.0);
+        parameters.emplace_back (TONIX_PARAM_OVERSAMPLING, getOversamplingFactor (getProperty (state, "offlineOversampling")));
+        parameters.emplace_back (TONIX_PARAM_OVERSAMPLING_PHASE, getProperty (state, "oversamplingPhase") == "minimum" ? 1.0 : 0.0);
+        parameters.emplace_back (TONIX_PARAM_INTERNAL_RATE, internalRate == "single" ? 1.0 : internalRate == "double" ? 2.0 : 0.0);
+        parameters.emplace_back (TONIX_PARAM_MULTICORE, 0.0);
+        return parameters;
+    }
+} // namespace tonix::tools
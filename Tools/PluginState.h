@@ -0,0 +1,35 @@
+#pragma once
+
+#include "tonix.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace tonix::tools
+{
+    // The plugin's settings by the names it stores them under: the parameter ids, such
+    // as "process" or "type", and the engine settings, such as "precision" or
+    // "offlineOversampling". Values are text, like a juce::var turned into a string.
+    struct PluginState
+    {
+        std::map<std::string, std::string> values;
+    };
+
+    // the state blob getStateInformation() writes, or a preset of "name = value" lines
+    // with # comments; a preset may only name settings the plugin has
+    bool loadPluginState (const std::string& path, PluginState&, std::string& error);
+    bool parseStateBlob (const uint8_t* data, size_t size, PluginState&, std::string& error);
+    bool parsePreset (const std::string& text, PluginState&, std::string& error);
+    // one "name=value", such as a command line override
+    bool setPluginValue (PluginState&, const std::string& assignment, std::string& error);
+
+    // The C interface's parameters for the plugin with this state rendering offline: its
+    // offline oversampling, no CPU governor, and parameter values rounded the way its
+    // parameters hold them once the state is loaded, so the render matches sample for
+    // sample. Multicore is off, one render doesn't need more than a core.
+    std::vector<std::pair<tonix_param, double>> getRenderParameters (const PluginState&);
+} // namespace tonix::tools
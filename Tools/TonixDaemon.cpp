@@ -0,0 +1,394 @@
+// Hosts Tonix engines for other processes, which reach them through shared memory (see
+// DaemonProtocol.h and DaemonClient.h). A crash on either side stays on that side: the
+// daemon drops the instances of clients that are gone, and clients fail their calls when
+// the daemon is gone.
+//
+//   TonixDaemon [--name NAME] [--workers N]
+//
+// Each instance belongs to one worker thread, the one with the fewest when it opens, and
+// a worker processes whatever its instances have queued in one pass before it polls for
+// a while and then sleeps on its doorbell. Linux only.
+
+#include "DaemonProtocol.h"
+#include "tonix.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace tonix::daemon;
+
+namespace
+{
+    // how often the control thread looks for clients that are gone
+    constexpr int kControlWaitMs = 200;
+
+    std::atomic<bool> g_stop { false };
+
+    void stop (int)
+    {
+        g_stop.store (true);
+    }
+
+    struct Instance
+    {
+        int slot { -1 };
+        InstanceHeader* header { nullptr };
+        size_t size { 0 };
+        tonix::api::Processor processor;
+        uint32_t paramsVersion { 0 };
+        uint32_t processed { 0 };
+        // checked in open(), the header's own fields are the client's to change
+        Geometry geometry {};
+        // for each ring entry, its header and channels in this process
+        std::vector<BlockHeader*> blocks;
+        std::vector<std::vector<float*>> channels;
+
+        ~Instance()
+        {
+            if (header != nullptr)
+                munmap (header, size);
+        }
+
+        // processes what the client has queued, false if there was nothing
+        bool process()
+        {
+            auto& h = *header;
+            const auto requested = h.requestHead.load (std::memory_order_acquire);
+            if (requested == processed)
+                return false;
+
+            const auto version = h.paramsVersion.load (std::memory_order_acquire);
+            if (version != paramsVersion)
+            {
+                paramsVersion = version;
+                applyParameters();
+            }
+            // a client can't have more than the ring in flight, one that claims to is broken
+            const auto ringSize = static_cast<uint32_t> (geometry.ringSize);
+            for (auto n = std::min (requested - processed, ringSize); n > 0; --n)
+            {
+                const auto index = processed % ringSize;
+                // read once, the client may be writing it
+                const auto claimed = std::atomic_ref<int32_t> (blocks[index]->numFrames).load (std::memory_order_relaxed);
+                const auto numFrames = std::clamp (claimed, 0, geometry.maxBlockSize);
+                processor.process (channels[index].data(), geometry.numChannels, numFrames);
+                h.responseHead.store (++processed, std::memory_order_release);
+                if (h.clientWaiting.load() != 0)
+                    futexWake (h.responseHead);
+            }
+            return true;
+        }
+
+        void applyParameters()
+        {
+            // unset ones are NaN, which the engine turns down
+            for (int p = 0; p < TONIX_NUM_PARAMS; ++p)
+                tonix_set_param (processor.getHandle(), static_cast<tonix_param> (p), header->params[p].load (std::memory_order_relaxed));
+        }
+    };
+
+    struct Worker
+    {
+        Doorbell* doorbell { nullptr };
+        std::mutex lock;
+        std::vector<std::shared_ptr<Instance>> instances;
+        std::thread thread;
+
+        void run()
+        {
+            while (! g_stop.load (std::memory_order_relaxed))
+            {
+                const auto seen = doorbell->count.load (std::memory_order_acquire);
+                bool busy = false;
+                {
+                    const std::lock_guard guard (lock);
+                    for (auto& instance : instances)
+                        busy = instance->process() || busy;
+                }
+                if (busy)
+                    continue;
+
+                for (int i = 0; i < getSpinIterations() && doorbell->count.load (std::memory_order_acquire) == seen; ++i)
+                    cpuPause();
+                if (doorbell->count.load (std::memory_order_acquire) != seen)
+                    continue;
+                // a client rings after publishing its block, and wakes us if the flag is up
+                doorbell->sleeping.store (1);
+                if (doorbell->count.load() == seen)
+                    futexWait (doorbell->count, seen, kControlWaitMs);
+                doorbell->sleeping.store (0);
+            }
+        }
+    };
+
+    class Daemon
+    {
+    public:
+        bool start (const char* name, int numWorkers)
+        {
+            m_name = name;
+            // a registry left by a daemon that died is taken over
+            if (auto* existing = map (O_RDWR); existing != nullptr)
+            {
+                const auto running = existing->magic == kRegistryMagic && isProcessAlive (existing->daemonPid);
+                munmap (existing, sizeof (Registry));
+                if (running)
+                {
+                    std::fprintf (stderr, "a daemon is already running as %s\n", name);
+                    return false;
+                }
+            }
+            shm_unlink (name);
+            m_registry = map (O_RDWR | O_CREAT | O_EXCL);
+            if (m_registry == nullptr)
+            {
+                std::fprintf (stderr, "can't create %s\n", name);
+                return false;
+            }
+            new (m_registry) Registry {};
+            m_registry->version = kProtocolVersion;
+            m_registry->daemonPid = static_cast<int32_t> (getpid());
+            m_registry->numWorkers = numWorkers;
+
+            m_workers.resize (static_cast<size_t> (numWorkers));
+            for (int w = 0; w < numWorkers; ++w)
+            {
+                auto& worker = m_workers[static_cast<size_t> (w)];
+                worker = std::make_unique<Worker>();
+                worker->doorbell = &m_registry->workers[w];
+                worker->thread = std::thread ([&worker = *worker]
+                                              { worker.run(); });
+            }
+            // clients check it before anything else
+            std::atomic_thread_fence (std::memory_order_release);
+            m_registry->magic = kRegistryMagic;
+            return true;
+        }
+
+        void run()
+        {
+            while (! g_stop.load())
+            {
+                const auto seen = m_registry->control.count.load();
+                for (int s = 0; s < kMaxInstances; ++s)
+                    updateSlot (s);
+                m_registry->control.sleeping.store (1);
+                if (m_registry->control.count.load() == seen)
+                    futexWait (m_registry->control.count, seen, kControlWaitMs);
+                m_registry->control.sleeping.store (0);
+            }
+        }
+
+        ~Daemon()
+        {
+            g_stop.store (true);
+            for (auto& worker : m_workers)
+            {
+                ring (*worker->doorbell);
+                worker->thread.join();
+            }
+            m_workers.clear();
+            m_instances.clear();
+            if (m_registry != nullptr)
+            {
+                m_registry->magic = 0;
+                munmap (m_registry, sizeof (Registry));
+                shm_unlink (m_name);
+            }
+        }
+
+    private:
+        Registry* map (int flags)
+        {
+            const auto fd = shm_open (m_name, flags, 0600);
+            if (fd < 0)
+                return nullptr;
+            if ((flags & O_CREAT) != 0 && ftruncate (fd, sizeof (Registry)) != 0)
+            {
+                ::close (fd);
+                return nullptr;
+            }
+            auto* data = mmap (nullptr, sizeof (Registry), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            ::close (fd);
+            return data != MAP_FAILED ? static_cast<Registry*> (data) : nullptr;
+        }
+
+        void updateSlot (int s)
+        {
+            auto& slot = m_registry->slots[s];
+            const auto state = slot.state.load (std::memory_order_acquire);
+            auto& instance = m_instances[static_cast<size_t> (s)];
+            if (state == Opening && isProcessAlive (slot.pid))
+            {
+                open (s);
+            }
+            // a claimed slot's pid may not be written yet
+            else if (state == Closing || ((state == Opening || state == Active) && ! isProcessAlive (slot.pid)))
+            {
+                if (instance != nullptr)
+                    close (s);
+                slot.state.store (Free, std::memory_order_release);
+            }
+        }
+
+        void open (int s)
+        {
+            auto& slot = m_registry->slots[s];
+            // unless the client gave up in the meantime
+            auto expected = static_cast<uint32_t> (Opening);
+            if (! slot.state.compare_exchange_strong (expected, Active))
+                return;
+
+            // the client's memfd; one that could still shrink would fault the worker past
+            // its end and take the daemon down with it
+            char path[64];
+            std::snprintf (path, sizeof (path), "/proc/%d/fd/%d", static_cast<int> (slot.pid), static_cast<int> (slot.fd));
+            const auto fd = ::open (path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+            struct stat info;
+            if (fd < 0 || fstat (fd, &info) != 0 || ! S_ISREG (info.st_mode) || (fcntl (fd, F_GET_SEALS) & kSegmentSeals) != kSegmentSeals
+                || static_cast<size_t> (info.st_size) < sizeof (InstanceHeader))
+            {
+                if (fd >= 0)
+                    ::close (fd);
+                // nothing to report to, the client times out
+                slot.state.store (Free, std::memory_order_release);
+                return;
+            }
+            auto instance = std::make_shared<Instance>();
+            instance->slot = s;
+            instance->size = static_cast<size_t> (info.st_size);
+            auto* data = mmap (nullptr, instance->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            ::close (fd);
+            if (data == MAP_FAILED)
+            {
+                slot.state.store (Free, std::memory_order_release);
+                return;
+            }
+            instance->header = static_cast<InstanceHeader*> (data);
+            auto& header = *instance->header;
+
+            const auto fail = [&] (tonix_result error)
+            {
+                header.error = error;
+                header.status.store (Failed, std::memory_order_release);
+                futexWake (header.status);
+            };
+            instance->geometry = getGeometry (header);
+            const auto& geometry = instance->geometry;
+            if (header.magic != kInstanceMagic || header.version != kProtocolVersion || geometry.numChannels <= 0 || geometry.numChannels > kMaxChannels
+                || geometry.maxBlockSize <= 0 || geometry.maxBlockSize > kMaxBlockSize || geometry.ringSize <= 0 || geometry.ringSize > kMaxRingSize
+                || instance->size < getSegmentSize (geometry.numChannels, geometry.maxBlockSize, geometry.ringSize))
+            {
+                fail (TONIX_ERROR_INVALID_ARGUMENT);
+                return;
+            }
+
+            instance->paramsVersion = header.paramsVersion.load (std::memory_order_acquire);
+            instance->applyParameters();
+            try
+            {
+                instance->processor.prepare (geometry.numChannels, header.sampleRate, geometry.maxBlockSize);
+            }
+            catch (const std::bad_alloc&)
+            {
+                fail (TONIX_ERROR_OUT_OF_MEMORY);
+                return;
+            }
+            catch (const std::exception&)
+            {
+                fail (TONIX_ERROR_INVALID_ARGUMENT);
+                return;
+            }
+            instance->channels.resize (static_cast<size_t> (geometry.ringSize));
+            for (uint32_t i = 0; i < static_cast<uint32_t> (geometry.ringSize); ++i)
+            {
+                instance->blocks.push_back (getBlock (header, geometry, i));
+                for (int ch = 0; ch < geometry.numChannels; ++ch)
+                    instance->channels[i].push_back (getChannel (header, geometry, i, ch));
+            }
+
+            auto& worker = **std::min_element (m_workers.begin(), m_workers.end(), [] (const auto& a, const auto& b)
+                                               { return a->instances.size() < b->instances.size(); });
+            header.worker = static_cast<int32_t> (worker.doorbell - m_registry->workers);
+            header.latency = instance->processor.getLatency();
+            header.tailLength = instance->processor.getTailLength();
+            {
+                const std::lock_guard guard (worker.lock);
+                worker.instances.push_back (instance);
+            }
+            m_instances[static_cast<size_t> (s)] = instance;
+            header.status.store (Ready, std::memory_order_release);
+            futexWake (header.status);
+        }
+
+        void close (int s)
+        {
+            auto& instance = m_instances[static_cast<size_t> (s)];
+            for (auto& worker : m_workers)
+            {
+                const std::lock_guard guard (worker->lock);
+                std::erase (worker->instances, instance);
+            }
+            instance.reset();
+        }
+
+        const char* m_name { nullptr };
+        Registry* m_registry { nullptr };
+        std::vector<std::unique_ptr<Worker>> m_workers;
+        // by slot
+        std::vector<std::shared_ptr<Instance>> m_instances = std::vector<std::shared_ptr<Instance>> (kMaxInstances);
+    };
+
+    // the whole argument, a whole number within [min, max], or nothing
+    bool parseInteger (const char* text, int min, int max, int& value)
+    {
+        char* end = nullptr;
+        const auto number = std::strtod (text, &end);
+        if (end == text || *end != '\0' || ! (number >= min && number <= max) || number != std::floor (number))
+            return false;
+        value = static_cast<int> (number);
+        return true;
+    }
+} // namespace
+
+int main (int argc, char** argv)
+{
+    const char* name = kDefaultName;
+    auto numWorkers = std::clamp (static_cast<int> (std::thread::hardware_concurrency()), 1, kMaxWorkers);
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp (argv[i], "--name") == 0 && i + 1 < argc)
+            name = argv[++i];
+        else if (std::strcmp (argv[i], "--workers") == 0 && i + 1 < argc && parseInteger (argv[i + 1], 1, kMaxWorkers, numWorkers))
+            ++i;
+        else
+        {
+            std::fprintf (stderr, "usage: TonixDaemon [--name NAME] [--workers 1-%d]\n", kMaxWorkers);
+            return 2;
+        }
+    }
+
+    std::signal (SIGINT, stop);
+    std::signal (SIGTERM, stop);
+    Daemon daemon;
+    if (! daemon.start (name, numWorkers))
+        return 1;
+    std::printf ("serving as %s with %d workers\n", name, numWorkers);
+    std::fflush (stdout);
+    daemon.run();
+    return 0;
+}
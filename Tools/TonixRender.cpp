@@ -0,0 +1,306 @@
+// Renders audio files through Tonix without a host, one file per thread, and reports how
+// many times faster than realtime that went.
+//
+//   TonixRender -o DIR [--state FILE] [--set NAME=VALUE]... [--jobs N] [--block N]
+//               [--tail] [--keep-latency] [--raw-channels N] [--raw-rate HZ]
+//               FILE_OR_DIRECTORY...
+//
+// Reads WAV, RF64, AIFF and AIFC, and .raw files of interleaved little-endian 32-bit
+// float (2 channels at 48 kHz unless --raw-channels and --raw-rate say otherwise).
+// Writes 32-bit float WAV, or raw float for raw input, to DIR under the same name.
+//
+// --state takes the plugin's saved state or a preset of "name = value" lines, both with
+// the names the plugin stores: inputTrim, process, outputTrim, brightness, type, bypass,
+// autoGain, precision, antialiasing, saturator, offlineOversampling, oversamplingPhase
+// and internalRate. --set overrides one of them after that.
+//
+// The output matches the plugin bouncing the file in a host with the same settings and
+// a --block host block size (silence detection works on whole blocks): the latency is
+// compensated the way the host would, --keep-latency leaves it in, and --tail renders
+// the tail past the end of the input.
+
+#include "AudioFile.h"
+#include "PluginState.h"
+#include "tonix.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace tonix::tools;
+namespace fs = std::filesystem;
+
+namespace
+{
+    // frames read, processed and written at a time, rounded to whole blocks
+    constexpr int kChunkFrames = 1 << 16;
+
+    struct Options
+    {
+        fs::path outputDirectory;
+        PluginState state;
+        int numJobs { std::max (1, static_cast<int> (std::thread::hardware_concurrency())) };
+        int blockSize { 512 };
+        bool tail { false };
+        bool keepLatency { false };
+        AudioFormat rawFormat;
+        std::vector<fs::path> inputs;
+    };
+
+    bool isAudioFile (const fs::path& path)
+    {
+        auto extension = path.extension().string();
+        std::transform (extension.begin(), extension.end(), extension.begin(), [] (unsigned char c)
+                        { return static_cast<char> (std::tolower (c)); });
+        return extension == ".wav" || extension == ".aif" || extension == ".aiff" || extension == ".aifc" || extension == ".raw";
+    }
+
+    bool isRaw (const fs::path& path)
+    {
+        return path.extension() == ".raw" || path.extension() == ".RAW";
+    }
+
+    // the whole argument within [min, max] or nothing; a typo such as 44.1k must not
+    // render files at some other setting
+    bool parseNumber (const char* text, double min, double max, double& value)
+    {
+        char* end = nullptr;
+        value = std::strtod (text, &end);
+        return end != text && *end == '\0' && value >= min && value <= max;
+    }
+
+    bool parseInteger (const char* text, int min, int max, int& value)
+    {
+        double number;
+        if (! parseNumber (text, min, max, number) || number != std::floor (number))
+            return false;
+        value = static_cast<int> (number);
+        return true;
+    }
+
+    bool parseOptions (int argc, char** argv, Options& options)
+    {
+        std::string error;
+        for (int i = 1; i < argc; ++i)
+        {
+            const auto isOption = [&] (const char* name)
+            {
+                return std::strcmp (argv[i], name) == 0;
+            };
+            if (isOption ("--tail"))
+                options.tail = true;
+            else if (isOption ("--keep-latency"))
+                options.keepLatency = true;
+            else if (argv[i][0] == '-' && i + 1 >= argc)
+            {
+                std::fprintf (stderr, "missing value for %s\n", argv[i]);
+                return false;
+            }
+            else if (isOption ("-o") || isOption ("--output"))
+                options.outputDirectory = argv[++i];
+            else if (isOption ("--state"))
+            {
+                if (! loadPluginState (argv[++i], options.state, error))
+                {
+                    std::fprintf (stderr, "%s\n", error.c_str());
+                    return false;
+                }
+            }
+            else if (isOption ("--set"))
+            {
+                if (! setPluginValue (options.state, argv[++i], error))
+                {
+                    std::fprintf (stderr, "%s\n", error.c_str());
+                    return false;
+                }
+            }
+            else if (isOption ("--jobs") || isOption ("--block") || isOption ("--raw-channels") || isOption ("--raw-rate"))
+            {
+                const auto* name = argv[i];
+                const auto* text = argv[++i];
+                bool valid;
+                if (std::strcmp (name, "--jobs") == 0)
+                    valid = parseInteger (text, 1, 1024, options.numJobs);
+                else if (std::strcmp (name, "--block") == 0)
+                    valid = parseInteger (text, 1, 1 << 16, options.blockSize);
+                else if (std::strcmp (name, "--raw-channels") == 0)
+                    valid = parseInteger (text, 1, 1024, options.rawFormat.numChannels);
+                else
+                    valid = parseNumber (text, 1000.0, 1.0e6, options.rawFormat.sampleRate);
+                if (! valid)
+                {
+                    std::fprintf (stderr, "bad value %s for %s\n", text, name);
+                    return false;
+                }
+            }
+            else if (argv[i][0] == '-')
+            {
+                std::fprintf (stderr, "unknown option %s\n", argv[i]);
+                return false;
+            }
+            else if (fs::is_directory (argv[i]))
+            {
+                for (const auto& entry : fs::directory_iterator (argv[i]))
+                    if (entry.is_regular_file() && isAudioFile (entry.path()))
+                        options.inputs.push_back (entry.path());
+            }
+            else
+                options.inputs.emplace_back (argv[i]);
+        }
+        if (options.outputDirectory.empty() || options.inputs.empty())
+        {
+            std::fprintf (stderr, "usage: TonixRender -o DIR [--state FILE] [--set NAME=VALUE]... [--jobs N] [--block N] [--tail] [--keep-latency] [--raw-channels N] [--raw-rate HZ] FILE_OR_DIRECTORY...\n");
+            return false;
+        }
+        return true;
+    }
+
+    struct Result
+    {
+        double audioSeconds { 0.0 };
+        double renderSeconds { 0.0 };
+        std::string error;
+    };
+
+    Result render (const fs::path& input, const Options& options)
+    {
+        using Clock = std::chrono::steady_clock;
+        const auto start = Clock::now();
+        Result result;
+        const auto raw = isRaw (input);
+
+        AudioFileReader reader;
+        if (! reader.open (input.string(), raw ? &options.rawFormat : nullptr, result.error))
+            return result;
+        const auto& format = reader.getFormat();
+        const auto numChannels = format.numChannels;
+
+        tonix::api::Processor processor;
+        for (const auto& [param, value] : getRenderParameters (options.state))
+            processor.setParameter (static_cast<tonix::api::Parameter> (param), value);
+        processor.prepare (numChannels, format.sampleRate, options.blockSize);
+
+        // the host's latency compensation drops the first output samples and runs on
+        // into silence for as long
+        const auto latency = options.keepLatency ? int64_t (0) : static_cast<int64_t> (std::lround (processor.getLatency()));
+        const auto tail = options.tail ? std::max (int64_t (0), static_cast<int64_t> (std::ceil (processor.getTailLength())) - latency) : int64_t (0);
+        const auto numInputFrames = reader.getNumFrames();
+        const auto numOutputFrames = numInputFrames + tail;
+        const auto numFrames = latency + numOutputFrames;
+
+        AudioFileWriter writer;
+        const auto output = options.outputDirectory / (raw ? input.filename() : fs::path (input.filename()).replace_extension (".wav"));
+        // the input is still mapped
+        std::error_code error;
+        if (fs::equivalent (input, output, error))
+        {
+            result.error = output.string() + ": would overwrite the input";
+            return result;
+        }
+        if (! writer.open (output.string(), numChannels, format.sampleRate, raw, result.error))
+            return result;
+
+        const auto chunkFrames = std::max (1, kChunkFrames / options.blockSize) * options.blockSize;
+        std::vector<std::vector<float>> buffers (static_cast<size_t> (numChannels), std::vector<float> (static_cast<size_t> (chunkFrames)));
+        std::vector<float*> channels (buffers.size());
+        std::vector<float*> block (buffers.size());
+        for (size_t ch = 0; ch < buffers.size(); ++ch)
+            channels[ch] = buffers[ch].data();
+
+        for (int64_t position = 0; position < numFrames; position += chunkFrames)
+        {
+            const auto n = static_cast<int> (std::min<int64_t> (chunkFrames, numFrames - position));
+            const auto numRead = static_cast<int> (std::clamp<int64_t> (numInputFrames - position, 0, n));
+            reader.read (position, numRead, channels.data());
+            for (auto& buffer : buffers)
+                std::fill (buffer.begin() + numRead, buffer.begin() + n, 0.0f);
+
+            for (int offset = 0; offset < n; offset += options.blockSize)
+            {
+                for (size_t ch = 0; ch < block.size(); ++ch)
+                    block[ch] = channels[ch] + offset;
+                processor.process (block.data(), numChannels, std::min (options.blockSize, n - offset));
+            }
+
+            const auto skip = static_cast<int> (std::clamp<int64_t> (latency - position, 0, n));
+            for (size_t ch = 0; ch < block.size(); ++ch)
+                block[ch] = channels[ch] + skip;
+            if (! writer.write (block.data(), n - skip))
+                break;
+        }
+        if (! writer.close())
+        {
+            result.error = "can't write " + output.string();
+            return result;
+        }
+
+        result.audioSeconds = static_cast<double> (numOutputFrames) / format.sampleRate;
+        result.renderSeconds = std::chrono::duration<double> (Clock::now() - start).count();
+        return result;
+    }
+} // namespace
+
+int main (int argc, char** argv)
+{
+    Options options;
+    if (! parseOptions (argc, argv, options))
+        return 2;
+    std::error_code error;
+    fs::create_directories (options.outputDirectory, error);
+
+    // a file per thread; each render runs on one core, so the files spread over all of them
+    const auto numJobs = std::min (options.numJobs, static_cast<int> (options.inputs.size()));
+    std::atomic<size_t> next { 0 };
+    std::atomic<int> failures { 0 };
+    std::mutex printMutex;
+    double totalAudioSeconds = 0.0;
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int j = 0; j < numJobs; ++j)
+    {
+        threads.emplace_back ([&]
+                              {
+                                  for (auto i = next++; i < options.inputs.size(); i = next++)
+                                  {
+                                      const auto& input = options.inputs[i];
+                                      Result result;
+                                      try
+                                      {
+                                          result = render (input, options);
+                                      }
+                                      catch (const std::exception& e)
+                                      {
+                                          result.error = input.string() + ": " + e.what();
+                                      }
+
+                                      const std::lock_guard lock (printMutex);
+                                      if (! result.error.empty())
+                                      {
+                                          std::fprintf (stderr, "%s\n", result.error.c_str());
+                                          ++failures;
+                                          continue;
+                                      }
+                                      totalAudioSeconds += result.audioSeconds;
+                                      std::printf ("%s: %.1f s in %.2f s, %.1fx realtime\n", input.filename().string().c_str(), result.audioSeconds, result.renderSeconds, result.audioSeconds / result.renderSeconds);
+                                  }
+                              });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    const auto wallSeconds = std::chrono::duration<double> (std::chrono::steady_clock::now() - start).count();
+
+    const auto numRendered = static_cast<int> (options.inputs.size()) - failures.load();
+    std::printf ("%d files, %.1f s of audio in %.2f s on %d threads: %.1fx realtime, %.1fx per thread\n", numRendered, totalAudioSeconds, wallSeconds, numJobs, totalAudioSeconds / wallSeconds, totalAudioSeconds / wallSeconds / numJobs);
+    return failures.load() == 0 ? 0 : 1;
+}